@@ -5,21 +5,64 @@
 #include <sys/shm.h>
 #include <sys/wait.h>
 #include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 #include <string.h>
+#include <stdint.h>
+#include <sched.h>
 
 #include "sharedMemoryWrapper.h"
 #include "semWrapper.h"
 #include "shmem.h"
+#include "sortingNetwork.h"
 
 /* Utility Macros */
 #define ASSERT(condition, msg) { if(!(condition)) { printf("Assert Failed: %s\n", msg); exit(1); } }
 #define DPRINTF(args...) { if(debug_mode) { printf(args); } }
 
-/* Constants and enums */
-const int TOTAL_SEM = 2;
-const int TOTAL_PROCESSES = 3;
-enum PROCESS_IDX { P1, P2, P3 }; // 0, 1, 2
-enum MUTEX { LEFT_WRITE, RIGHT_WRITE };  // 0, 1, 2
+/* Constants */
+#define MAX_PRINT 64                // Longest array printed in full
+#define BUBBLE_COMPARE_MAX 4096     // Longest array bubble sort is timed on with -c
+#define MAX_WIDTH 8                 // Widest integer key, in bytes
+#define MAX_BARRIERS (2 * MAX_WIDTH + 3)    // Barriers used by a run, two per radix pass and the three below
+#define BARRIER_FAULTED (MAX_BARRIERS - 3)  // Every worker faulted in its chunks, see fault_in_chunk
+#define BARRIER_READ (MAX_BARRIERS - 2)     // External sort: every worker read its chunk of the run
+#define BARRIER_SORTED (MAX_BARRIERS - 1)   // External sort: the run is sorted
+#define MEMORY_POSIX 1                  // Memory option: POSIX (memfd) shared memory instead of SysV
+#define MEMORY_HUGE 2                   // Memory option: huge pages, see setup_sort
+#define MEMORY_PREFAULT 4               // Memory option: fault all pages in, at setup or by each worker
+#define DEFAULT_RUN_MB 64               // External sort run size unless set with -r, the shared memory holds two
+#define MERGE_BUFFER (1 << 20)          // External sort read buffer per run
+#define MERGE_FAN_IN 64                 // Runs merged at once (MERGE_FAN_IN read buffers), more take several passes
+#define OUTPUT_BUFFER (4 << 20)         // External sort write buffer
+#define NETWORK_BLOCKS (1 << 14)        // Blocks sorted per measurement with -k
+#define NETWORK_REPEATS 16              // Measurements per kernel with -k
+#define QUICK_GRAIN 4096                // Ranges quick sort shares no further
+#define IN_TRANSIT 0                // Held by a shared element while its letter moves, see sort_lock_free
+
+/* Sorting Algorithms */
+typedef enum { 
+    MODE_BUBBLE,    // Bubble sort over overlapping ranges
+    MODE_SAMPLE,    // Sample sort over disjoint chunks
+    MODE_COUNTING,  // Counting sort of the letters
+    MODE_RADIX,     // LSD radix sort, a counting pass per key byte
+    MODE_QUICK      // Quicksort of ranges balanced by work stealing
+} sort_mode;
+const char* mode_names[] = { "bubble", "sample", "counting", "radix", "quick" };
+
+/* Page Sizes */
+enum { PAGES_DEFAULT, PAGES_THP, PAGES_HUGETLB };
+const char* page_names[] = { "default", "transparent huge (advised)", "huge (hugetlb)" };
+
+// Measurements of a sort, see run_sort
+typedef struct {
+    double cpu;             // CPU time of the workers, in seconds
+    long faults;            // Page faults of the workers
+    long long tlb_misses;   // dTLB load misses of the workers, -1 if not measurable
+} run_stats;
 
 /**
  * @brief Prompts the user to select the 
@@ -45,6 +88,37 @@ void debug_prompt(void) {
     }
 }
 
+/**
+ * @brief Prints the usage of the program.
+ * @param[in] program char*, the program name.
+ */
+void usage(const char* program)
+{
+    printf("Usage: %s [-n elements [-s seed] [-d] [-w bytes] [-z]] [-p processes] [-m bubble|sample|counting|radix|quick] [-t spin] [-a] [-b processes|threads] [-M sysv|posix] [-H] [-f populate|touch] [-v isa] [-c]\n"
+        "       %s -k [-s seed] [-v isa]\n"
+        "       %s -i input -o output [-n bytes [-s seed]] [-r MB] [-p processes] [-m sample|counting|radix|quick] [-b ...] [-M ...] [-H] [-f ...]\n"
+        "  -n elements   sort this many random letters instead of prompting for %d\n"
+        "  -s seed       seed for the random letters (default 1)\n"
+        "  -d            run in debug mode without prompting\n"
+        "  -z            skew the random letters: letter k is drawn with frequency 1 / k^2 (a ~ 61%%)\n"
+        "  -p processes  sorting processes, at most elements - 1 (default %d)\n"
+        "  -w bytes      with -m radix, sort random unsigned integer keys of 2, 4 or 8 bytes\n"
+        "  -m algorithm  bubble sort (default), sample sort, counting sort, radix sort or quicksort\n"
+        "                balanced by work stealing\n"
+        "  -t spin       bubble sort ends by spinning on the valid flags instead of in rounds\n"
+        "  -a            bubble sort exchanges shared elements with atomics instead of semaphores\n"
+        "  -b backend    workers are forked processes over SysV shared memory (default) or threads\n"
+        "  -M memory     processes share SysV (default) or POSIX (memfd + mmap) shared memory\n"
+        "  -H            back the memory with huge pages (hugetlb, else transparent huge pages)\n"
+        "  -f prefault   fault the memory in before sorting (populate) or each worker writes its chunk first (touch)\n"
+        "  -v isa        sorting network instructions: scalar, sse4.1 or avx2 (default: best supported)\n"
+        "  -k            time the sorting networks against insertion sort and qsort on small blocks\n"
+        "  -c            also time the other algorithm, the other backend and single-process qsort\n"
+        "  -i input      external sort: sort the bytes of input in runs of -r MB (default %d) into output,\n"
+        "                with -m sample (default), counting, radix or quick sort. -n first writes that many random letters to input\n", 
+        program, program, program, SIZE, DEFAULT_PROCESSES, DEFAULT_RUN_MB);
+}
+
 /**
  * @brief Waits for num_processes processes to terminate.
  * @param[in] num_process int, the number of processes to wait for.
@@ -66,14 +140,14 @@ void wait_n_children(int num_process)
  * @brief Prompts the users to enter n characters
  * to initialize the first n elements of arr.
  * @param[in] arr char*, the array.
- * @param[in] n int, the number of cells to initialize.
+ * @param[in] n size_t, the number of cells to initialize.
  */ 
-void init_array(char* arr, int n)
+void init_array(char* arr, size_t n)
 {
     /* Precondition: Assumes 1 char inputs */
-    printf("Please enter %d letters to sort: \n", n);
+    printf("Please enter %zu letters to sort: \n", n);
     
-    for (int i = 0; i < n; i++)
+    for (size_t i = 0; i < n; i++)
     {
         arr[i] = 0;
         bool ischar = isalpha(arr[i]);
@@ -82,37 +156,263 @@ void init_array(char* arr, int n)
         // it's a valid char.
         while (!ischar)
         {
-            printf("Character %d: ", i + 1);
+            printf("Character %zu: ", i + 1);
             scanf(" %c", &arr[i]);
 
             if (!(ischar = isalpha(arr[i])))
                 printf("\nPlease enter a valid character!\n");
         }
+
+        // Lowercased once here, before any process shares the array.
+        arr[i] = tolower(arr[i]);
+    }
+}
+
+/**
+ * @brief Initializes the first n elements of arr
+ * with random lowercase letters.
+ * @param[in] arr char*, the array.
+ * @param[in] n size_t, the number of cells to initialize.
+ * @param[in] seed unsigned int, the random seed.
+ */ 
+void random_array(char* arr, size_t n, unsigned int seed)
+{
+    srand(seed);
+    for (size_t i = 0; i < n; i++)
+    {
+        arr[i] = 'a' + rand() % 26;
+    }
+}
+
+/**
+ * @brief Initializes the first n elements of arr with random
+ * lowercase letters, letter k (a = 1) drawn with a frequency
+ * proportional to 1 / k^2 (Zipf).
+ * @param[in] arr char*, the array.
+ * @param[in] n size_t, the number of cells to initialize.
+ * @param[in] seed unsigned int, the random seed.
+ */ 
+void skewed_array(char* arr, size_t n, unsigned int seed)
+{
+    double cumulative[26], total = 0;
+    for (int k = 0; k < 26; k++)
+    {
+        total += 1.0 / ((k + 1) * (k + 1));
+        cumulative[k] = total;
+    }
+    srand(seed);
+    for (size_t i = 0; i < n; i++)
+    {
+        double draw = total * rand() / ((double)RAND_MAX + 1);
+        int k = 0;
+        while (k < 25 && cumulative[k] <= draw) k++;
+        arr[i] = 'a' + k;
+    }
+}
+
+/**
+ * @brief Returns element i of arr as an unsigned key.
+ * @param[in] arr char*, the array.
+ * @param[in] i size_t, the element index.
+ * @param[in] width int, the bytes per element: 1 (a letter), 2, 4 or 8.
+ * @returns uint64_t, the key.
+ */ 
+static inline uint64_t key_at(const char* arr, size_t i, int width)
+{
+    switch (width)
+    {
+        case 2: return ((const uint16_t *)arr)[i];
+        case 4: return ((const uint32_t *)arr)[i];
+        case 8: return ((const uint64_t *)arr)[i];
+        default: return (unsigned char)arr[i];
+    }
+}
+
+/**
+ * @brief Initializes the first n elements of arr
+ * with random unsigned integer keys.
+ * @param[in] arr char*, the array.
+ * @param[in] n size_t, the number of cells to initialize.
+ * @param[in] width int, the bytes per element: 2, 4 or 8.
+ * @param[in] seed unsigned int, the random seed.
+ */ 
+void random_keys(char* arr, size_t n, int width, unsigned int seed)
+{
+    srand(seed);
+    for (size_t i = 0; i < n; i++)
+    {
+        uint64_t key = ((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ rand();
+        switch (width)
+        {
+            case 2: ((uint16_t *)arr)[i] = key; break;
+            case 4: ((uint32_t *)arr)[i] = key; break;
+            default: ((uint64_t *)arr)[i] = key; break;
+        }
+    }
+}
+
+/**
+ * @brief Returns whether the first n elements of arr are sorted.
+ * @param[in] arr char*, the array.
+ * @param[in] n size_t, the number of elements to check.
+ * @param[in] width int, the bytes per element, see key_at.
+ * @returns true if sorted, false otherwise.
+ */ 
+bool is_sorted(const char* arr, size_t n, int width)
+{
+    for (size_t i = 1; i < n; i++)
+    {
+        if (key_at(arr, i, width) < key_at(arr, i - 1, width)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Gets the range of indices process_idx sorts. The array
+ * is split into num_processes contiguous ranges and each range
+ * shares its first element with the previous range and its
+ * last with the next one: [0, e1], [e1, e2], ..., [ek, size - 1].
+ * @param[in] shmem st_shmem*, the shared memory.
+ * @param[in] process_idx int, the process index.
+ * @param[out] start size_t*, stores the starting index.
+ * @param[out] end size_t*, stores the ending index, inclusive.
+ */ 
+void get_range(const st_shmem* shmem, int process_idx, size_t* start, size_t* end)
+{
+    size_t last = shmem->size - 1;
+    *start = last * process_idx / shmem->num_processes;
+    *end = last * (process_idx + 1) / shmem->num_processes;
+}
+
+/**
+ * @brief Gets the chunk of indices process_idx sorts in
+ * sample sort. The array is split into num_processes
+ * disjoint, contiguous chunks.
+ * @param[in] shmem st_shmem*, the shared memory.
+ * @param[in] process_idx int, the process index.
+ * @param[out] start size_t*, stores the starting index.
+ * @param[out] end size_t*, stores the ending index, exclusive.
+ */ 
+void get_chunk(const st_shmem* shmem, int process_idx, size_t* start, size_t* end)
+{
+    *start = shmem->size * process_idx / shmem->num_processes;
+    *end = shmem->size * (process_idx + 1) / shmem->num_processes;
+}
+
+/**
+ * @brief Compares two letters as unsigned bytes, for qsort,
+ * the order every letter sort and merge uses.
+ * @param[in] a void*, the first letter.
+ * @param[in] b void*, the second letter.
+ * @returns int, <0, 0 or >0 as a is less, equal or greater than b.
+ */ 
+int compare_chars(const void* a, const void* b)
+{
+    return *(const unsigned char *)a - *(const unsigned char *)b;
+}
+
+/* Integer key comparisons, for qsort */
+int compare_u16(const void* a, const void* b) { return (*(const uint16_t *)a > *(const uint16_t *)b) - (*(const uint16_t *)a < *(const uint16_t *)b); }
+int compare_u32(const void* a, const void* b) { return (*(const uint32_t *)a > *(const uint32_t *)b) - (*(const uint32_t *)a < *(const uint32_t *)b); }
+int compare_u64(const void* a, const void* b) { return (*(const uint64_t *)a > *(const uint64_t *)b) - (*(const uint64_t *)a < *(const uint64_t *)b); }
+int compare_i32(const void* a, const void* b) { return (*(const int32_t *)a > *(const int32_t *)b) - (*(const int32_t *)a < *(const int32_t *)b); }
+int compare_f32(const void* a, const void* b) { return (*(const float *)a > *(const float *)b) - (*(const float *)a < *(const float *)b); }
+
+/**
+ * @brief Returns the qsort comparison for elements of width bytes.
+ * @param[in] width int, the bytes per element, see key_at.
+ * @returns the comparison function.
+ */ 
+int (*compare_width(int width))(const void*, const void*)
+{
+    switch (width)
+    {
+        case 2: return compare_u16;
+        case 4: return compare_u32;
+        case 8: return compare_u64;
+        default: return compare_chars;
+    }
+}
+
+/**
+ * @brief Returns the index of the first of the first n
+ * elements of the sorted array arr greater than key.
+ * @param[in] arr char*, the sorted array.
+ * @param[in] n size_t, the number of elements to search.
+ * @param[in] key unsigned char, the key.
+ * @returns size_t, the index, n if none is greater.
+ */ 
+size_t upper_bound(const char* arr, size_t n, unsigned char key)
+{
+    size_t lo = 0, hi = n;
+    while (lo < hi)
+    {
+        size_t mid = lo + (hi - lo) / 2;
+        if ((unsigned char)arr[mid] <= key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * @brief Replays the loser tree from the leaf of run r up to the
+ * root: at each node, the run with the larger key stays as the
+ * loser and the other goes on. The winner ends up in tree[0].
+ * @param[inout] tree int*, the loser tree, k nodes.
+ * @param[in] keys int*, the next key of each run, keys[k] = -1
+ * for the virtual run that wins every match while the tree is built.
+ * @param[in] r int, the run index.
+ * @param[in] k int, the number of runs.
+ */ 
+static inline void loser_tree_adjust(int* tree, const int* keys, int r, int k)
+{
+    int winner = r;
+    for (int t = (r + k) / 2; t > 0; t /= 2)
+    {
+        if (keys[tree[t]] < keys[winner])
+        {
+            int loser = winner;
+            winner = tree[t];
+            tree[t] = loser;
+        }
     }
+    tree[0] = winner;
 }
 
 /**
  * @brief (Re)sets the elements of the boolean
  * array arr all to false.
- * @param[in] arr bool*, the array.
- * @param[in] n int, the number of elements to check.
+ * @param[in] arr atomic_bool*, the array.
+ * @param[in] n int, the number of elements to reset.
  */ 
-void reset(bool* arr, int n, int type)
+void reset(atomic_bool* arr, int n)
 {
-    int start = 0;
-    int end = n;
-    if (type == 1) { end = 2; }
-    else if (type == 3) { start = 1;}
-    for (int i = start; i < end; i++)
+    for (int i = 0; i < n; i++)
     {
         arr[i] = false;
     }
 }
 
+/**
+ * @brief Marks process p_i unfinished after its neighbour changed
+ * an element they share. Counted before and after, see validate.
+ * @param[in] shmem st_shmem*, the shared memory.
+ * @param[in] i int, the process index.
+ */ 
+void wake(st_shmem* shmem, int i)
+{
+    atomic_fetch_add(&shmem->wakes_begun, 1);
+    shmem_valid(shmem)[i] = false;
+    atomic_fetch_add(&shmem->wakes_ended, 1);
+}
+
 /**
  * @brief Checks if the first n cells in valid array
  * are true -> this will happen when all processes have sorted
  * their assigned elements (and we're finished).
+ * The cells are read one after the other, so the check only
+ * counts if no cell was reset while reading them: no wake was
+ * in progress before and none began during the reads.
  * @param[in] shmem st_shmem, the shared memory.
  * @param[in] n int, the number of cells to check.
  * @param[in] mutex int, the CS's semaphore lock.
@@ -121,16 +421,21 @@ void reset(bool* arr, int n, int type)
 bool validate(st_shmem* shmem, int n, int mutex)
 {
     bool ret = true;
+    atomic_bool* valid = shmem_valid(shmem);
+
+    long ended = atomic_load(&shmem->wakes_ended);
+    long begun = atomic_load(&shmem->wakes_begun);
+    if (begun != ended) return false;
 
     for (int i = 0; i < n; i++){
-        if (!shmem->valid[i]) 
+        if (!valid[i]) 
         {
             ret = false;
             break;
         }
     }
 
-    return ret;
+    return ret && atomic_load(&shmem->wakes_begun) == begun;
 }
 
 /**
@@ -145,7 +450,7 @@ bool valid_iteration(st_shmem* shmem, int i, int mutex)
 {
     // Block writers since were reading
     // (Pi will reset all valid cells once it swaps)
-    bool ret = shmem->valid[i];
+    bool ret = shmem_valid(shmem)[i];
 
     return ret;
 }
@@ -154,172 +459,1684 @@ bool valid_iteration(st_shmem* shmem, int i, int mutex)
  * @brief Prints the first n elements
  * of the array arr.
  * @param[in] arr char*, the array.
- * @param[in] n int, the number of elements to print.
+ * @param[in] n size_t, the number of elements to print.
+ * @param[in] width int, the bytes per element, see key_at.
  */ 
-void print_array(char* arr, int n)
+void print_array(char* arr, size_t n, int width)
 {
     printf("[ ");
-    for (int i = 0; i < n; i++)
+    for (size_t i = 0; i < n; i++)
     {
-        printf("%c ", arr[i]);
+        if (width == 1) printf("%c ", arr[i]);
+        else printf("%llu ", (unsigned long long)key_at(arr, i, width));
     }
     printf("]\n");
 }
 
 /**
- * @brief Performs bubble sort on the shared array
- * from index start to end inclusive.
+ * @brief Waits on boundary k: the sem_num semaphore in mutex,
+ * or the k-th mutex with the threads backend.
  * @param[in] shmem st_shmem*, the shared memory.
- * @param[in] start int, the starting index.
- * @param[in] end int, the ending index.
- * @param[in] mutex int, the CS's semaphore lock.
+ * @param[in] mutex int, the boundary semaphores.
+ * @param[in] k int, the boundary index.
+ * @returns 0 on success, -1 otherwise.
+ */ 
+int boundary_wait(st_shmem* shmem, int mutex, int k)
+{
+    if (shmem->threads) return pthread_mutex_lock(&shmem->locks[k]) == 0 ? 0 : -1;
+    return sem_wait(mutex, k);
+}
+
+/**
+ * @brief Signals boundary k, see boundary_wait.
+ * @param[in] shmem st_shmem*, the shared memory.
+ * @param[in] mutex int, the boundary semaphores.
+ * @param[in] k int, the boundary index.
+ * @returns 0 on success, -1 otherwise.
+ */ 
+int boundary_signal(st_shmem* shmem, int mutex, int k)
+{
+    if (shmem->threads) return pthread_mutex_unlock(&shmem->locks[k]) == 0 ? 0 : -1;
+    return sem_signal(mutex, k);
+}
+
+/**
+ * @brief Waits at barrier i of a sort's phases: the semaphore
+ * barrier i in sems, or the (reusable) round barrier with the
+ * threads backend.
+ * @param[in] shmem st_shmem*, the shared memory.
+ * @param[in] sems int, the semaphores.
+ * @param[in] i int, the barrier semaphore index.
+ * @returns 0 on success, -1 otherwise.
+ */ 
+int phase_barrier(st_shmem* shmem, int sems, int i)
+{
+    if (shmem->threads)
+    {
+        int ret = pthread_barrier_wait(&shmem->round_barrier);
+        return (ret == 0 || ret == PTHREAD_BARRIER_SERIAL_THREAD) ? 0 : -1;
+    }
+    return sem_barrier(sems, i);
+}
+
+/**
+ * @brief Performs one bubble sort pass on the shared array
+ * over the range of process_idx (see get_range). A comparison
+ * touching an element shared with a neighbour waits on that
+ * boundary's semaphore, semaphore k guards the element shared
+ * by P_(k + 1) and P_(k + 2).
+ * @param[in] shmem st_shmem*, the shared memory.
+ * @param[in] process_idx int, the process index.
+ * @param[in] mutex int, the boundary semaphores.
+ * @returns long, the number of swaps.
+ */ 
+long bubble_pass(st_shmem* shmem, int process_idx, int mutex)
+{
+    int process_num = process_idx + 1;
+    int last = shmem->num_processes - 1;
+    char* arr = shmem_arr(shmem);
+    char temp = 0;
+    long swaps = 0;
+    size_t start, end;
+    get_range(shmem, process_idx, &start, &end);
+
+    for (size_t i = start + 1; i <= end; i++)
+    {          
+        bool left = (i == start + 1 && process_idx > 0);    // Touches the element shared with the left neighbour
+        bool right = (i == end && process_idx < last);      // Touches the element shared with the right neighbour
+
+        // Always left before right, so neighbours can't deadlock.
+        if (left) ASSERT(boundary_wait(shmem, mutex, process_idx - 1) != -1, "Wait left.");
+        if (right) ASSERT(boundary_wait(shmem, mutex, process_idx) != -1, "Wait right.");
+
+        if (arr[i] < arr[i - 1])
+        {
+            DPRINTF("[Debug] Process P%d: performed swapping.\n", process_num);
+            swaps++;
+            temp = arr[i];
+            arr[i] = arr[i - 1];
+            arr[i - 1] = temp;
+
+            // Wake the neighbour whose shared element changed.
+            if (left) wake(shmem, process_idx - 1);
+            if (right) wake(shmem, process_idx + 1);
+        } 
+        else 
+        {
+            DPRINTF("[Debug] Process P%d: performed no swapping.\n", process_num);
+        }
+
+        if (right) ASSERT(boundary_signal(shmem, mutex, process_idx) != -1, "Signal right.");
+        if (left) ASSERT(boundary_signal(shmem, mutex, process_idx - 1) != -1, "Signal left.");
+    }
+    return swaps;
+}
+
+/**
+ * @brief Performs bubble sort on the shared array over the range
+ * of process_idx, with bubble_pass, until a pass makes no swaps.
+ * @param[in] shmem st_shmem*, the shared memory.
+ * @param[in] process_idx int, the process index.
+ * @param[in] mutex int, the boundary semaphores.
  */ 
-void sort(st_shmem* shmem, int start, int end, int mutex)
+void sort(st_shmem* shmem, int process_idx, int mutex)
 {
-    int process_num = start / 2 + 1;
-    char* arr = shmem->arr;
-    bool* valid = shmem->valid;
-    int temp = 0;
+    int last = shmem->num_processes - 1;
+    char* arr = shmem_arr(shmem);
+    atomic_bool* valid = shmem_valid(shmem);
     int swaps = true;
+    size_t start, end;
+    get_range(shmem, process_idx, &start, &end);
     
     while (swaps)
     {
-        swaps = false;
-        arr[start] = tolower(arr[start]);
-        for (int i = start + 1; i <= end; i++)
-        {          
-            arr[i] = tolower(arr[i]);
- 
-            if (i == 2 || i == 3)
-            {
-                ASSERT(sem_wait(mutex, LEFT_WRITE) != -1, "Wait left.");
-            } else if (i == 4 || i == 5) {
-                ASSERT(sem_wait(mutex, RIGHT_WRITE) != -1, "Wait right.");
-            }
+        swaps = (bubble_pass(shmem, process_idx, mutex) > 0);
 
-            if (arr[i] < arr[i - 1])
-            {
-                DPRINTF("[Debug] Process P%d: performed swapping.\n", process_num);
-                swaps = true;
-                temp = arr[i];
-                arr[i] = arr[i - 1];
-                arr[i - 1] = temp;
-
-                reset(valid, 3, process_num);
-            } 
-            else 
-            {
-                DPRINTF("[Debug] Process P%d: performed no swapping.\n", process_num);
-            }
+        /**
+         * A pass without swaps sorted the range, but a neighbour may have
+         * changed a shared element since it was compared. Recheck both
+         * ends holding their semaphores and mark the range valid before
+         * releasing them, so a later change always resets it.
+         */
+        if (!swaps)
+        {
+            if (process_idx > 0) ASSERT(boundary_wait(shmem, mutex, process_idx - 1) != -1, "Wait left.");
+            if (process_idx < last) ASSERT(boundary_wait(shmem, mutex, process_idx) != -1, "Wait right.");
+            swaps = arr[start + 1] < arr[start] || arr[end] < arr[end - 1];
+            if (!swaps) valid[process_idx] = true;
+            if (process_idx < last) ASSERT(boundary_signal(shmem, mutex, process_idx) != -1, "Signal right.");
+            if (process_idx > 0) ASSERT(boundary_signal(shmem, mutex, process_idx - 1) != -1, "Signal left.");
+        }
+    }
+}
+
+/**
+ * @brief Returns the letter in a shared element, waiting
+ * while a neighbour has it in transit.
+ * @param[in] cell atomic_char*, the shared element.
+ * @returns char, the letter.
+ */ 
+static inline char load_cell(atomic_char* cell)
+{
+    char c;
+    while ((c = atomic_load(cell)) == IN_TRANSIT) sched_yield();
+    return c;
+}
+
+/**
+ * @brief Performs one bubble sort pass on the shared array over the
+ * range of process_idx like bubble_pass, but without semaphores: the
+ * elements shared with the neighbours are only accessed atomically.
+ *  - When the other element compared is private, a swap is a CAS of
+ *    the shared element from the letter compared to the private one,
+ *    retried if the neighbour changed it in between.
+ *  - When both are shared (a range of two), the process first swaps
+ *    IN_TRANSIT into the left one, keeping its letter, then swaps that
+ *    letter into the right one and puts the right's letter in the left.
+ *    Neighbours reading the left one wait meanwhile. A process only waits
+ *    on its right element, so the waits can't form a cycle.
+ * @param[in] shmem st_shmem*, the shared memory.
+ * @param[in] process_idx int, the process index.
+ * @returns long, the number of swaps.
+ */ 
+long bubble_pass_lock_free(st_shmem* shmem, int process_idx)
+{
+    int process_num = process_idx + 1;
+    int last = shmem->num_processes - 1;
+    char* arr = shmem_arr(shmem);
+    atomic_char* cells = (atomic_char *)arr;
+    char temp = 0;
+    long swaps = 0;
+    size_t start, end;
+    get_range(shmem, process_idx, &start, &end);
+
+    for (size_t i = start + 1; i <= end; i++)
+    {
+        bool left = (i == start + 1 && process_idx > 0);    // arr[i - 1] is shared with the left neighbour
+        bool right = (i == end && process_idx < last);      // arr[i] is shared with the right neighbour
+        bool swapped = false;
+        char x, y;
 
-            if (i == 2 || i == 3)
+        if (left && right)
+        {
+            while ((x = load_cell(&cells[i - 1])) > load_cell(&cells[i]))
             {
-                ASSERT(sem_signal(mutex, LEFT_WRITE) != -1, "Signal left.");
-            } else if (i == 4 || i == 5) {
-                ASSERT(sem_signal(mutex, RIGHT_WRITE) != -1, "Signal right.");
+                // Take the left letter, then swap it for the right one
+                if (!atomic_compare_exchange_strong(&cells[i - 1], &x, IN_TRANSIT)) continue;
+                while (x > (y = load_cell(&cells[i])) && !atomic_compare_exchange_strong(&cells[i], &y, x));
+                swapped = (x > y);
+                atomic_store(&cells[i - 1], swapped ? y : x);
+                break;
             }
         }
+        else if (left)
+        {
+            while ((x = load_cell(&cells[i - 1])) > arr[i] && !atomic_compare_exchange_strong(&cells[i - 1], &x, arr[i]));
+            if ((swapped = (x > arr[i]))) arr[i] = x;
+        }
+        else if (right)
+        {
+            while (arr[i - 1] > (y = load_cell(&cells[i])) && !atomic_compare_exchange_strong(&cells[i], &y, arr[i - 1]));
+            if ((swapped = (arr[i - 1] > y))) arr[i - 1] = y;
+        }
+        else if (arr[i] < arr[i - 1])
+        {
+            swapped = true;
+            temp = arr[i];
+            arr[i] = arr[i - 1];
+            arr[i - 1] = temp;
+        }
+
+        if (swapped)
+        {
+            DPRINTF("[Debug] Process P%d: performed swapping.\n", process_num);
+            swaps++;
+            // Wake the neighbour whose shared element changed.
+            if (left) wake(shmem, process_idx - 1);
+            if (right) wake(shmem, process_idx + 1);
+        }
+        else
+        {
+            DPRINTF("[Debug] Process P%d: performed no swapping.\n", process_num);
+        }
     }
+    return swaps;
+}
+
+/**
+ * @brief Performs bubble sort on the shared array over the range
+ * of process_idx, with bubble_pass_lock_free, until a pass makes
+ * no swaps. The range is marked valid before the recheck of its
+ * ends, so a neighbour's change after it is seen by the recheck or
+ * resets the flag. The mark is counted like a wake, see validate.
+ * @param[in] shmem st_shmem*, the shared memory.
+ * @param[in] process_idx int, the process index.
+ */ 
+void sort_lock_free(st_shmem* shmem, int process_idx)
+{
+    atomic_char* cells = (atomic_char *)shmem_arr(shmem);
+    atomic_bool* valid = shmem_valid(shmem);
+    int swaps = true;
+    size_t start, end;
+    get_range(shmem, process_idx, &start, &end);
+
+    while (swaps)
+    {
+        swaps = (bubble_pass_lock_free(shmem, process_idx) > 0);
 
-    valid[start / 2] = true;
-    /**
-     * Valid doesn't need a semaphore since it is checked in our while loop.
-     * If all processes are valid, we are done (they all finished without swapping).
-     * Otherwise, any swap will be caught in the loop since we won't exit.
-     */
+        // Mark valid, then recheck the ends, see above.
+        if (!swaps)
+        {
+            atomic_fetch_add(&shmem->wakes_begun, 1);
+            valid[process_idx] = true;
+            swaps = load_cell(&cells[start + 1]) < load_cell(&cells[start]) || load_cell(&cells[end]) < load_cell(&cells[end - 1]);
+            if (swaps) valid[process_idx] = false;
+            atomic_fetch_add(&shmem->wakes_ended, 1);
+        }
+    }
 }
 
 /**
  * @brief Process work loop. Keeps swapping elements
  * in process' allocated range until all work flag 
  * complete at the same time.
- * @param process_idx int, the starting index for the process' range.
+ * @param process_idx int, the process index.
  * @param[in] shmem st_shmem*, the shared memory.
- * @param[in] mutex int, the CS's semaphore lock.
+ * @param[in] mutex int, the boundary semaphores.
  */ 
 void do_work(int process_idx, st_shmem* st_shared, int mutex)
 {
     // While there's atleast one process that isn't finished
-    while (!validate(st_shared, 3, mutex)) {    
+    while (!validate(st_shared, st_shared->num_processes, mutex)) {    
         // Skip if this process has completed a valid iteration
         if (!valid_iteration(st_shared, process_idx, mutex))    
         {
-            // Otherwise sort
-            /* Let the index be the process number - 1 then
-             * each process if reponsible for [2 * index, 2 * (index + 1)]
-             * P1≡0 [0, 2], P2≡1 [2, 4], P3≡2 [4, 6]
-             */
-            sort(st_shared, 2 * process_idx, 2 * process_idx + 2, mutex);
+            // Otherwise sort its range, see get_range
+            if (st_shared->lock_free) sort_lock_free(st_shared, process_idx);
+            else sort(st_shared, process_idx, mutex);
         }
     }
 }
 
-int main(void)
+/**
+ * @brief Process work loop in rounds: every process makes one
+ * pass over its range, adds its swaps to the round's counter and
+ * sleeps at the round barrier until all have. A round without
+ * swaps compared every adjacent pair without changing any, so the
+ * array is sorted and all processes stop together.
+ * The counters are used in turn: process P1 zeroes the next round's
+ * during this round, after everyone read it two rounds ago (they
+ * all passed the last barrier since) and before anyone adds to it
+ * (after this round's barrier).
+ * @param process_idx int, the process index.
+ * @param[in] shmem st_shmem*, the shared memory.
+ * @param[in] mutex int, the boundary semaphores.
+ */ 
+void do_rounds(int process_idx, st_shmem* st_shared, int mutex)
+{
+    for (long round = 0; ; round++)
+    {
+        long swaps = st_shared->lock_free ? bubble_pass_lock_free(st_shared, process_idx)
+            : bubble_pass(st_shared, process_idx, mutex);
+        if (swaps) atomic_fetch_add(&st_shared->round_swaps[round % ROUND_COUNTERS], swaps);
+        if (process_idx == 0) atomic_store(&st_shared->round_swaps[(round + 1) % ROUND_COUNTERS], 0);
+
+        pthread_barrier_wait(&st_shared->round_barrier);
+        if (atomic_load(&st_shared->round_swaps[round % ROUND_COUNTERS]) == 0) return;
+    }
+}
+
+/**
+ * @brief Performs process process_idx's share of a sample sort
+ * (regular sampling) of the shared array, in three phases split
+ * by two barriers:
+ *  1. Sort the process' chunk (see get_chunk) into tmp and draw
+ *     num_processes evenly spaced samples from it.
+ *  2. Sort all samples and pick the same num_processes - 1 splitters
+ *     as every other process, then find where each bucket ends in the
+ *     sorted chunk: bucket b holds the letters in (splitter b - 1, splitter b].
+ *  3. Merge bucket process_idx of every chunk, a sorted run each, to its
+ *     final place in arr, right after the lower buckets, with a loser
+ *     tree as in merge_group: log2(p) comparisons per letter.
+ * Phase 3 only reads tmp and writes its own part of arr, so the
+ * parent waiting for the processes to exit is the last barrier.
+ * @param[in] shmem st_shmem*, the shared memory (with scratch).
+ * @param[in] process_idx int, the process index.
+ * @param[in] sems int, the semaphores.
+ * @param[in] barrier int, the first of the two barrier semaphores.
+ */ 
+void sample_sort(st_shmem* shmem, int process_idx, int sems, int barrier)
 {
-    pid_t pids[TOTAL_PROCESSES];                        // Process IDs
-    int mutex;                                          // Semaphore IDs
-    ASSERT((mutex = sem_create((key_t)1234, TOTAL_SEM)) != -1, "Create semaphores");
+    int p = shmem->num_processes;
+    char* arr = shmem_arr(shmem);
+    char* tmp = shmem_tmp(shmem);
+    char* samples = shmem_samples(shmem);
+    size_t* bounds = shmem_bounds(shmem);
+    size_t start, end;
+    get_chunk(shmem, process_idx, &start, &end);
+    size_t length = end - start;
 
-    // Initialize semaphores to 1
-    for (int i = 0; i < TOTAL_SEM; i++) {
-        ASSERT(sem_set(mutex, i, 1) != -1, "Set semaphore");
+    // Phase 1: sort the chunk and sample it
+    network_merge_sort_char(arr + start, tmp + start, length);     // arr is free until the last phase
+    for (int j = 0; j < p; j++)
+    {
+        samples[process_idx * p + j] = tmp[start + length * j / p];
     }
+    DPRINTF("[Debug] Process P%d: sorted %zu letters and drew %d samples.\n", process_idx + 1, length, p);
+    ASSERT(phase_barrier(shmem, sems, barrier) != -1, "Barrier samples.");
 
-    // Create Shared Memory
-    void *shared_memory = (void *)0;
-    struct shared_use_st *shared_stuff;
-    int shmid;
+    // Phase 2: pick the splitters and bound the buckets
+    char* sorted = malloc(2 * (size_t)p * p);
+    ASSERT(sorted != NULL, "Allocate samples.");
+    memcpy(sorted + p * p, samples, (size_t)p * p);
+    network_merge_sort_char(sorted + p * p, sorted, (size_t)p * p);
+    size_t* own = bounds + process_idx * (p + 1);
+    own[0] = 0;
+    for (int b = 1; b < p; b++)
+    {
+        own[b] = upper_bound(tmp + start, length, sorted[b * p + p / 2 - 1]);
+    }
+    own[p] = length;
+    free(sorted);
+    ASSERT(phase_barrier(shmem, sems, barrier + 1) != -1, "Barrier bounds.");
 
-    ASSERT((shmid = shmem_create(IPC_PRIVATE, sizeof(st_shmem))) != -1, "Create shared memory.");   // Create the shared memory
-    ASSERT((shared_memory = shmem_attach(shmid)) != -1, "Create shared memory."); // Attach the shared memory to the parent
-    st_shmem* st_shared = (st_shmem *)shared_memory; 
+    // Phase 3: merge bucket process_idx of every chunk into place
+    size_t offset = 0, total = 0;
+    size_t* heads = malloc(2 * p * sizeof(size_t));     // Next and end of each chunk's run
+    ASSERT(heads != NULL, "Allocate runs.");
+    for (int w = 0; w < p; w++)
+    {
+        size_t chunk_start, chunk_end;
+        get_chunk(shmem, w, &chunk_start, &chunk_end);
+        offset += bounds[w * (p + 1) + process_idx];
+        heads[2 * w] = chunk_start + bounds[w * (p + 1) + process_idx];
+        heads[2 * w + 1] = chunk_start + bounds[w * (p + 1) + process_idx + 1];
+        total += heads[2 * w + 1] - heads[2 * w];
+    }
+    int* tree = malloc(p * sizeof(int));
+    int* keys = malloc((p + 1) * sizeof(int));         // Next letter of each run, BUCKETS once it is empty
+    ASSERT(tree != NULL && keys != NULL, "Allocate loser tree.");
+    for (int w = 0; w < p; w++)
+    {
+        keys[w] = (heads[2 * w] < heads[2 * w + 1]) ? (unsigned char)tmp[heads[2 * w]] : BUCKETS;
+    }
+    keys[p] = -1;
+    for (int t = 0; t < p; t++) tree[t] = p;
+    for (int w = p - 1; w >= 0; w--) loser_tree_adjust(tree, keys, w, p);
+    for (size_t pos = offset; pos < offset + total; pos++)
+    {
+        int min = tree[0];
+        arr[pos] = keys[min];
+        heads[2 * min]++;
+        keys[min] = (heads[2 * min] < heads[2 * min + 1]) ? (unsigned char)tmp[heads[2 * min]] : BUCKETS;
+        loser_tree_adjust(tree, keys, min, p);
+    }
+    free(tree);
+    free(keys);
+    free(heads);
+    shmem_work(shmem)[process_idx] = length + total;
+    DPRINTF("[Debug] Process P%d: merged bucket of %zu letters at %zu.\n", process_idx + 1, total, offset);
+}
 
-    // Initialization
-    debug_prompt();                     // Prompt the user to select the run mode
-    st_shared->readcount = 0;           // Total "valid state" readers is 0
-    init_array(st_shared->arr, SIZE);   // Initialize the array to be sorted
-    reset(st_shared->valid, TOTAL_PROCESSES, 2);      // Set valid state to all false / 0
+/**
+ * @brief Computes where process_idx's elements with each byte
+ * value go in a counting pass: after all elements with smaller
+ * bytes, then after the same byte in the chunks before its own.
+ * Reads every process' histogram, see shmem_counts.
+ * @param[in] shmem st_shmem*, the shared memory.
+ * @param[in] process_idx int, the process index.
+ * @param[out] next size_t*, stores BUCKETS starting indices.
+ */ 
+void bucket_offsets(st_shmem* shmem, int process_idx, size_t* next)
+{
+    int p = shmem->num_processes;
+    size_t* counts = shmem_counts(shmem);
+    size_t offset = 0;
 
-    // Create child processes.
-    ASSERT((pids[P1] = fork()) > -1, "Fork first child.");   // Fork failed
-    if (pids[P1] > 0)
+    for (int k = 0; k < BUCKETS; k++)
     {
-        ASSERT((pids[P2] = fork()) > -1, "Fork first child.");   // Fork failed
-        if (pids[P2] > 0)
+        next[k] = offset;
+        for (int w = 0; w < p; w++)
         {
-            ASSERT((pids[P3] = fork()) > -1, "Fork third child.");   // Fork failed
-            if (pids[P3] > 0)
-            {
-                // Parent Process
-                wait_n_children(TOTAL_PROCESSES);   // Wait for three children to exit
-                printf("Sorted Array: ");
-                print_array(st_shared->arr, SIZE);  // Print the resulting sorted array
-                ASSERT(sem_delete(mutex) != -1, "Delete semaphores."); // Delete the shared memory
-                ASSERT(shmem_delete(shmid) != -1, "Dettach shared memory."); // Delete the semaphores
-            }
-            else 
-            {
-                // Process P3
-                ASSERT((shared_memory = shmem_attach(shmid)) != -1, "Create shared memory."); // Attach the shared memory to the parent
-                do_work(P3, st_shared, mutex);          // Enter sorting loop
-                ASSERT(shmem_dettach(st_shared) != -1, "Dettach shared memory."); // Dettach the shared memory
-            }
+            if (w < process_idx) next[k] += counts[w * BUCKETS + k];
+            offset += counts[w * BUCKETS + k];
         }
-        else
+    }
+}
+
+/**
+ * @brief Performs process process_idx's share of a counting sort
+ * of the shared letters. The process counts the letters in its
+ * chunk (see get_chunk), waits at a barrier for the other counts,
+ * then writes its own copies of each letter straight to their
+ * final place: a letter is its own key, so nothing is moved and
+ * no scratch array is needed.
+ * @param[in] shmem st_shmem*, the shared memory.
+ * @param[in] process_idx int, the process index.
+ * @param[in] sems int, the semaphores.
+ * @param[in] barrier int, the barrier semaphore.
+ */ 
+void counting_sort(st_shmem* shmem, int process_idx, int sems, int barrier)
+{
+    unsigned char* arr = (unsigned char *)shmem_arr(shmem);
+    size_t* own = shmem_counts(shmem) + process_idx * BUCKETS;
+    size_t next[BUCKETS];
+    size_t start, end;
+    get_chunk(shmem, process_idx, &start, &end);
+
+    memset(own, 0, BUCKETS * sizeof(size_t));
+    for (size_t i = start; i < end; i++)
+    {
+        own[arr[i]]++;
+    }
+    ASSERT(phase_barrier(shmem, sems, barrier) != -1, "Barrier counts.");
+
+    bucket_offsets(shmem, process_idx, next);
+    for (int k = 0; k < BUCKETS; k++)
+    {
+        memset(arr + next[k], k, own[k]);
+    }
+    DPRINTF("[Debug] Process P%d: counted and placed %zu letters.\n", process_idx + 1, end - start);
+}
+
+/**
+ * @brief Performs process process_idx's share of an LSD radix sort
+ * of the shared keys, one stable counting pass per key byte, least
+ * significant first. Each pass counts the byte over the process'
+ * chunk of the source, waits for the other counts, scatters the
+ * chunk to the destination and waits for the other scatters, with
+ * arr and tmp swapping roles every pass. After an odd number of
+ * passes the keys are in tmp and each process copies its chunk back.
+ * @param[in] shmem st_shmem*, the shared memory (with scratch).
+ * @param[in] process_idx int, the process index.
+ * @param[in] sems int, the semaphores.
+ * @param[in] barrier int, the first of the 2 * width barrier semaphores.
+ */ 
+void radix_sort(st_shmem* shmem, int process_idx, int sems, int barrier)
+{
+    int width = shmem->width;
+    char* src = shmem_arr(shmem);
+    char* dst = shmem_tmp(shmem);
+    size_t* own = shmem_counts(shmem) + process_idx * BUCKETS;
+    size_t next[BUCKETS];
+    size_t start, end;
+    get_chunk(shmem, process_idx, &start, &end);
+
+    for (int pass = 0; pass < width; pass++)
+    {
+        int shift = 8 * pass;
+        memset(own, 0, BUCKETS * sizeof(size_t));
+        for (size_t i = start; i < end; i++)
+        {
+            own[(key_at(src, i, width) >> shift) & 0xff]++;
+        }
+        ASSERT(phase_barrier(shmem, sems, barrier + 2 * pass) != -1, "Barrier counts.");
+
+        bucket_offsets(shmem, process_idx, next);
+        for (size_t i = start; i < end; i++)
         {
-            // Process P2
-            ASSERT((shared_memory = shmem_attach(shmid)) != -1, "Create shared memory."); // Attach the shared memory to the parent
-            do_work(P2, st_shared, mutex);              // Enter sorting loop
-            ASSERT(shmem_dettach(st_shared) != -1, "Dettach shared memory."); // Dettach the shared memory
+            size_t to = next[(key_at(src, i, width) >> shift) & 0xff]++;
+            memcpy(dst + to * width, src + i * width, width);
         }
+        ASSERT(phase_barrier(shmem, sems, barrier + 2 * pass + 1) != -1, "Barrier scatter.");
+
+        char* swap = src; src = dst; dst = swap;
     }
-    else
+
+    if (width % 2)
     {
-        // Process P1
-        ASSERT((shared_memory = shmem_attach(shmid)) != -1, "Create shared memory."); // Attach the shared memory to the parent
-        do_work(P1, st_shared, mutex);                  // Enter sorting loop
-        ASSERT(shmem_dettach(st_shared) != -1, "Dettach shared memory."); // Dettach the shared memory
+        memcpy(shmem_arr(shmem) + start * width, src + start * width, (end - start) * width);
     }
+    DPRINTF("[Debug] Process P%d: radix sorted %zu keys in %d passes.\n", process_idx + 1, end - start, width);
+}
+
+/**
+ * @brief Partitions the n letters of arr around the median of
+ * the first, middle and last: [0, *lt) are smaller, [*lt, *gt)
+ * equal and [*gt, n) larger, as unsigned bytes like compare_chars.
+ * Equal letters are in place at once, so runs of the same letter
+ * never need sorting again.
+ * @param[inout] arr unsigned char*, the letters.
+ * @param[in] n size_t, the number of letters, at least 1.
+ * @param[out] lt size_t*, stores the start of the equal letters.
+ * @param[out] gt size_t*, stores the end of the equal letters.
+ */ 
+static void partition3(unsigned char* arr, size_t n, size_t* lt, size_t* gt)
+{
+    unsigned char a = arr[0], b = arr[n / 2], c = arr[n - 1];
+    unsigned char pivot = (a < b) ? ((b < c) ? b : (a < c) ? c : a) : ((a < c) ? a : (b < c) ? c : b);
+    size_t low = 0, i = 0, high = n;
+    while (i < high)
+    {
+        unsigned char x = arr[i];
+        if (x < pivot) { arr[i++] = arr[low]; arr[low++] = x; }
+        else if (x > pivot) { arr[i] = arr[--high]; arr[high] = x; }
+        else i++;
+    }
+    *lt = low;
+    *gt = high;
+}
+
+/**
+ * @brief Sorts the n letters of arr in this worker: quicksort
+ * down to blocks of NETWORK_MAX, sorted by a sorting network.
+ * @param[inout] arr char*, the letters.
+ * @param[in] n size_t, the number of letters.
+ * @returns size_t, the letters gone over, summed over the levels.
+ */ 
+static size_t quick_sort_local(char* arr, size_t n)
+{
+    size_t work = 0;
+    while (n > NETWORK_MAX)
+    {
+        size_t lt, gt;
+        partition3((unsigned char *)arr, n, &lt, &gt);
+        work += n;
+        // Recurse into the smaller side, loop on the larger one
+        if (lt < n - gt) {
+            work += quick_sort_local(arr, lt);
+            arr += gt;
+            n -= gt;
+        } else {
+            work += quick_sort_local(arr + gt, n - gt);
+            n = lt;
+        }
+    }
+    network_sort_char(arr, n);
+    return work + n;
+}
+
+/**
+ * @brief Tells the parked workers that there is a new task, or with
+ * all set, that every letter is in place. The event is counted before
+ * idle is read, and a parking worker counts itself idle before it reads
+ * the events again (see quick_sort), so one of them sees the other.
+ * @param[in] shmem st_shmem*, the shared memory.
+ * @param[in] all bool, whether to wake every parked worker.
+ */ 
+static void quick_notify(st_shmem* shmem, bool all)
+{
+    atomic_fetch_add(&shmem->pushes, 1);
+    if (atomic_load(&shmem->idle) == 0) return;
+    pthread_mutex_lock(&shmem->idle_lock);
+    if (all) pthread_cond_broadcast(&shmem->idle_wake);
+    else pthread_cond_signal(&shmem->idle_wake);
+    pthread_mutex_unlock(&shmem->idle_lock);
+}
+
+/**
+ * @brief Sorts the range [start, end) of the array: while it is
+ * larger than QUICK_GRAIN, partitions it, pushes the larger side
+ * on the worker's deque for itself or a thief and goes on with the
+ * smaller side, then sorts what is left locally.
+ * @param[in] shmem st_shmem*, the shared memory.
+ * @param[in] process_idx int, the process index.
+ * @param[in] task ws_task, the range.
+ */ 
+static void quick_sort_task(st_shmem* shmem, int process_idx, ws_task task)
+{
+    char* arr = shmem_arr(shmem);
+    size_t* work = shmem_work(shmem) + process_idx;
+    while (task.end - task.start > QUICK_GRAIN)
+    {
+        size_t lt, gt;
+        partition3((unsigned char *)arr + task.start, task.end - task.start, &lt, &gt);
+        *work += task.end - task.start;
+        if (atomic_fetch_sub(&shmem->unsorted, gt - lt) == gt - lt) quick_notify(shmem, true);
+        ws_task left = { task.start, task.start + lt }, right = { task.start + gt, task.end };
+        bool left_larger = (lt > task.end - task.start - gt);
+        ws_task larger = left_larger ? left : right;
+        task = left_larger ? right : left;
+        if (ws_push(&shmem_deques(shmem)[process_idx], larger) == -1)
+        {
+            quick_sort_task(shmem, process_idx, larger);    // Deque full, keep it
+        } else {
+            quick_notify(shmem, false);
+        }
+    }
+    *work += quick_sort_local(arr + task.start, task.end - task.start);
+    if (atomic_fetch_sub(&shmem->unsorted, task.end - task.start) == task.end - task.start) {
+        quick_notify(shmem, true);      // Last letters in place, wake everyone to exit
+    }
+}
+
+/**
+ * @brief Parallel quicksort. The whole array starts as one task on
+ * P1's deque (see run_sort), and every task pushes the larger side of
+ * each partition back (see quick_sort_task). A worker runs the tasks
+ * of its own deque, newest first, and when it runs out steals the
+ * oldest, hence largest, task of another worker, until every letter
+ * is in place. A worker that finds nothing to steal parks on idle_wake
+ * until a task is pushed or the sort is done, instead of spinning.
+ * @param[in] shmem st_shmem*, the shared memory.
+ * @param[in] process_idx int, the process index.
+ */ 
+void quick_sort(st_shmem* shmem, int process_idx)
+{
+    int p = shmem->num_processes;
+    ws_deque* deques = shmem_deques(shmem);
+    unsigned int seed = process_idx + 1;
+    ws_task task;
+    while (atomic_load(&shmem->unsorted) > 0)
+    {
+        if (ws_pop(&deques[process_idx], &task) == 0) {
+            quick_sort_task(shmem, process_idx, task);
+            continue;
+        }
+        // Try every other worker once, from a random one, remembering the pushes seen before
+        long pushes = atomic_load(&shmem->pushes);
+        int first = (p > 1) ? rand_r(&seed) % (p - 1) : 0;
+        bool stole = false;
+        for (int i = 0; i < p - 1 && !stole; i++) {
+            int victim = (process_idx + 1 + (first + i) % (p - 1)) % p;
+            if (ws_steal(&deques[victim], &task) == 0) {
+                DPRINTF("[Debug] Process P%d: stole %zu letters from P%d.\n", process_idx + 1, task.end - task.start, victim + 1);
+                quick_sort_task(shmem, process_idx, task);
+                stole = true;
+            }
+        }
+        if (stole) continue;
+        // Nothing to steal: park until a push or the end that the scan could have missed
+        pthread_mutex_lock(&shmem->idle_lock);
+        atomic_fetch_add(&shmem->idle, 1);
+        while (atomic_load(&shmem->pushes) == pushes && atomic_load(&shmem->unsorted) > 0) {
+            pthread_cond_wait(&shmem->idle_wake, &shmem->idle_lock);
+        }
+        atomic_fetch_sub(&shmem->idle, 1);
+        pthread_mutex_unlock(&shmem->idle_lock);
+    }
+    DPRINTF("[Debug] Process P%d: went over %zu letters.\n", process_idx + 1, shmem_work(shmem)[process_idx]);
+}
+
+/**
+ * @brief Returns the time since the epoch in seconds.
+ * @returns double, the time.
+ */ 
+double now_seconds(void)
+{
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec + now.tv_usec / 1e6;
+}
+
+/**
+ * @brief Reads n bytes of the file fd at offset into buf.
+ * @param[in] fd int, the file.
+ * @param[out] buf char*, stores the bytes.
+ * @param[in] n size_t, the number of bytes.
+ * @param[in] offset long long, the file offset.
+ * @returns true on success, false on an error or the end of the file.
+ */ 
+bool read_fully(int fd, char* buf, size_t n, long long offset)
+{
+    while (n > 0)
+    {
+        ssize_t got = pread(fd, buf, n, offset);
+        if (got <= 0) return false;
+        buf += got; n -= got; offset += got;
+    }
+    return true;
+}
+
+/**
+ * @brief Writes n bytes of buf to the file fd at offset.
+ * @param[in] fd int, the file.
+ * @param[in] buf char*, the bytes.
+ * @param[in] n size_t, the number of bytes.
+ * @param[in] offset long long, the file offset.
+ * @returns true on success, false otherwise.
+ */ 
+bool write_fully(int fd, const char* buf, size_t n, long long offset)
+{
+    while (n > 0)
+    {
+        ssize_t put = pwrite(fd, buf, n, offset);
+        if (put <= 0) return false;
+        buf += put; n -= put; offset += put;
+    }
+    return true;
+}
+
+/**
+ * @brief Faults in worker process_idx's chunk of arr and of tmp, if
+ * any, in its own page table, see shmem_prefault. With first_touch,
+ * its chunk of tmp is written through instead, it holds nothing yet.
+ * Only bytes of the chunks are written, so the workers can fault in
+ * side by side.
+ * @param[in] shmem st_shmem*, the shared memory.
+ * @param[in] process_idx int, the worker index.
+ */ 
+void fault_in_chunk(st_shmem* shmem, int process_idx)
+{
+    size_t start, end;
+    get_chunk(shmem, process_idx, &start, &end);
+    size_t offset = start * shmem->width, bytes = (end - start) * shmem->width;
+    ASSERT(shmem_prefault(shmem_arr(shmem) + offset, bytes) != -1, "Prefault chunk.");
+    if (!shmem->scratch) return;
+    if (shmem->first_touch) memset(shmem_tmp(shmem) + offset, 0, bytes);
+    else ASSERT(shmem_prefault(shmem_tmp(shmem) + offset, bytes) != -1, "Prefault scratch chunk.");
+}
+
+/**
+ * @brief Runs worker process_idx's share of the specified algorithm.
+ * @param[in] shmem st_shmem*, the shared memory.
+ * @param[in] process_idx int, the worker index.
+ * @param[in] mode sort_mode, the algorithm.
+ * @param[in] sems int, the semaphores, see run_sort.
+ * @param[in] barrier int, the first barrier semaphore.
+ */ 
+void work(st_shmem* shmem, int process_idx, sort_mode mode, int sems, int barrier)
+{
+    // Fault in this worker's chunks itself, before any worker sorts (forked
+    // workers don't share the parent's page table, threads were prefaulted at setup)
+    if (shmem->first_touch || (shmem->populate && !shmem->threads))
+    {
+        fault_in_chunk(shmem, process_idx);
+        ASSERT(phase_barrier(shmem, sems, barrier + BARRIER_FAULTED) != -1, "Barrier faulted.");
+    }
+
+    // External sort: read this worker's chunk of the run
+    size_t start, end;
+    get_chunk(shmem, process_idx, &start, &end);
+    if (shmem->input_fd != -1)
+    {
+        ASSERT(read_fully(shmem->input_fd, shmem_arr(shmem) + start, end - start, shmem->run_offset + start), "Read run.");
+        // Quick sort tasks span chunks, so the whole run must be read first
+        if (mode == MODE_QUICK) ASSERT(phase_barrier(shmem, sems, barrier + BARRIER_READ) != -1, "Barrier read.");
+    }
+
+    if (mode == MODE_SAMPLE) sample_sort(shmem, process_idx, sems, barrier);
+    else if (mode == MODE_COUNTING) counting_sort(shmem, process_idx, sems, barrier);
+    else if (mode == MODE_RADIX) radix_sort(shmem, process_idx, sems, barrier);
+    else if (mode == MODE_QUICK) quick_sort(shmem, process_idx);
+    else if (shmem->spin) do_work(process_idx, shmem, sems);   // Enter sorting loop
+    else do_rounds(process_idx, shmem, sems);
+
+    // External sort: once all are sorted, spill this worker's chunk of the run
+    if (shmem->input_fd != -1)
+    {
+        ASSERT(phase_barrier(shmem, sems, barrier + BARRIER_SORTED) != -1, "Barrier sorted.");
+        ASSERT(write_fully(shmem->runs_fd, shmem_arr(shmem) + start, end - start, shmem->run_offset + start), "Write run.");
+    }
+}
+
+// Arguments of a worker thread, see work
+typedef struct {
+    st_shmem* shmem;
+    int process_idx;
+    sort_mode mode;
+    int sems;
+    int barrier;
+} worker_args;
+
+/**
+ * @brief Worker thread entry point of the threads backend.
+ * @param[in] arg worker_args*, the arguments of work.
+ * @returns NULL.
+ */ 
+void* work_thread(void* arg)
+{
+    worker_args* args = (worker_args *)arg;
+    work(args->shmem, args->process_idx, args->mode, args->sems, args->barrier);
+    return NULL;
+}
+
+/**
+ * @brief Gets the CPU time and page faults of the terminated
+ * children of the calling process, or of the calling process itself.
+ * @param[in] who int, RUSAGE_CHILDREN or RUSAGE_SELF.
+ * @param[out] cpu double*, stores the CPU time in seconds.
+ * @param[out] faults long*, stores the page faults.
+ */ 
+void resource_usage(int who, double* cpu, long* faults)
+{
+    struct rusage usage;
+    getrusage(who, &usage);
+    *cpu = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+        + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+    *faults = usage.ru_minflt + usage.ru_majflt;
+}
+
+/**
+ * @brief Opens a counter of the dTLB load misses of the calling
+ * process and of the processes and threads it creates afterwards
+ * (whose counts are added when they exit).
+ * @returns int, the counter's file descriptor, -1 if the system
+ * has no such counter (e.g. in most virtual machines).
+ */ 
+int tlb_counter_open(void)
+{
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.inherit = 1;
+    attr.exclude_hv = 1;
+    return syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/**
+ * @brief Returns the number of boundary semaphores
+ * (or locks) for num_processes workers.
+ * @param[in] num_processes int, the number of workers.
+ * @returns int, one per shared element, at least one.
+ */ 
+int boundary_count(int num_processes)
+{
+    return (num_processes > 1) ? num_processes - 1 : 1;
+}
+
+/**
+ * @brief Creates the shared memory and synchronization for sorting
+ * size elements with num_processes workers: SysV (or POSIX) shared
+ * memory and semaphores for processes, or a heap buffer and mutexes
+ * for threads. The boundary semaphores (locks) are set to 1, then
+ * MAX_BARRIERS barrier semaphores follow (from boundary_count).
+ * With MEMORY_HUGE, the memory is backed by huge pages if the system
+ * has them reserved, else transparent huge pages are asked for. With
+ * MEMORY_PREFAULT, the threads' buffer is faulted in here, shared
+ * memory by each forked worker, its own chunks (see work).
+ * @param[in] threads bool, whether the workers are threads.
+ * @param[in] size size_t, the number of elements.
+ * @param[in] width int, the bytes per element.
+ * @param[in] num_processes int, the number of workers.
+ * @param[in] scratch bool, whether to hold tmp for sample or radix sort.
+ * @param[in] memory int, the MEMORY_ options.
+ * @param[out] shmid int*, stores the shared memory id (-1 if not SysV).
+ * @param[out] sems int*, stores the semaphores id (-1 for threads).
+ * @returns st_shmem*, the shared memory.
+ */ 
+st_shmem* setup_sort(bool threads, size_t size, int width, int num_processes, bool scratch, int memory, int* shmid, int* sems)
+{
+    int total_sem = boundary_count(num_processes);      // A semaphore per shared element
+    st_shmem* st_shared;
+    size_t bytes = shmem_size(size, width, num_processes, scratch);
+    bool huge = memory & MEMORY_HUGE;
+    bool populate = memory & MEMORY_PREFAULT;
+    int pages = PAGES_DEFAULT;
+
+    *shmid = *sems = -1;
+    if (threads) {
+        // Aligned to huge pages, so they can back it
+        void *buffer = NULL;
+        ASSERT(posix_memalign(&buffer, huge ? HUGE_PAGE_SIZE : sysconf(_SC_PAGESIZE), bytes) == 0, "Allocate buffer.");
+        if (huge && shmem_advise_huge(buffer, bytes) == 0) pages = PAGES_THP;
+        if (populate) ASSERT(shmem_prefault(buffer, bytes) != -1, "Prefault buffer.");
+        st_shared = (st_shmem *)buffer;
+        ASSERT((st_shared->locks = malloc(total_sem * sizeof(pthread_mutex_t))) != NULL, "Allocate locks.");
+        for (int i = 0; i < total_sem; i++) {
+            ASSERT(pthread_mutex_init(&st_shared->locks[i], NULL) == 0, "Init lock");
+        }
+    } else {
+        ASSERT((*sems = sem_create(IPC_PRIVATE, total_sem + MAX_BARRIERS)) != -1, "Create semaphores");
+
+        // Initialize semaphores to 1
+        for (int i = 0; i < total_sem; i++) {
+            ASSERT(sem_set(*sems, i, 1) != -1, "Set semaphore");
+        }
+
+        void *shared_memory = (void *)0;
+        if (memory & MEMORY_POSIX) {
+            // Map POSIX shared memory, inherited by the children
+            if (huge && (shared_memory = shmem_map(bytes, true)) != NULL) pages = PAGES_HUGETLB;
+            else ASSERT((shared_memory = shmem_map(bytes, false)) != NULL, "Map shared memory.");
+        } else {
+            // Create Shared Memory, sized for the array and the processes
+            if (huge && (*shmid = shmem_create_huge(IPC_PRIVATE, bytes)) != -1) pages = PAGES_HUGETLB;
+            else ASSERT((*shmid = shmem_create(IPC_PRIVATE, bytes)) != -1, "Create shared memory.");   // Create the shared memory
+            ASSERT((shared_memory = shmem_attach(*shmid)) != (void *)-1, "Attach shared memory."); // Attach the shared memory to the parent
+        }
+        if (huge && pages == PAGES_DEFAULT && shmem_advise_huge(shared_memory, bytes) == 0) pages = PAGES_THP;
+        st_shared = (st_shmem *)shared_memory;
+        st_shared->locks = NULL;
+    }
+
+    // Initialization
+    st_shared->size = size;
+    st_shared->width = width;
+    st_shared->num_processes = num_processes;
+    st_shared->scratch = scratch;
+    st_shared->threads = threads;
+    st_shared->posix = !threads && (memory & MEMORY_POSIX);
+    st_shared->pages = pages;
+    st_shared->bytes = bytes;
+    st_shared->populate = populate;     // Processes fault in their own chunks, see work
+    st_shared->first_touch = false;
+    st_shared->input_fd = -1;
+    st_shared->lock_free = false;
+    st_shared->spin = false;
+    st_shared->readcount = 0;           // Total "valid state" readers is 0
+    return st_shared;
+}
+
+/**
+ * @brief Deletes the shared memory and synchronization
+ * created by setup_sort.
+ * @param[in] st_shared st_shmem*, the shared memory.
+ * @param[in] shmid int, the shared memory id.
+ * @param[in] sems int, the semaphores id.
+ */ 
+void teardown_sort(st_shmem* st_shared, int shmid, int sems)
+{
+    if (st_shared->threads) {
+        for (int i = 0; i < boundary_count(st_shared->num_processes); i++) {
+            pthread_mutex_destroy(&st_shared->locks[i]);
+        }
+        free(st_shared->locks);
+        free(st_shared);
+        return;
+    }
+    ASSERT(sem_delete(sems) != -1, "Delete semaphores."); // Delete the semaphores
+    if (st_shared->posix) {
+        ASSERT(shmem_unmap(st_shared, st_shared->bytes, st_shared->pages == PAGES_HUGETLB) != -1, "Unmap shared memory.");
+        return;
+    }
+    ASSERT(shmem_dettach(st_shared) != -1, "Dettach shared memory."); // Dettach the shared memory
+    ASSERT(shmem_delete(shmid) != -1, "Delete shared memory."); // Delete the shared memory
+}
+
+/**
+ * @brief Sorts the shared array with num_processes child
+ * processes (or threads) running the specified algorithm.
+ * @param[in] shmem st_shmem*, the shared memory.
+ * @param[in] mode sort_mode, the algorithm.
+ * @param[in] sems int, the semaphores: the boundary semaphores,
+ * then MAX_BARRIERS barrier semaphores from index barrier.
+ * @param[in] barrier int, the first barrier semaphore.
+ * @param[out] stats run_stats*, stores the workers' CPU time, page faults and dTLB misses.
+ * @returns double, the wall-clock time in seconds.
+ */ 
+double run_sort(st_shmem* st_shared, sort_mode mode, int sems, int barrier, run_stats* stats)
+{
+    int num_processes = st_shared->num_processes;
+    int who = st_shared->threads ? RUSAGE_SELF : RUSAGE_CHILDREN;
+    pid_t pid;
+    pthread_barrierattr_t attr;
+
+    // Bubble sort rounds (see do_rounds), and phases with threads
+    ASSERT(pthread_barrierattr_init(&attr) == 0, "Init barrier attributes.");
+    ASSERT(pthread_barrierattr_setpshared(&attr, PTHREAD_PROCESS_SHARED) == 0, "Share barrier.");
+    ASSERT(pthread_barrier_init(&st_shared->round_barrier, &attr, num_processes) == 0, "Init round barrier.");
+    pthread_barrierattr_destroy(&attr);
+    pthread_mutexattr_t lock_attr;                      // Idle quick sort workers park on these
+    pthread_condattr_t cond_attr;
+    ASSERT(pthread_mutexattr_init(&lock_attr) == 0 && pthread_condattr_init(&cond_attr) == 0, "Init idle attributes.");
+    ASSERT(pthread_mutexattr_setpshared(&lock_attr, PTHREAD_PROCESS_SHARED) == 0, "Share idle lock.");
+    ASSERT(pthread_condattr_setpshared(&cond_attr, PTHREAD_PROCESS_SHARED) == 0, "Share idle condition.");
+    ASSERT(pthread_mutex_init(&st_shared->idle_lock, &lock_attr) == 0, "Init idle lock.");
+    ASSERT(pthread_cond_init(&st_shared->idle_wake, &cond_attr) == 0, "Init idle condition.");
+    pthread_mutexattr_destroy(&lock_attr);
+    pthread_condattr_destroy(&cond_attr);
+    for (int i = 0; i < ROUND_COUNTERS; i++) {
+        atomic_store(&st_shared->round_swaps[i], 0);
+    }
+
+    reset(shmem_valid(st_shared), num_processes);       // Set valid state to all false / 0
+    ws_deque* deques = shmem_deques(st_shared);         // Quick sort starts with the whole array on P1's deque
+    for (int i = 0; i < num_processes; i++) {
+        ws_init(&deques[i]);
+        shmem_work(st_shared)[i] = 0;
+    }
+    ws_push(&deques[0], (ws_task){ 0, st_shared->size });
+    atomic_store(&st_shared->unsorted, st_shared->size);
+    atomic_store(&st_shared->pushes, 0);
+    atomic_store(&st_shared->idle, 0);
+    atomic_store(&st_shared->wakes_begun, 0);
+    atomic_store(&st_shared->wakes_ended, 0);
+    for (int i = barrier; !st_shared->threads && i < barrier + MAX_BARRIERS; i++) {
+        ASSERT(sem_set(sems, i, num_processes) != -1, "Set barrier");
+    }
+
+    // Create child processes, each inherits the parent's attachment
+    // (and stdout's buffer, flushed first so the children don't print it again).
+    fflush(stdout);
+    double started = now_seconds();
+    double cpu_started;
+    long faults_started;
+    long long tlb_misses = 0;
+    int tlb_counter = tlb_counter_open();
+    resource_usage(who, &cpu_started, &faults_started);
+    if (st_shared->threads)
+    {
+        pthread_t threads[num_processes];
+        worker_args args[num_processes];
+        for (int i = 0; i < num_processes; i++)
+        {
+            args[i] = (worker_args){ st_shared, i, mode, sems, barrier };
+            ASSERT(pthread_create(&threads[i], NULL, work_thread, &args[i]) == 0, "Create thread.");
+        }
+        for (int i = 0; i < num_processes; i++)
+        {
+            ASSERT(pthread_join(threads[i], NULL) == 0, "Join thread.");
+        }
+    }
+    else
+    {
+        for (int i = 0; i < num_processes; i++)
+        {
+            ASSERT((pid = fork()) > -1, "Fork child.");  // Fork failed
+            if (pid == 0)
+            {
+                // Process P(i + 1)
+                work(st_shared, i, mode, sems, barrier);
+                if (!st_shared->posix)  // The POSIX mapping goes with the process
+                    ASSERT(shmem_dettach(st_shared) != -1, "Dettach shared memory."); // Dettach the shared memory
+                exit(EXIT_SUCCESS);
+            }
+        }
+        wait_n_children(num_processes);     // Wait for the children to exit
+    }
+
+    double elapsed = now_seconds() - started;
+    resource_usage(who, &stats->cpu, &stats->faults);
+    stats->cpu -= cpu_started;
+    stats->faults -= faults_started;
+    stats->tlb_misses = -1;
+    if (tlb_counter != -1) {
+        if (read(tlb_counter, &tlb_misses, sizeof(tlb_misses)) == sizeof(tlb_misses)) stats->tlb_misses = tlb_misses;
+        close(tlb_counter);
+    }
+    pthread_barrier_destroy(&st_shared->round_barrier);
+    pthread_cond_destroy(&st_shared->idle_wake);
+    pthread_mutex_destroy(&st_shared->idle_lock);
+    return elapsed;
+}
+
+// A sorted run being merged, see merge_runs
+typedef struct {
+    char* buf;              // Read buffer
+    size_t pos;             // Next byte in buf
+    size_t len;             // Bytes in buf
+    long long offset;       // Next byte of the run in the runs file
+    long long end;          // End of the run in the runs file
+} merge_run;
+
+/**
+ * @brief Returns the key of the next byte of run r, refilling
+ * its buffer when empty: 0 to 255, or BUCKETS once exhausted.
+ * @param[in] run merge_run*, the run.
+ * @param[in] fd int, the runs file.
+ * @returns int, the key.
+ */ 
+static inline int run_next(merge_run* run, int fd)
+{
+    if (run->pos == run->len)
+    {
+        if (run->offset == run->end) return BUCKETS;
+        run->len = (run->end - run->offset < MERGE_BUFFER) ? run->end - run->offset : MERGE_BUFFER;
+        ASSERT(read_fully(fd, run->buf, run->len, run->offset), "Read run.");
+        run->offset += run->len;
+        run->pos = 0;
+        // Read ahead the next buffer while this one is merged
+        if (run->offset < run->end) posix_fadvise(fd, run->offset, MERGE_BUFFER, POSIX_FADV_WILLNEED);
+    }
+    return (unsigned char)run->buf[run->pos++];
+}
+
+/**
+ * @brief Merges the sorted runs of the runs file within bytes
+ * [start, end), run r being bytes [start + r * run_bytes, min(start +
+ * (r + 1) * run_bytes, end)), into the same bytes of the output file
+ * with a loser tree: each byte costs log2(k) comparisons along a single
+ * leaf-to-root path. Runs are read through MERGE_BUFFER buffers with
+ * readahead, the output written in OUTPUT_BUFFER blocks.
+ * @param[in] runs_fd int, the runs file.
+ * @param[in] start long long, the first byte of the first run.
+ * @param[in] end long long, the end of the last run.
+ * @param[in] run_bytes size_t, the bytes per run.
+ * @param[in] output_fd int, the output file.
+ */ 
+void merge_group(int runs_fd, long long start, long long end, size_t run_bytes, int output_fd)
+{
+    int k = (end - start + run_bytes - 1) / run_bytes;
+    merge_run* runs = malloc(k * sizeof(merge_run));
+    int* tree = malloc(k * sizeof(int));
+    int* keys = malloc((k + 1) * sizeof(int));
+    char* out = malloc(OUTPUT_BUFFER);
+    ASSERT(runs != NULL && tree != NULL && keys != NULL && out != NULL, "Allocate merge.");
+
+    for (int r = 0; r < k; r++)
+    {
+        ASSERT((runs[r].buf = malloc(MERGE_BUFFER)) != NULL, "Allocate run buffer.");
+        runs[r].pos = runs[r].len = 0;
+        runs[r].offset = start + (long long)r * run_bytes;
+        runs[r].end = (runs[r].offset + run_bytes < end) ? runs[r].offset + run_bytes : end;
+        keys[r] = run_next(&runs[r], runs_fd);
+    }
+
+    // Build: every node starts with the virtual run k, then each leaf plays up
+    keys[k] = -1;
+    for (int t = 0; t < k; t++) tree[t] = k;
+    for (int r = k - 1; r >= 0; r--) loser_tree_adjust(tree, keys, r, k);
+
+    size_t used = 0;
+    long long written = start;
+    int winner = (k > 0) ? tree[0] : k;
+    while (winner < k && keys[winner] != BUCKETS)
+    {
+        out[used++] = keys[winner];
+        keys[winner] = run_next(&runs[winner], runs_fd);
+        loser_tree_adjust(tree, keys, winner, k);
+        winner = tree[0];
+        if (used == OUTPUT_BUFFER)
+        {
+            ASSERT(write_fully(output_fd, out, used, written), "Write output.");
+            written += used;
+            used = 0;
+        }
+    }
+    ASSERT(write_fully(output_fd, out, used, written), "Write output.");
+
+    for (int r = 0; r < k; r++) free(runs[r].buf);
+    free(runs); free(tree); free(keys); free(out);
+}
+
+/**
+ * @brief Creates a temporary file next to the output, deleted once closed.
+ * @param[in] output char*, the output file.
+ * @param[in] suffix char*, appended to the output's name.
+ * @returns int, the file descriptor.
+ */ 
+int temporary_file(const char* output, const char* suffix)
+{
+    int fd;
+    char path[strlen(output) + strlen(suffix) + 8];
+    sprintf(path, "%s%s.XXXXXX", output, suffix);
+    ASSERT((fd = mkstemp(path)) != -1, "Create temporary file.");
+    unlink(path);
+    return fd;
+}
+
+/**
+ * @brief Merges the sorted runs of run_bytes of the runs file into the
+ * output file, at most MERGE_FAN_IN runs at once so the read buffers
+ * stay within MERGE_FAN_IN * MERGE_BUFFER bytes. With more runs, each
+ * pass merges every MERGE_FAN_IN consecutive runs into one, in place of
+ * them in a second temporary file, until MERGE_FAN_IN runs or fewer are
+ * left for the final merge, see merge_group.
+ * @param[in] runs_fd int, the runs file.
+ * @param[in] total long long, the bytes in all runs.
+ * @param[in] run_bytes size_t, the bytes per run.
+ * @param[in] output char*, the output file, the pass file is created next to it.
+ * @param[in] output_fd int, the output file.
+ * @returns int, the number of passes.
+ */ 
+int merge_runs(int runs_fd, long long total, size_t run_bytes, const char* output, int output_fd)
+{
+    int passes = 1;
+    int pass_fd = -1, first_fd = runs_fd;
+    posix_fadvise(runs_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    for (; (total + run_bytes - 1) / run_bytes > MERGE_FAN_IN; passes++)
+    {
+        if (pass_fd == -1) pass_fd = temporary_file(output, ".pass");
+        size_t group_bytes = run_bytes * MERGE_FAN_IN;
+        for (long long start = 0; start < total; start += group_bytes)
+        {
+            long long end = (start + group_bytes < total) ? start + group_bytes : total;
+            merge_group(runs_fd, start, end, run_bytes, pass_fd);
+        }
+        DPRINTF("[Debug] Merge pass %d: %lld runs into %lld.\n", passes,
+            (total + run_bytes - 1) / run_bytes, (total + group_bytes - 1) / group_bytes);
+
+        // The merged runs are the next pass's input
+        int swap = runs_fd;
+        runs_fd = pass_fd;
+        pass_fd = swap;
+        run_bytes = group_bytes;
+        posix_fadvise(runs_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+    merge_group(runs_fd, 0, total, run_bytes, output_fd);
+
+    // Close whichever of the two files is the pass file, the caller closes its runs file
+    if (pass_fd != -1) close(runs_fd == first_fd ? pass_fd : runs_fd);
+    return passes;
+}
+
+/**
+ * @brief Returns whether the bytes of the file fd are sorted.
+ * @param[in] fd int, the file.
+ * @param[in] total long long, the file size.
+ * @returns true if sorted, false otherwise.
+ */ 
+bool is_file_sorted(int fd, long long total)
+{
+    char* buf = malloc(OUTPUT_BUFFER);
+    unsigned char last = 0;
+    bool sorted = true;
+    ASSERT(buf != NULL, "Allocate buffer.");
+    for (long long offset = 0; sorted && offset < total; offset += OUTPUT_BUFFER)
+    {
+        size_t n = (total - offset < OUTPUT_BUFFER) ? total - offset : OUTPUT_BUFFER;
+        ASSERT(read_fully(fd, buf, n, offset), "Read output.");
+        for (size_t i = 0; sorted && i < n; i++)
+        {
+            sorted = ((unsigned char)buf[i] >= last);
+            last = buf[i];
+        }
+    }
+    free(buf);
+    return sorted;
+}
+
+/**
+ * @brief Prints how evenly sample or quick sort spread the work:
+ * the letters the busiest worker went over against the mean, and
+ * the tasks stolen in quick sort.
+ * @param[in] st_shared st_shmem*, the shared memory, after run_sort.
+ * @param[in] mode sort_mode, the algorithm that ran.
+ */ 
+void print_balance(st_shmem* st_shared, sort_mode mode)
+{
+    if (mode != MODE_SAMPLE && mode != MODE_QUICK) return;
+    size_t* work = shmem_work(st_shared);
+    size_t busiest = 0, total = 0;
+    long steals = 0;
+    for (int i = 0; i < st_shared->num_processes; i++)
+    {
+        if (work[i] > busiest) busiest = work[i];
+        total += work[i];
+        steals += atomic_load(&shmem_deques(st_shared)[i].steals);
+    }
+    printf("  Balance: the busiest worker went over %.2fx the mean letters (%zu of %zu)", (total > 0) ?
+        (double)busiest * st_shared->num_processes / total : 1.0, busiest, total);
+    if (mode == MODE_QUICK) printf(", %ld tasks stolen", steals);
+    printf(".\n");
+}
+
+/**
+ * @brief Sorts the bytes of the input file into the output file,
+ * for files larger than the memory. Run generation: the workers read
+ * a run of run_bytes into the shared memory (each its chunk, see work),
+ * sort it with the specified algorithm and spill it to a temporary runs
+ * file next to the output. Runs too short to split are sorted by the
+ * parent. Merge: the parent merges the runs, in several passes past
+ * MERGE_FAN_IN runs, see merge_runs.
+ * @param[in] input char*, the input file.
+ * @param[in] output char*, the output file.
+ * @param[in] run_bytes size_t, the bytes per run, the shared memory holds the run and a scratch copy.
+ * @param[in] mode sort_mode, the algorithm, not MODE_BUBBLE.
+ * @param[in] threads bool, whether the workers are threads.
+ * @param[in] num_processes int, the number of workers.
+ * @param[in] memory int, the MEMORY_ options.
+ * @param[in] first_touch bool, whether workers fault in their chunks of arr and tmp first.
+ */ 
+void external_sort(const char* input, const char* output, size_t run_bytes, sort_mode mode,
+    bool threads, int num_processes, int memory, bool first_touch)
+{
+    int input_fd, output_fd, runs_fd;
+    struct stat st;
+    ASSERT((input_fd = open(input, O_RDONLY)) != -1, "Open input.");
+    ASSERT(fstat(input_fd, &st) != -1, "Stat input.");
+    ASSERT((output_fd = open(output, O_RDWR | O_CREAT | O_TRUNC, 0666)) != -1, "Open output.");
+    long long total = st.st_size;
+    if (run_bytes > total) run_bytes = total > 0 ? total : 1;
+
+    runs_fd = temporary_file(output, ".runs");
+    posix_fadvise(input_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    // Run generation
+    int mutex, shmid;
+    int barrier = boundary_count(num_processes);
+    double started = now_seconds();
+    st_shmem* st_shared = setup_sort(threads, run_bytes, 1, num_processes, true, memory, &shmid, &mutex);
+    st_shared->first_touch = first_touch;
+    st_shared->input_fd = input_fd;
+    st_shared->runs_fd = runs_fd;
+    int k = 0;
+    run_stats stats;
+    for (long long offset = 0; offset < total; offset += run_bytes, k++)
+    {
+        size_t n = (total - offset < run_bytes) ? total - offset : run_bytes;
+        st_shared->run_offset = offset;
+        if (n >= 2 * (size_t)num_processes) {
+            st_shared->size = n;
+            run_sort(st_shared, mode, mutex, barrier, &stats);
+        } else {
+            char* arr = shmem_arr(st_shared);
+            ASSERT(read_fully(input_fd, arr, n, offset), "Read run.");
+            qsort(arr, n, 1, compare_chars);
+            ASSERT(write_fully(runs_fd, arr, n, offset), "Write run.");
+        }
+        DPRINTF("[Debug] Run %d: %zu bytes sorted and spilled.\n", k + 1, n);
+    }
+    teardown_sort(st_shared, shmid, mutex);
+    double generated = now_seconds() - started;
+
+    // Merge
+    started = now_seconds();
+    int passes = merge_runs(runs_fd, total, run_bytes, output, output_fd);
+    double merged = now_seconds() - started;
+
+    double mb = total / 1e6;
+    printf("External sort of %s (%.1f MB) into %s with %d %s (%s sort), %d runs of %.1f MiB, %d merge pass%s:\n",
+        input, mb, output, num_processes, threads ? "threads" : "processes", mode_names[mode], k, run_bytes / 1048576.0,
+        passes, passes > 1 ? "es" : "");
+    printf("  run generation %.3fs (%.1f MB/s), merge %.3fs (%.1f MB/s), total %.3fs (%.1f MB/s) (%s).\n",
+        generated, mb / generated, merged, mb / merged, generated + merged, mb / (generated + merged),
+        is_file_sorted(output_fd, total) ? "verified" : "NOT SORTED");
+    close(runs_fd); close(output_fd); close(input_fd);
+}
+
+/**
+ * @brief Writes n random lowercase letters to the file path.
+ * @param[in] path char*, the file.
+ * @param[in] n long long, the number of letters.
+ * @param[in] seed unsigned int, the random seed.
+ */ 
+void random_file(const char* path, long long n, unsigned int seed)
+{
+    int fd;
+    char* buf = malloc(OUTPUT_BUFFER);
+    ASSERT(buf != NULL, "Allocate buffer.");
+    ASSERT((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666)) != -1, "Open input.");
+    for (long long offset = 0; offset < n; offset += OUTPUT_BUFFER)
+    {
+        size_t len = (n - offset < OUTPUT_BUFFER) ? n - offset : OUTPUT_BUFFER;
+        random_array(buf, len, seed + offset / OUTPUT_BUFFER);
+        ASSERT(write_fully(fd, buf, len, offset), "Write input.");
+    }
+    close(fd);
+    free(buf);
+}
+
+/**
+ * @brief Returns whether a block is sorted, see sort_block.
+ * @param[in] type int, 0 for letters, 1 for int32_t, 2 for float.
+ * @param[in] block void*, the block.
+ * @param[in] n size_t, the number of elements.
+ * @returns true if sorted, false otherwise.
+ */ 
+bool is_block_sorted(int type, const void* block, size_t n)
+{
+    for (size_t i = 1; i < n; i++)
+    {
+        if (type == 0 && ((const unsigned char *)block)[i] < ((const unsigned char *)block)[i - 1]) return false;
+        if (type == 1 && ((const int32_t *)block)[i] < ((const int32_t *)block)[i - 1]) return false;
+        if (type == 2 && ((const float *)block)[i] < ((const float *)block)[i - 1]) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Sorts a block with insertion sort, qsort or the sorting
+ * networks, see benchmark_networks.
+ * @param[in] type int, 0 for letters, 1 for int32_t, 2 for float.
+ * @param[in] method int, -2 for insertion sort, -1 for qsort, else the network_isa.
+ * @param[inout] block void*, the block.
+ * @param[in] n size_t, the number of elements.
+ */ 
+void sort_block(int type, int method, void* block, size_t n)
+{
+    typedef void (*block_sort)(void*, size_t);
+    static const block_sort insertion[] = { (block_sort)insertion_sort_char, (block_sort)insertion_sort_i32, (block_sort)insertion_sort_f32 };
+    static const block_sort network[] = { (block_sort)network_sort_char, (block_sort)network_sort_i32, (block_sort)network_sort_f32 };
+    static int (*compare[])(const void*, const void*) = { compare_chars, compare_i32, compare_f32 };
+    static const size_t widths[] = { 1, sizeof(int32_t), sizeof(float) };
+    if (method == -2) insertion[type](block, n);
+    else if (method == -1) qsort(block, n, widths[type], compare[type]);
+    else network[type](block, n);
+}
+
+/**
+ * @brief Times sorting blocks of 8, 16 and 32 letters, integers and
+ * floats with insertion sort, qsort and the sorting networks on each
+ * instruction set the CPU supports, and prints the best time per block.
+ * @param[in] seed unsigned int, the random seed.
+ */ 
+void benchmark_networks(unsigned int seed)
+{
+    const char* types[] = { "char", "int32", "float" };
+    const size_t widths[] = { 1, sizeof(int32_t), sizeof(float) };
+    network_isa selected = network_selected();
+    char* pool = malloc((size_t)NETWORK_BLOCKS * NETWORK_MAX * sizeof(float));
+    char block[NETWORK_MAX * sizeof(float)];
+    ASSERT(pool != NULL, "Allocate blocks.");
+    srand(seed);
+
+    printf("ns per block, best of %d times %d blocks, copying each block in excluded (%s selected):\n%-6s %3s %10s %10s",
+        NETWORK_REPEATS, NETWORK_BLOCKS, network_isa_names[selected], "type", "n", "insertion", "qsort");
+    for (int isa = 0; isa < NETWORK_ISAS; isa++) printf(" %10s", network_isa_names[isa]);
+    printf("\n");
+    for (int type = 0; type < 3; type++)
+    {
+        for (size_t i = 0; i < (size_t)NETWORK_BLOCKS * NETWORK_MAX; i++)
+        {
+            if (type == 0) pool[i] = 'a' + rand() % 26;
+            else if (type == 1) ((int32_t *)pool)[i] = rand() - RAND_MAX / 2;
+            else ((float *)pool)[i] = (rand() - RAND_MAX / 2) / 1024.0f;
+        }
+        for (size_t n = 8; n <= NETWORK_MAX; n *= 2)
+        {
+            printf("%-6s %3zu", types[type], n);
+            double copying = 0;
+            for (int method = -3; method < NETWORK_ISAS; method++)
+            {
+                if (method >= 0 && network_select(method) == -1) {
+                    printf(" %10s", "n/a");
+                    continue;
+                }
+                double best = 0;
+                for (int repeat = 0; repeat < NETWORK_REPEATS; repeat++)
+                {
+                    double started = now_seconds();
+                    for (int b = 0; b < NETWORK_BLOCKS; b++)
+                    {
+                        memcpy(block, pool + (size_t)b * NETWORK_MAX * widths[type], n * widths[type]);
+                        if (method > -3) sort_block(type, method, block, n);
+                    }
+                    double elapsed = now_seconds() - started;
+                    if (repeat == 0 || elapsed < best) best = elapsed;
+                }
+                ASSERT(method == -3 || is_block_sorted(type, block, n), "Sort block.");
+                if (method == -3) copying = best;
+                else printf(" %10.1f", (best - copying) * 1e9 / NETWORK_BLOCKS);
+            }
+            printf("\n");
+        }
+    }
+    network_select(selected);
+    free(pool);
+}
+
+int main(int argc, char* argv[])
+{
+    // Parse the options
+    size_t size = SIZE;                                 // Elements to sort
+    int num_processes = DEFAULT_PROCESSES;              // Sorting processes
+    unsigned int seed = 1;                              // Seed for random elements
+    bool prompt = true;                                 // Whether to prompt for the elements
+    sort_mode mode = MODE_BUBBLE;                       // Sorting algorithm
+    bool compare = false;                               // Whether to time the alternatives too
+    int width = 1;                                      // Bytes per element, letters by default
+    bool lock_free = false;                             // Whether bubble sort uses atomics
+    bool spin = false;                                  // Whether bubble sort spins on the valid flags
+    bool threads = false;                               // Whether the workers are threads
+    int memory = 0;                                     // MEMORY_ options
+    bool first_touch = false;                           // Whether workers fault in their chunk first
+    const char* input_path = NULL;                      // External sort input file
+    const char* output_path = NULL;                     // External sort output file
+    size_t run_mb = DEFAULT_RUN_MB;                     // External sort run size
+    bool set_mode = false;                              // Whether -m was given
+    bool benchmark = false;                             // Whether to time the sorting networks instead
+    bool skewed = false;                                // Whether the random letters are skewed
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            size = strtoull(argv[++i], NULL, 10);
+            prompt = false;
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            num_processes = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seed = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-d") == 0) {
+            debug_mode = true;
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc && strcmp(argv[i + 1], "bubble") == 0) {
+            mode = MODE_BUBBLE; set_mode = true; i++;
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc && strcmp(argv[i + 1], "sample") == 0) {
+            mode = MODE_SAMPLE; set_mode = true; i++;
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc && strcmp(argv[i + 1], "counting") == 0) {
+            mode = MODE_COUNTING; set_mode = true; i++;
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc && strcmp(argv[i + 1], "radix") == 0) {
+            mode = MODE_RADIX; set_mode = true; i++;
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc && strcmp(argv[i + 1], "quick") == 0) {
+            mode = MODE_QUICK; set_mode = true; i++;
+        } else if (strcmp(argv[i], "-z") == 0) {
+            skewed = true;
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc && strcmp(argv[i + 1], "spin") == 0) {
+            spin = true; i++;
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc && strcmp(argv[i + 1], "processes") == 0) {
+            threads = false; i++;
+        } else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc && strcmp(argv[i + 1], "threads") == 0) {
+            threads = true; i++;
+        } else if (strcmp(argv[i], "-M") == 0 && i + 1 < argc && strcmp(argv[i + 1], "sysv") == 0) {
+            memory &= ~MEMORY_POSIX; i++;
+        } else if (strcmp(argv[i], "-M") == 0 && i + 1 < argc && strcmp(argv[i + 1], "posix") == 0) {
+            memory |= MEMORY_POSIX; i++;
+        } else if (strcmp(argv[i], "-H") == 0) {
+            memory |= MEMORY_HUGE;
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc && strcmp(argv[i + 1], "populate") == 0) {
+            memory |= MEMORY_PREFAULT; i++;
+        } else if (strcmp(argv[i], "-f") == 0 && i + 1 < argc && strcmp(argv[i + 1], "touch") == 0) {
+            first_touch = true; i++;
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            input_path = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            run_mb = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-v") == 0 && i + 1 < argc) {
+            int isa = 0;
+            while (isa < NETWORK_ISAS && strcmp(argv[i + 1], network_isa_names[isa]) != 0) isa++;
+            if (network_select(isa) == -1) {
+                printf("The sorting networks can't run on %s here.\n", argv[i + 1]);
+                usage(argv[0]); exit(EXIT_FAILURE);
+            }
+            i++;
+        } else if (strcmp(argv[i], "-k") == 0) {
+            benchmark = true;
+        } else if (strcmp(argv[i], "-a") == 0) {
+            lock_free = true;
+        } else if (strcmp(argv[i], "-c") == 0) {
+            compare = true;
+        } else {
+            usage(argv[0]); exit(EXIT_FAILURE);
+        }
+    }
+    if (benchmark) {
+        benchmark_networks(seed);
+        exit(EXIT_SUCCESS);
+    }
+
+    // External sort of a file, generated first with -n
+    if (input_path != NULL) {
+        if (!set_mode) mode = MODE_SAMPLE;
+        if (output_path == NULL || mode == MODE_BUBBLE || width != 1 || run_mb < 1 || num_processes < 1) {
+            usage(argv[0]); exit(EXIT_FAILURE);
+        }
+        if (!prompt) random_file(input_path, size, seed);
+        external_sort(input_path, output_path, run_mb << 20, mode, threads, num_processes, memory, first_touch);
+        exit(EXIT_SUCCESS);
+    }
+
+    // Every range needs two elements, one of which it shares.
+    if (size < 2 || num_processes < 1 || (size_t)num_processes > size - 1) {
+        usage(argv[0]); exit(EXIT_FAILURE);
+    }
+    // Integer keys are random and only radix sorted.
+    if (width != 1 && ((width != 2 && width != 4 && width != 8) || mode != MODE_RADIX || prompt)) {
+        usage(argv[0]); exit(EXIT_FAILURE);
+    }
+
+    // Create the shared memory and semaphores, timed as the startup
+    int barrier = boundary_count(num_processes);        // The barriers for the other sorts follow the boundaries
+    int mutex, shmid;                                   // Semaphore and shared memory IDs
+    bool scratch = (mode == MODE_SAMPLE || mode == MODE_RADIX || compare);  // Sample and radix sort need tmp
+    double started = now_seconds();
+    st_shmem* st_shared = setup_sort(threads, size, width, num_processes, scratch, memory, &shmid, &mutex);
+    double startup = now_seconds() - started;
+    st_shared->lock_free = lock_free;
+    st_shared->spin = spin;
+    st_shared->first_touch = first_touch;
+
+    char* arr = shmem_arr(st_shared);
+    if (prompt) {
+        debug_prompt();                 // Prompt the user to select the run mode
+        init_array(arr, size);          // Initialize the array to be sorted
+    } else if (width == 1 && skewed) {
+        skewed_array(arr, size, seed);  // Or fill it with skewed random letters
+    } else if (width == 1) {
+        random_array(arr, size, seed);  // Or fill it with random letters
+    } else {
+        random_keys(arr, size, width, seed);    // Or random integer keys
+    }
+
+    // Keep the input to sort again with the alternatives
+    char* input = NULL;
+    if (compare) {
+        ASSERT((input = malloc(size * width)) != NULL, "Allocate input copy.");
+        memcpy(input, arr, size * width);
+    }
+
+    const char* workers = threads ? "threads" : "processes";
+    run_stats stats;                    // CPU time, page faults and dTLB misses of the sorting workers
+    double elapsed = run_sort(st_shared, mode, mutex, barrier, &stats);
+    if (size <= MAX_PRINT) {
+        printf("Sorted Array: ");
+        print_array(arr, size, width);  // Print the resulting sorted array
+    }
+    printf("Sorted %zu elements with %d %s (%s sort%s%s) in %.3fs after a %.3fms startup, CPU %.3fs (%s).\n", size, num_processes,
+        workers, mode_names[mode], (mode == MODE_BUBBLE && lock_free) ? ", atomic" : "", (mode == MODE_BUBBLE && spin) ? ", spin" : "",
+        elapsed, startup * 1e3, stats.cpu, is_sorted(arr, size, width) ? "verified" : "NOT SORTED");
+    char tlb_misses[32] = "n/a";
+    if (stats.tlb_misses >= 0) snprintf(tlb_misses, sizeof(tlb_misses), "%lld", stats.tlb_misses);
+    printf("Memory: %s, %s pages%s%s, %ld page faults, %s dTLB load misses while sorting.\n",
+        threads ? "heap" : st_shared->posix ? "POSIX shared" : "SysV shared", page_names[st_shared->pages],
+        (memory & MEMORY_PREFAULT) ? (threads ? ", prefaulted" : ", prefaulted by worker") : "", first_touch ? ", first touch by worker" : "", stats.faults, tlb_misses);
+    print_balance(st_shared, mode);
+
+    if (compare) {
+        // Another algorithm on the same input and workers, letters only
+        sort_mode others[] = { MODE_SAMPLE, MODE_BUBBLE, MODE_SAMPLE, MODE_COUNTING, MODE_SAMPLE };
+        sort_mode other = others[mode];
+        if (width != 1) {
+            // Only radix sort handles integer keys
+        } else if (other == MODE_BUBBLE && size > BUBBLE_COMPARE_MAX) {
+            printf("  %s sort: skipped, O(n^2) over %d elements.\n", mode_names[other], BUBBLE_COMPARE_MAX);
+        } else {
+            memcpy(arr, input, size);
+            double other_elapsed = run_sort(st_shared, other, mutex, barrier, &stats);
+            printf("  %s sort, %d %s: %.3fs, CPU %.3fs (%s), speedup %.2fx.\n", mode_names[other], num_processes, workers,
+                other_elapsed, stats.cpu, is_sorted(arr, size, width) ? "verified" : "NOT SORTED", other_elapsed / elapsed);
+            print_balance(st_shared, other);
+        }
+
+        // The same sort with the other backend, startup included
+        int other_shmid, other_sems;
+        started = now_seconds();
+        st_shmem* other_shared = setup_sort(!threads, size, width, num_processes, scratch, memory, &other_shmid, &other_sems);
+        double other_startup = now_seconds() - started;
+        other_shared->lock_free = lock_free;
+        other_shared->spin = spin;
+        other_shared->first_touch = first_touch;
+        memcpy(shmem_arr(other_shared), input, size * width);
+        double other_elapsed = run_sort(other_shared, mode, other_sems, barrier, &stats);
+        printf("  %d %s: %.3fs after a %.3fms startup, CPU %.3fs (%s), speedup %.2fx.\n", num_processes,
+            threads ? "processes" : "threads", other_elapsed, other_startup * 1e3, stats.cpu,
+            is_sorted(shmem_arr(other_shared), size, width) ? "verified" : "NOT SORTED",
+            (other_startup + other_elapsed) / (startup + elapsed));
+        teardown_sort(other_shared, other_shmid, other_sems);
+
+        // Single-process qsort, in place on the copy
+        started = now_seconds();
+        qsort(input, size, width, compare_width(width));
+        double qsort_elapsed = now_seconds() - started;
+        printf("  qsort, 1 process: %.3fs, speedup %.2fx.\n", qsort_elapsed, qsort_elapsed / elapsed);
+        free(input);
+    }
+
+    teardown_sort(st_shared, shmid, mutex);
 
     exit(EXIT_SUCCESS);
 }
@@ -41,6 +41,19 @@ int sem_signal(int semid, int sem_num)
     return semop(semid, &sem_b, 1);
 }
 
+int sem_barrier(int semid, int sem_num)
+{
+    struct sembuf sem_b;
+    sem_b.sem_num = sem_num;
+    sem_b.sem_op = -1;          // Arrive by decrementing
+    sem_b.sem_flg = 0;          // No undo, the arrival stands once all have passed
+
+    if (semop(semid, &sem_b, 1) == -1) return -1;
+
+    sem_b.sem_op = 0;           // Then wait for everyone else to arrive
+    return semop(semid, &sem_b, 1);
+}
+
 int semGetValue(int semid, int semaphore_number)
 {
   union semun arg;
@@ -45,3 +45,14 @@ int sem_signal(int semid, int sem_num);
  * @returns 0 on success, -1 otherwise.
  */ 
 int sem_wait(int semid, int sem_num);
+
+/**
+ * @brief Waits at the barrier held by the sem_num semaphore
+ * associated with semid until all processes have reached it.
+ * The semaphore must first be set to the number of processes
+ * and is used up once they have all passed (value 0).
+ * @param semid int, the semaphore id.
+ * @param sem_num int, the semaphore index.
+ * @returns 0 on success, -1 otherwise.
+ */ 
+int sem_barrier(int semid, int sem_num);
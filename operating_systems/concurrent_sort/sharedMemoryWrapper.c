@@ -1,6 +1,15 @@
-#include "SharedMemoryWrapper.h"
+#define _GNU_SOURCE
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
-int shmem_create(key_t key, int size)
+#include "sharedMemoryWrapper.h"
+
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23  // Linux 5.14, missing from older headers
+#endif
+
+int shmem_create(key_t key, size_t size)
 {
 	return shmget(key, size, IPC_CREAT | 0666);
 }
@@ -19,3 +28,48 @@ int shmem_delete(int shmid)
 {
     return shmctl(shmid, IPC_RMID, 0);
 }
+
+int shmem_create_huge(key_t key, size_t size)
+{
+    size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    return shmget(key, size, IPC_CREAT | SHM_HUGETLB | 0666);
+}
+
+void* shmem_map(size_t size, bool huge)
+{
+    int fd;
+    if (huge) size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    if ((fd = memfd_create("shmem", huge ? MFD_HUGETLB : 0)) == -1) return NULL;
+    if (ftruncate(fd, size) == -1) { close(fd); return NULL; }
+
+    void* shmaddr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);                  // The mapping keeps the memory alive
+    return shmaddr == MAP_FAILED ? NULL : shmaddr;
+}
+
+int shmem_unmap(void* shmaddr, size_t size, bool huge)
+{
+    if (huge) size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    return munmap(shmaddr, size);
+}
+
+int shmem_advise_huge(void* shmaddr, size_t size)
+{
+    return madvise(shmaddr, size, MADV_HUGEPAGE);
+}
+
+int shmem_prefault(void* shmaddr, size_t size)
+{
+    if (size == 0) return 0;
+    uintptr_t page = sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)shmaddr, first = start / page * page;
+    if (madvise((void *)first, start + size - first, MADV_POPULATE_WRITE) == 0) return 0;
+
+    // Touch a byte of every page instead, keeping its contents, and
+    // only bytes of the range: the rest of its pages may be in use
+    for (uintptr_t byte = start; byte < start + size; byte = (byte / page + 1) * page)
+    {
+        *(volatile char *)byte = *(volatile char *)byte;
+    }
+    return 0;
+}
@@ -1,14 +1,17 @@
+#include <stdbool.h>
 #include <sys/types.h>
 #include <sys/shm.h>
 
+#define HUGE_PAGE_SIZE (2UL << 20)    // Huge page size rounded to by shmem_create_huge
+
 /**
  * @brief Creates a shared memory instance 
  * identified by key and of size size.
  * @param key key_t, the shared memory key.
- * @param size int, the sie of the shared memory.
+ * @param size size_t, the size of the shared memory in bytes.
  * @returns The shared memory id if success, -1 otherwise.
  */ 
-int shmem_create(key_t key, int size);
+int shmem_create(key_t key, size_t size);
 
 /**
  * @brief Attaches the shared memory specified by
@@ -33,3 +36,58 @@ int shmem_dettach(const void* shmaddr);
  * @returns 0 on success, -1 otherwise.
  */ 
 int shmem_delete(int shmid);
+
+/**
+ * @brief Creates a shared memory instance identified by key
+ * and of size size (rounded up to HUGE_PAGE_SIZE), backed by
+ * huge pages (SHM_HUGETLB). Fails if the system has too
+ * few huge pages reserved (see /proc/sys/vm/nr_hugepages).
+ * @param key key_t, the shared memory key.
+ * @param size size_t, the size of the shared memory in bytes.
+ * @returns The shared memory id if success, -1 otherwise.
+ */ 
+int shmem_create_huge(key_t key, size_t size);
+
+/**
+ * @brief Creates and maps an anonymous POSIX shared memory
+ * (memfd) instance of size size, shared with the children
+ * forked afterwards.
+ * @param size size_t, the size of the shared memory in bytes.
+ * @param huge bool, whether to back it with huge pages (MFD_HUGETLB,
+ * size rounded up to HUGE_PAGE_SIZE), if the system has them reserved.
+ * @returns a pointer to the shared memory block
+ * if successful, null otherwise.
+ */ 
+void* shmem_map(size_t size, bool huge);
+
+/**
+ * @brief Unmaps the shared memory mapped by shmem_map.
+ * @param shmaddr void*, the shared memory pointer.
+ * @param size size_t, the size passed to shmem_map.
+ * @param huge bool, the huge passed to shmem_map.
+ * @returns 0 on success, -1 otherwise.
+ */ 
+int shmem_unmap(void* shmaddr, size_t size, bool huge);
+
+/**
+ * @brief Asks for the memory at shmaddr to be backed by
+ * transparent huge pages (MADV_HUGEPAGE). For shared memory,
+ * this needs /sys/kernel/mm/transparent_hugepage/shmem_enabled
+ * to be "advise" or "always".
+ * @param shmaddr void*, the memory pointer, page aligned.
+ * @param size size_t, the size of the memory in bytes.
+ * @returns 0 on success, -1 otherwise.
+ */ 
+int shmem_advise_huge(void* shmaddr, size_t size);
+
+/**
+ * @brief Faults in all pages of the memory at shmaddr for
+ * writing (MADV_POPULATE_WRITE, or by touching each page
+ * on kernels older than 5.14), so later accesses don't fault.
+ * Only the calling process's page table is filled, a forked
+ * process must fault in shared memory itself.
+ * @param shmaddr void*, the memory pointer.
+ * @param size size_t, the size of the memory in bytes.
+ * @returns 0 on success, -1 otherwise.
+ */ 
+int shmem_prefault(void* shmaddr, size_t size);
@@ -1,12 +1,154 @@
 #include <stdbool.h>
-#define SIZE 7  
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "workStealing.h"
+#define SIZE 7                  // Letters sorted when prompting the user
+#define DEFAULT_PROCESSES 3     // Sorting processes unless set with -p
+#define BUCKETS 256             // Histogram buckets, one per byte value
+#define ROUND_COUNTERS 3        // Swap counters used in turn by bubble sort rounds
 
 // Shared memory struct
 typedef struct st_shmem
 {
-    char arr[SIZE];     // Array to be sorted
-    bool valid[3];      // Stores whether process P_i has finished 
-                        // sorting for a cycle in valid[i - 1]
-                        
+    size_t size;        // Number of elements in the array
+    int width;          // Bytes per element: 1 for letters, else an unsigned integer key
+    int num_processes;  // Number of sorting processes
+    bool scratch;       // Whether tmp is allocated (sample and radix sort)
+    bool lock_free;     // Whether bubble sort exchanges shared elements with atomics instead of semaphores
+    bool spin;          // Whether bubble sort ends by spinning on the valid flags instead of in rounds
+    bool threads;       // Whether the workers are threads (heap buffer) instead of processes
+    bool posix;         // Whether the memory is POSIX (memfd) shared memory instead of SysV
+    bool populate;      // Whether the memory is prefaulted: at setup with threads, else by each worker, its chunks
+    bool first_touch;   // Whether each worker faults in its chunks of arr and tmp by writing them before sorting
+    int pages;          // PAGES_DEFAULT, PAGES_THP or PAGES_HUGETLB, see setup_sort in CSORT.c
+    size_t bytes;       // Size of the memory, as passed to shmem_size
+    int input_fd;       // External sort: file the workers read their chunk of the run from, -1 if none
+    int runs_fd;        // External sort: file the workers write their chunk of the sorted run to
+    long long run_offset;   // External sort: offset of the run in both files
+    pthread_mutex_t* locks;                     // Boundary locks of the threads backend
+    pthread_barrier_t round_barrier;            // Ends each bubble sort round, process-shared
+    atomic_long round_swaps[ROUND_COUNTERS];    // Swaps in the round, see do_rounds in CSORT.c
     int readcount;      // Keeps count of readers in the "valid" critical section
+    atomic_long wakes_begun;    // Valid flags being reset, see validate in CSORT.c
+    atomic_long wakes_ended;    // Valid flags reset
+    atomic_size_t unsorted;     // Quick sort: elements not yet in place, see quick_sort in CSORT.c
+    atomic_long pushes;         // Quick sort: tasks pushed, bumped once more when the last letter is in place
+    atomic_int idle;            // Quick sort: workers parked on idle_wake
+    pthread_mutex_t idle_lock;  // Quick sort: guards parking, process-shared
+    pthread_cond_t idle_wake;   // Quick sort: signalled on a push, broadcast when done, process-shared
+    char data[];        // deques, work, bounds, counts, valid, samples, arr then tmp, see below
 } st_shmem;
+
+/**
+ * valid[i] stores whether process P_(i + 1) has finished sorting
+ * for a cycle, arr is the array to be sorted. Sample sort also uses
+ * bounds[i][b], the end of bucket b in P_(i + 1)'s sorted chunk,
+ * samples[i][j], the samples P_(i + 1) drew, and tmp, as large as
+ * arr. Counting and radix sort use counts[i][k], the number of
+ * elements with byte k in P_(i + 1)'s chunk. Quick sort uses
+ * deques[i], P_(i + 1)'s work-stealing deque. work[i] counts the
+ * elements P_(i + 1) went over in sample or quick sort. All are
+ * sized at runtime, so they follow the header in the same segment
+ * (the deques and size_t arrays first, to keep them aligned).
+ */
+
+/**
+ * @brief Returns the size of a shared memory segment holding
+ * an array of size elements sorted by num_processes processes.
+ * @param size size_t, the number of elements.
+ * @param width int, the bytes per element.
+ * @param num_processes int, the number of processes.
+ * @param scratch bool, whether to hold tmp for sample or radix sort.
+ * @returns size_t, the segment size in bytes.
+ */
+static inline size_t shmem_size(size_t size, int width, int num_processes, bool scratch)
+{
+    size_t p = num_processes;
+    return sizeof(st_shmem) + p * sizeof(ws_deque) + (p + p * (p + 1) + p * BUCKETS) * sizeof(size_t) + p * sizeof(atomic_bool)
+        + p * p + sizeof(size_t) + size * width * (scratch ? 2 : 1);
+}
+
+/**
+ * @brief Returns the quick sort work-stealing deques in the shared memory.
+ * @param shmem st_shmem*, the shared memory.
+ * @returns ws_deque*, deques[0..num_processes).
+ */
+static inline ws_deque* shmem_deques(st_shmem* shmem)
+{
+    return (ws_deque *)shmem->data;
+}
+
+/**
+ * @brief Returns the work counts of the workers in the shared memory.
+ * @param shmem st_shmem*, the shared memory.
+ * @returns size_t*, work[0..num_processes).
+ */
+static inline size_t* shmem_work(st_shmem* shmem)
+{
+    return (size_t *)(shmem_deques(shmem) + shmem->num_processes);
+}
+
+/**
+ * @brief Returns the sample sort bucket bounds in the shared memory.
+ * @param shmem st_shmem*, the shared memory.
+ * @returns size_t*, bounds[0..num_processes * (num_processes + 1)).
+ */
+static inline size_t* shmem_bounds(st_shmem* shmem)
+{
+    return shmem_work(shmem) + shmem->num_processes;
+}
+
+/**
+ * @brief Returns the counting and radix sort histograms in the shared memory.
+ * @param shmem st_shmem*, the shared memory.
+ * @returns size_t*, counts[0..num_processes * BUCKETS).
+ */
+static inline size_t* shmem_counts(st_shmem* shmem)
+{
+    size_t p = shmem->num_processes;
+    return shmem_bounds(shmem) + p * (p + 1);
+}
+
+/**
+ * @brief Returns the valid flags in the shared memory.
+ * @param shmem st_shmem*, the shared memory.
+ * @returns atomic_bool*, valid[0..num_processes).
+ */
+static inline atomic_bool* shmem_valid(st_shmem* shmem)
+{
+    return (atomic_bool *)(shmem_counts(shmem) + (size_t)shmem->num_processes * BUCKETS);
+}
+
+/**
+ * @brief Returns the sample sort samples in the shared memory.
+ * @param shmem st_shmem*, the shared memory.
+ * @returns char*, samples[0..num_processes * num_processes).
+ */
+static inline char* shmem_samples(st_shmem* shmem)
+{
+    return (char *)(shmem_valid(shmem) + shmem->num_processes);
+}
+
+/**
+ * @brief Returns the array in the shared memory, aligned
+ * for integer keys.
+ * @param shmem st_shmem*, the shared memory.
+ * @returns char*, arr[0..size * width).
+ */
+static inline char* shmem_arr(st_shmem* shmem)
+{
+    size_t offset = shmem_samples(shmem) + (size_t)shmem->num_processes * shmem->num_processes - (char *)shmem;
+    return (char *)shmem + (offset + sizeof(size_t) - 1) / sizeof(size_t) * sizeof(size_t);
+}
+
+/**
+ * @brief Returns the sample sort scratch array in the shared memory.
+ * @param shmem st_shmem*, the shared memory (allocated with scratch).
+ * @returns char*, tmp[0..size * width).
+ */
+static inline char* shmem_tmp(st_shmem* shmem)
+{
+    return shmem_arr(shmem) + shmem->size * shmem->width;
+}
@@ -0,0 +1,401 @@
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#include "sortingNetwork.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NETWORK_X86
+#define TARGET(isa) __attribute__((target(isa)))
+#endif
+
+const char* network_isa_names[NETWORK_ISAS] = { "scalar", "sse4.1", "avx2" };
+
+/**
+ * Bitonic sort of N = R * L elements held in R vectors of L lanes:
+ * every stage (k, j) compares element i with element i ^ j, and i
+ * keeps the smaller one if it is the lower of the two in an ascending
+ * block of k, i.e. if (i & j) == 0 matches (i & k) == 0. For j >= L,
+ * the pairs are whole vectors and the direction the same across
+ * them; for j < L, each vector is compared with itself shuffled and
+ * the lanes that keep the minimum are picked with a mask.
+ */
+#define BITONIC_NETWORK(regs, R, L, MIN, MAX, SHUFFLE, BLEND, MASK)                     \
+    for (int k = 2; k <= (R) * (L); k *= 2)                                             \
+    {                                                                                   \
+        for (int j = k / 2; j > 0; j /= 2)                                              \
+        {                                                                               \
+            for (int r = 0; r < (R); r++)                                               \
+            {                                                                           \
+                if (j >= (L))                                                           \
+                {                                                                       \
+                    if (r & (j / (L))) continue;                                        \
+                    int s = r + j / (L);                                                \
+                    __typeof__(regs[0]) lo = MIN(regs[r], regs[s]);                     \
+                    __typeof__(regs[0]) hi = MAX(regs[r], regs[s]);                     \
+                    int up = ((r * (L)) & k) == 0;                                      \
+                    regs[r] = up ? lo : hi;                                             \
+                    regs[s] = up ? hi : lo;                                             \
+                }                                                                       \
+                else                                                                    \
+                {                                                                       \
+                    __typeof__(regs[0]) partner = SHUFFLE(regs[r], j);                  \
+                    regs[r] = BLEND(MAX(regs[r], partner), MIN(regs[r], partner),       \
+                        MASK(r * (L), j, k));                                           \
+                }                                                                       \
+            }                                                                           \
+        }                                                                               \
+    }
+
+/**
+ * @brief Returns the number of elements a network sorts n
+ * elements in: the next power of two, at least lanes.
+ * @param n size_t, the number of elements.
+ * @param lanes int, the elements per vector.
+ * @returns int, the padded size.
+ */
+static inline int network_size(size_t n, int lanes)
+{
+    int size = lanes;
+    while (size < (int)n) size *= 2;
+    return size;
+}
+
+/* Scalar networks, any instruction set */
+
+#define SCALAR_NETWORK(a, N)                                        \
+    for (int k = 2; k <= (N); k *= 2)                               \
+    {                                                               \
+        for (int j = k / 2; j > 0; j /= 2)                          \
+        {                                                           \
+            for (int i = 0; i < (N); i++)                           \
+            {                                                       \
+                int l = i ^ j;                                      \
+                if (l < i) continue;                                \
+                __typeof__(a[0]) x = a[i], y = a[l];                \
+                __typeof__(a[0]) lo = (x < y) ? x : y;              \
+                __typeof__(a[0]) hi = (x < y) ? y : x;              \
+                int up = (i & k) == 0;                              \
+                a[i] = up ? lo : hi;                                \
+                a[l] = up ? hi : lo;                                \
+            }                                                       \
+        }                                                           \
+    }
+
+static void sort_char_scalar(char* a, size_t n)
+{
+    unsigned char buf[NETWORK_MAX];
+    int size = network_size(n, 2);
+    memset(buf, UCHAR_MAX, size);
+    memcpy(buf, a, n);
+    SCALAR_NETWORK(buf, size);
+    memcpy(a, buf, n);
+}
+
+static void sort_i32_scalar(int32_t* a, size_t n)
+{
+    int32_t buf[NETWORK_MAX];
+    int size = network_size(n, 2);
+    for (int i = n; i < size; i++) buf[i] = INT32_MAX;
+    memcpy(buf, a, n * sizeof(int32_t));
+    SCALAR_NETWORK(buf, size);
+    memcpy(a, buf, n * sizeof(int32_t));
+}
+
+static void sort_f32_scalar(float* a, size_t n)
+{
+    float buf[NETWORK_MAX];
+    int size = network_size(n, 2);
+    for (int i = n; i < size; i++) buf[i] = INFINITY;
+    memcpy(buf, a, n * sizeof(float));
+    SCALAR_NETWORK(buf, size);
+    memcpy(a, buf, n * sizeof(float));
+}
+
+#ifdef NETWORK_X86
+
+/* SSE4.1 networks: 16 letters or 4 integers or floats per vector */
+
+#define SSE_CHAR_SHUFFLE(v, j) _mm_shuffle_epi8(v, _mm_xor_si128(_mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm_set1_epi8(j)))
+#define SSE_CHAR_MASK(base, j, k) sse_char_mask(base, j, k)
+#define SSE_I32_SHUFFLE(v, j) ((j) == 1 ? _mm_shuffle_epi32(v, 0xB1) : _mm_shuffle_epi32(v, 0x4E))
+#define SSE_F32_SHUFFLE(v, j) ((j) == 1 ? _mm_shuffle_ps(v, v, 0xB1) : _mm_shuffle_ps(v, v, 0x4E))
+#define SSE_I32_MASK(base, j, k) sse_i32_mask(base, j, k)
+#define SSE_F32_MASK(base, j, k) _mm_castsi128_ps(sse_i32_mask(base, j, k))
+
+// Lanes base..base + 15 that keep the minimum at stage (k, j)
+TARGET("sse4.1") static inline __m128i sse_char_mask(int base, int j, int k)
+{
+    __m128i i = _mm_add_epi8(_mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm_set1_epi8(base));
+    __m128i lower = _mm_cmpeq_epi8(_mm_and_si128(i, _mm_set1_epi8(j)), _mm_setzero_si128());
+    __m128i up = _mm_cmpeq_epi8(_mm_and_si128(i, _mm_set1_epi8(k)), _mm_setzero_si128());
+    return _mm_cmpeq_epi8(lower, up);
+}
+
+// Lanes base..base + 3 that keep the minimum at stage (k, j)
+TARGET("sse4.1") static inline __m128i sse_i32_mask(int base, int j, int k)
+{
+    __m128i i = _mm_add_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(base));
+    __m128i lower = _mm_cmpeq_epi32(_mm_and_si128(i, _mm_set1_epi32(j)), _mm_setzero_si128());
+    __m128i up = _mm_cmpeq_epi32(_mm_and_si128(i, _mm_set1_epi32(k)), _mm_setzero_si128());
+    return _mm_cmpeq_epi32(lower, up);
+}
+
+TARGET("sse4.1") static void sort_char_sse41(char* a, size_t n)
+{
+    char buf[NETWORK_MAX];
+    __m128i regs[NETWORK_MAX / 16];
+    int size = network_size(n, 16), count = size / 16;
+    memset(buf, UCHAR_MAX, size);
+    memcpy(buf, a, n);
+    for (int r = 0; r < count; r++) regs[r] = _mm_loadu_si128((__m128i *)buf + r);
+    BITONIC_NETWORK(regs, count, 16, _mm_min_epu8, _mm_max_epu8, SSE_CHAR_SHUFFLE, _mm_blendv_epi8, SSE_CHAR_MASK);
+    for (int r = 0; r < count; r++) _mm_storeu_si128((__m128i *)buf + r, regs[r]);
+    memcpy(a, buf, n);
+}
+
+TARGET("sse4.1") static void sort_i32_sse41(int32_t* a, size_t n)
+{
+    int32_t buf[NETWORK_MAX];
+    __m128i regs[NETWORK_MAX / 4];
+    int size = network_size(n, 4), count = size / 4;
+    for (int i = n; i < size; i++) buf[i] = INT32_MAX;
+    memcpy(buf, a, n * sizeof(int32_t));
+    for (int r = 0; r < count; r++) regs[r] = _mm_loadu_si128((__m128i *)buf + r);
+    BITONIC_NETWORK(regs, count, 4, _mm_min_epi32, _mm_max_epi32, SSE_I32_SHUFFLE, _mm_blendv_epi8, SSE_I32_MASK);
+    for (int r = 0; r < count; r++) _mm_storeu_si128((__m128i *)buf + r, regs[r]);
+    memcpy(a, buf, n * sizeof(int32_t));
+}
+
+TARGET("sse4.1") static void sort_f32_sse41(float* a, size_t n)
+{
+    float buf[NETWORK_MAX];
+    __m128 regs[NETWORK_MAX / 4];
+    int size = network_size(n, 4), count = size / 4;
+    for (int i = n; i < size; i++) buf[i] = INFINITY;
+    memcpy(buf, a, n * sizeof(float));
+    for (int r = 0; r < count; r++) regs[r] = _mm_loadu_ps(buf + 4 * r);
+    BITONIC_NETWORK(regs, count, 4, _mm_min_ps, _mm_max_ps, SSE_F32_SHUFFLE, _mm_blendv_ps, SSE_F32_MASK);
+    for (int r = 0; r < count; r++) _mm_storeu_ps(buf + 4 * r, regs[r]);
+    memcpy(a, buf, n * sizeof(float));
+}
+
+/* AVX2 networks: 32 letters or 8 integers or floats per vector */
+
+#define AVX2_CHAR_SHUFFLE(v, j) ((j) == 16 ? _mm256_permute2x128_si256(v, v, 1) \
+    : _mm256_shuffle_epi8(v, _mm256_xor_si256(avx2_iota8(), _mm256_set1_epi8(j))))
+#define AVX2_CHAR_MASK(base, j, k) avx2_char_mask(base, j, k)
+#define AVX2_I32_SHUFFLE(v, j) _mm256_permutevar8x32_epi32(v, _mm256_xor_si256(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(j)))
+#define AVX2_F32_SHUFFLE(v, j) _mm256_permutevar8x32_ps(v, _mm256_xor_si256(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(j)))
+#define AVX2_I32_MASK(base, j, k) avx2_i32_mask(base, j, k)
+#define AVX2_F32_MASK(base, j, k) _mm256_castsi256_ps(avx2_i32_mask(base, j, k))
+
+TARGET("avx2") static inline __m256i avx2_iota8(void)
+{
+    return _mm256_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+        16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31);
+}
+
+// Lanes base..base + 31 that keep the minimum at stage (k, j)
+TARGET("avx2") static inline __m256i avx2_char_mask(int base, int j, int k)
+{
+    __m256i i = _mm256_add_epi8(avx2_iota8(), _mm256_set1_epi8(base));
+    __m256i lower = _mm256_cmpeq_epi8(_mm256_and_si256(i, _mm256_set1_epi8(j)), _mm256_setzero_si256());
+    __m256i up = _mm256_cmpeq_epi8(_mm256_and_si256(i, _mm256_set1_epi8(k)), _mm256_setzero_si256());
+    return _mm256_cmpeq_epi8(lower, up);
+}
+
+// Lanes base..base + 7 that keep the minimum at stage (k, j)
+TARGET("avx2") static inline __m256i avx2_i32_mask(int base, int j, int k)
+{
+    __m256i i = _mm256_add_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(base));
+    __m256i lower = _mm256_cmpeq_epi32(_mm256_and_si256(i, _mm256_set1_epi32(j)), _mm256_setzero_si256());
+    __m256i up = _mm256_cmpeq_epi32(_mm256_and_si256(i, _mm256_set1_epi32(k)), _mm256_setzero_si256());
+    return _mm256_cmpeq_epi32(lower, up);
+}
+
+TARGET("avx2") static void sort_char_avx2(char* a, size_t n)
+{
+    if (n <= 16)
+    {
+        sort_char_sse41(a, n);  // Half a vector would be padding
+        return;
+    }
+    char buf[NETWORK_MAX];
+    __m256i regs[1];
+    memset(buf, UCHAR_MAX, NETWORK_MAX);
+    memcpy(buf, a, n);
+    regs[0] = _mm256_loadu_si256((__m256i *)buf);
+    BITONIC_NETWORK(regs, 1, 32, _mm256_min_epu8, _mm256_max_epu8, AVX2_CHAR_SHUFFLE, _mm256_blendv_epi8, AVX2_CHAR_MASK);
+    _mm256_storeu_si256((__m256i *)buf, regs[0]);
+    memcpy(a, buf, n);
+}
+
+TARGET("avx2") static void sort_i32_avx2(int32_t* a, size_t n)
+{
+    int32_t buf[NETWORK_MAX];
+    __m256i regs[NETWORK_MAX / 8];
+    int size = network_size(n, 8), count = size / 8;
+    for (int i = n; i < size; i++) buf[i] = INT32_MAX;
+    memcpy(buf, a, n * sizeof(int32_t));
+    for (int r = 0; r < count; r++) regs[r] = _mm256_loadu_si256((__m256i *)buf + r);
+    BITONIC_NETWORK(regs, count, 8, _mm256_min_epi32, _mm256_max_epi32, AVX2_I32_SHUFFLE, _mm256_blendv_epi8, AVX2_I32_MASK);
+    for (int r = 0; r < count; r++) _mm256_storeu_si256((__m256i *)buf + r, regs[r]);
+    memcpy(a, buf, n * sizeof(int32_t));
+}
+
+TARGET("avx2") static void sort_f32_avx2(float* a, size_t n)
+{
+    float buf[NETWORK_MAX];
+    __m256 regs[NETWORK_MAX / 8];
+    int size = network_size(n, 8), count = size / 8;
+    for (int i = n; i < size; i++) buf[i] = INFINITY;
+    memcpy(buf, a, n * sizeof(float));
+    for (int r = 0; r < count; r++) regs[r] = _mm256_loadu_ps(buf + 8 * r);
+    BITONIC_NETWORK(regs, count, 8, _mm256_min_ps, _mm256_max_ps, AVX2_F32_SHUFFLE, _mm256_blendv_ps, AVX2_F32_MASK);
+    for (int r = 0; r < count; r++) _mm256_storeu_ps(buf + 8 * r, regs[r]);
+    memcpy(a, buf, n * sizeof(float));
+}
+
+#endif
+
+/* Runtime dispatch */
+
+typedef struct {
+    void (*sort_char)(char*, size_t);
+    void (*sort_i32)(int32_t*, size_t);
+    void (*sort_f32)(float*, size_t);
+} network_kernels;
+
+static const network_kernels kernels[NETWORK_ISAS] = {
+    { sort_char_scalar, sort_i32_scalar, sort_f32_scalar },
+#ifdef NETWORK_X86
+    { sort_char_sse41, sort_i32_sse41, sort_f32_sse41 },
+    { sort_char_avx2, sort_i32_avx2, sort_f32_avx2 },
+#endif
+};
+
+static const network_kernels* selected = NULL;   // Set on first use, see network_kernels_get
+
+int network_supported(network_isa isa)
+{
+    switch (isa)
+    {
+        case NETWORK_SCALAR: return 1;
+#ifdef NETWORK_X86
+        case NETWORK_SSE41: return __builtin_cpu_supports("sse4.1");
+        case NETWORK_AVX2: return __builtin_cpu_supports("avx2");
+#endif
+        default: return 0;
+    }
+}
+
+int network_select(network_isa isa)
+{
+    if (isa < 0 || isa >= NETWORK_ISAS || !network_supported(isa)) return -1;
+    selected = &kernels[isa];
+    return 0;
+}
+
+/**
+ * @brief Returns the selected kernels, selecting the best
+ * instruction set the CPU supports on first use.
+ * @returns network_kernels*, the kernels.
+ */
+static inline const network_kernels* network_kernels_get(void)
+{
+    if (selected == NULL)
+    {
+        int isa = NETWORK_ISAS - 1;
+        while (!network_supported(isa)) isa--;
+        network_select(isa);
+    }
+    return selected;
+}
+
+network_isa network_selected(void)
+{
+    return network_kernels_get() - kernels;
+}
+
+void network_sort_char(char* a, size_t n)
+{
+    if (n > 1) network_kernels_get()->sort_char(a, n);
+}
+
+void network_sort_i32(int32_t* a, size_t n)
+{
+    if (n > 1) network_kernels_get()->sort_i32(a, n);
+}
+
+void network_sort_f32(float* a, size_t n)
+{
+    if (n > 1) network_kernels_get()->sort_f32(a, n);
+}
+
+#define INSERTION_SORT(type, a, n)                      \
+    for (size_t i = 1; i < (n); i++)                    \
+    {                                                   \
+        type key = a[i];                                \
+        size_t j = i;                                   \
+        for (; j > 0 && key < a[j - 1]; j--) a[j] = a[j - 1];   \
+        a[j] = key;                                     \
+    }
+
+void insertion_sort_char(char* a, size_t n) { unsigned char* s = (unsigned char *)a; INSERTION_SORT(unsigned char, s, n); }
+void insertion_sort_i32(int32_t* a, size_t n) { INSERTION_SORT(int32_t, a, n); }
+void insertion_sort_f32(float* a, size_t n) { INSERTION_SORT(float, a, n); }
+
+/**
+ * @brief Merges the sorted runs a[0..n) and b[0..m) into out.
+ * @param a char*, the first run.
+ * @param n size_t, its length.
+ * @param b char*, the second run.
+ * @param m size_t, its length.
+ * @param out char*, receives the n + m letters.
+ */
+static void merge_chars(const char* a, size_t n, const char* b, size_t m, char* out)
+{
+    size_t i = 0, j = 0;
+    while (i < n && j < m)
+    {
+        int take_b = (unsigned char)b[j] < (unsigned char)a[i];
+        *out++ = take_b ? b[j] : a[i];
+        j += take_b;
+        i += !take_b;
+    }
+    memcpy(out, a + i, n - i);
+    memcpy(out + n - i, b + j, m - j);
+}
+
+void network_merge_sort_char(char* src, char* dst, size_t n)
+{
+    void (*sort_char)(char*, size_t) = network_kernels_get()->sort_char;
+
+    // Merge passes double the runs from NETWORK_MAX until one is left; sort
+    // the blocks where that many passes, alternating arrays, end in dst
+    int passes = 0;
+    for (size_t run = NETWORK_MAX; run < n; run *= 2) passes++;
+    char* from = (passes % 2 == 0) ? dst : src;
+    char* to = (from == dst) ? src : dst;
+    if (from != src) memcpy(from, src, n);
+    for (size_t start = 0; start < n; start += NETWORK_MAX)
+    {
+        size_t length = (n - start < NETWORK_MAX) ? n - start : NETWORK_MAX;
+        if (length > 1) sort_char(from + start, length);
+    }
+
+    for (size_t run = NETWORK_MAX; run < n; run *= 2)
+    {
+        for (size_t start = 0; start < n; start += 2 * run)
+        {
+            size_t middle = (start + run < n) ? start + run : n;
+            size_t end = (start + 2 * run < n) ? start + 2 * run : n;
+            merge_chars(from + start, middle - start, from + middle, end - middle, to + start);
+        }
+        char* swap = from;
+        from = to;
+        to = swap;
+    }
+}
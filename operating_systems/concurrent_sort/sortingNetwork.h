@@ -0,0 +1,71 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#define NETWORK_MAX 32  // Largest block sorted by a network
+
+/* Instruction sets the networks can run on */
+typedef enum {
+    NETWORK_SCALAR,     // Compare-exchanges one pair at a time
+    NETWORK_SSE41,      // 128-bit vectors
+    NETWORK_AVX2,       // 256-bit vectors
+    NETWORK_ISAS
+} network_isa;
+
+extern const char* network_isa_names[NETWORK_ISAS];
+
+/**
+ * @brief Returns whether the CPU supports the instruction set.
+ * @param isa network_isa, the instruction set.
+ * @returns 1 if supported, 0 otherwise.
+ */
+int network_supported(network_isa isa);
+
+/**
+ * @brief Selects the instruction set the networks run on. The
+ * best one the CPU supports is selected on first use otherwise.
+ * @param isa network_isa, the instruction set.
+ * @returns 0 on success, -1 if the CPU does not support it.
+ */
+int network_select(network_isa isa);
+
+/**
+ * @brief Returns the instruction set the networks run on.
+ * @returns network_isa, the instruction set.
+ */
+network_isa network_selected(void);
+
+/**
+ * @brief Sorts up to NETWORK_MAX letters (unsigned bytes, as
+ * compared by compare_chars) with a bitonic sorting network.
+ * @param a char*, the letters.
+ * @param n size_t, the number of letters, at most NETWORK_MAX.
+ */
+void network_sort_char(char* a, size_t n);
+
+/**
+ * @brief Sorts up to NETWORK_MAX integers with a bitonic sorting network.
+ * @param a int32_t*, the integers.
+ * @param n size_t, the number of integers, at most NETWORK_MAX.
+ */
+void network_sort_i32(int32_t* a, size_t n);
+
+/**
+ * @brief Sorts up to NETWORK_MAX floats (no NaNs) with a bitonic sorting network.
+ * @param a float*, the floats.
+ * @param n size_t, the number of floats, at most NETWORK_MAX.
+ */
+void network_sort_f32(float* a, size_t n);
+
+/**
+ * @brief Sorts n letters with a merge sort whose base case sorts
+ * blocks of NETWORK_MAX with network_sort_char.
+ * @param src char*, the letters, overwritten.
+ * @param dst char*, receives the sorted letters, as large as src.
+ * @param n size_t, the number of letters.
+ */
+void network_merge_sort_char(char* src, char* dst, size_t n);
+
+/* Insertion sorts, the usual base case the networks replace */
+void insertion_sort_char(char* a, size_t n);
+void insertion_sort_i32(int32_t* a, size_t n);
+void insertion_sort_f32(float* a, size_t n);
@@ -0,0 +1,71 @@
+#include <stdbool.h>
+
+#include "workStealing.h"
+
+/**
+ * The orderings follow Le et al., "Correct and Efficient Work-Stealing
+ * for Weak Memory Models" (PPoPP 2013). The owner's pop and a thief's
+ * steal race for the last task with a CAS on top; the seq_cst fences
+ * keep either from reading bottom and top in an order that lets both
+ * take it. A thief reads the task before its CAS, which is safe since
+ * the owner never writes a slot that a thief could still read: a push
+ * is refused once the deque holds WS_CAPACITY tasks.
+ */
+
+void ws_init(ws_deque* deque)
+{
+    atomic_store(&deque->top, 0);
+    atomic_store(&deque->bottom, 0);
+    atomic_store(&deque->steals, 0);
+}
+
+int ws_push(ws_deque* deque, ws_task task)
+{
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    if (bottom - top >= WS_CAPACITY) return -1;
+    atomic_store_explicit(&deque->tasks[bottom % WS_CAPACITY].start, task.start, memory_order_relaxed);
+    atomic_store_explicit(&deque->tasks[bottom % WS_CAPACITY].end, task.end, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+    return 0;
+}
+
+int ws_pop(ws_deque* deque, ws_task* task)
+{
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+    if (top > bottom)
+    {
+        // Empty
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return -1;
+    }
+    task->start = atomic_load_explicit(&deque->tasks[bottom % WS_CAPACITY].start, memory_order_relaxed);
+    task->end = atomic_load_explicit(&deque->tasks[bottom % WS_CAPACITY].end, memory_order_relaxed);
+    if (top == bottom)
+    {
+        // The last task: race the thieves for it
+        bool won = atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+            memory_order_seq_cst, memory_order_relaxed);
+        atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+        return won ? 0 : -1;
+    }
+    return 0;
+}
+
+int ws_steal(ws_deque* deque, ws_task* task)
+{
+    long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (top >= bottom) return -1;
+    task->start = atomic_load_explicit(&deque->tasks[top % WS_CAPACITY].start, memory_order_relaxed);
+    task->end = atomic_load_explicit(&deque->tasks[top % WS_CAPACITY].end, memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+        memory_order_seq_cst, memory_order_relaxed)) return -1;
+    atomic_fetch_add_explicit(&deque->steals, 1, memory_order_relaxed);
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include <stddef.h>
+#include <stdatomic.h>
+
+#define WS_CAPACITY 256     // Tasks a deque holds
+#define WS_LINE 64          // Cache line size, keeps top and bottom apart
+
+// A range of the array left to sort, see quick_sort in CSORT.c
+typedef struct {
+    size_t start;
+    size_t end;
+} ws_task;
+
+/**
+ * Chase-Lev work-stealing deque: the owner pushes and pops tasks
+ * at the bottom, thieves take them from the top. Only atomics are
+ * shared, no pointers, so the deques can live in the shared memory
+ * of forked processes. The buffer is not grown: a full deque refuses
+ * the push and the owner runs the task itself.
+ */
+typedef struct ws_deque {
+    atomic_long top;                            // Oldest task, taken by thieves
+    char top_pad[WS_LINE - sizeof(atomic_long)];
+    atomic_long bottom;                         // Next free slot, moved by the owner only
+    char bottom_pad[WS_LINE - sizeof(atomic_long)];
+    atomic_long steals;                         // Tasks taken from this deque by thieves
+    struct {
+        atomic_size_t start;
+        atomic_size_t end;
+    } tasks[WS_CAPACITY];
+} ws_deque;
+
+/**
+ * @brief Empties the deque, before any worker uses it.
+ * @param deque ws_deque*, the deque.
+ */
+void ws_init(ws_deque* deque);
+
+/**
+ * @brief Pushes a task at the bottom of the deque, by its owner.
+ * @param deque ws_deque*, the deque.
+ * @param task ws_task, the task.
+ * @returns 0 on success, -1 if the deque is full.
+ */
+int ws_push(ws_deque* deque, ws_task task);
+
+/**
+ * @brief Pops the newest task from the bottom of the deque, by its owner.
+ * @param deque ws_deque*, the deque.
+ * @param task ws_task*, receives the task.
+ * @returns 0 on success, -1 if the deque is empty (or a thief took the last task).
+ */
+int ws_pop(ws_deque* deque, ws_task* task);
+
+/**
+ * @brief Steals the oldest task from the top of another worker's deque.
+ * @param deque ws_deque*, the deque.
+ * @param task ws_task*, receives the task.
+ * @returns 0 on success, -1 if the deque is empty or another worker took the task first.
+ */
+int ws_steal(ws_deque* deque, ws_task* task);
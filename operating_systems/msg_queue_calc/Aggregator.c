@@ -0,0 +1,197 @@
+/**
+ * Aggregator - Incremental Dataset Statistics
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#include "Aggregator.h"
+
+/**
+ * @brief Adds x to a compensated (Neumaier) sum, keeping
+ * the rounding error of every addition in error.
+ *
+ * @param[inout] sum, the running sum.
+ * @param[inout] error, the running rounding error.
+ * @param[in] x, the number to add.
+ */
+void _compensated_add(double* sum, double* error, double x)
+{
+    double total = *sum + x;
+    if (fabs(*sum) >= fabs(x)) *error += (*sum - total) + x;
+    else *error += (x - total) + *sum;
+    *sum = total;
+}
+
+/**
+ * @brief Returns n as a double.
+ *
+ * @param[in] type, n's type.
+ * @param[in] n, the number.
+ * @return double, the number.
+ */
+double _as_double(value_type type, Value n)
+{
+    return (type == VALUE_INT64) ? (double)n.i : n.f;
+}
+
+// Count: kept by the framework itself, no hooks.
+
+bool _count_query(const Aggregates* state, value_type type, Value* result)
+{
+    (void)type;
+    result->i = state->count;
+    return true;
+}
+
+// Sum: exact for int64, compensated for doubles.
+
+void _sum_insert(Aggregates* state, value_type type, Value n, long count)
+{
+    if (type == VALUE_INT64) state->sum_i64 += (__int128)n.i * count;
+    else _compensated_add(&state->sum_f64, &state->sum_error, n.f * count);
+}
+
+void _sum_delete(Aggregates* state, value_type type, Value n, long count)
+{
+    if (type == VALUE_INT64) state->sum_i64 -= (__int128)n.i * count;
+    else _compensated_add(&state->sum_f64, &state->sum_error, -n.f * count);
+}
+
+bool _sum_query(const Aggregates* state, value_type type, Value* result)
+{
+    if (type == VALUE_DOUBLE) {
+        result->f = state->sum_f64 + state->sum_error;
+        return true;
+    }
+    if (state->sum_i64 < LLONG_MIN || state->sum_i64 > LLONG_MAX) return false;
+    result->i = (long long)state->sum_i64;
+    return true;
+}
+
+// Mean: derived from the sum and count, no hooks.
+
+bool _mean_query(const Aggregates* state, value_type type, Value* result)
+{
+    if (type == VALUE_INT64) result->f = (double)((long double)state->sum_i64 / state->count);
+    else result->f = (state->sum_f64 + state->sum_error) / state->count;
+    return true;
+}
+
+// Variance: Welford, generalized to count copies at once. Merging
+// count copies of x into n elements with mean m moves the mean by
+// (x - m) * count / (n + count) and M2 by (x - m)^2 * n * count / (n + count).
+// Deleting runs the merge backwards.
+
+void _variance_insert(Aggregates* state, value_type type, Value n, long count)
+{
+    double x = _as_double(type, n);
+    double total = (double)state->count + count;
+    double delta = x - state->mean;
+    state->mean += delta * count / total;
+    state->m2 += delta * delta * ((double)state->count * count / total);
+}
+
+void _variance_delete(Aggregates* state, value_type type, Value n, long count)
+{
+    double x = _as_double(type, n);
+    double remaining = (double)state->count - count;    // > 0, emptying resets instead
+    double delta = x - state->mean;
+    state->mean -= delta * count / remaining;
+    state->m2 -= delta * delta * ((double)state->count * count / remaining);
+    if (state->m2 < 0) state->m2 = 0;   // Rounding, M2 can't be negative
+}
+
+bool _variance_query(const Aggregates* state, value_type type, Value* result)
+{
+    (void)type;
+    result->f = state->m2 / state->count;
+    return true;
+}
+
+// Standard deviation: derived from the variance, no hooks.
+
+bool _stddev_query(const Aggregates* state, value_type type, Value* result)
+{
+    _variance_query(state, type, result);
+    result->f = sqrt(result->f);
+    return true;
+}
+
+// Geometric mean: exp of the mean log, zeros and negatives counted apart.
+
+void _geomean_update(Aggregates* state, value_type type, Value n, long count)
+{
+    double x = _as_double(type, n);
+    if (x == 0) state->zeros += count;
+    else if (x < 0) state->negatives += count;
+    else _compensated_add(&state->log_sum, &state->log_error, log(x) * count);
+}
+
+void _geomean_insert(Aggregates* state, value_type type, Value n, long count)
+{
+    _geomean_update(state, type, n, count);
+}
+
+void _geomean_delete(Aggregates* state, value_type type, Value n, long count)
+{
+    _geomean_update(state, type, n, -count);
+}
+
+bool _geomean_query(const Aggregates* state, value_type type, Value* result)
+{
+    (void)type;
+    if (state->negatives > 0) return false;
+    result->f = (state->zeros > 0) ? 0 : exp((state->log_sum + state->log_error) / state->count);
+    return true;
+}
+
+// Registry, hooks run in this order
+static const Aggregator aggregators[TOTAL_AGGREGATES] = {
+    [AGGREGATE_COUNT]    = { NULL, NULL, _count_query },
+    [AGGREGATE_SUM]      = { _sum_insert, _sum_delete, _sum_query },
+    [AGGREGATE_MEAN]     = { NULL, NULL, _mean_query },
+    [AGGREGATE_VARIANCE] = { _variance_insert, _variance_delete, _variance_query },
+    [AGGREGATE_STDDEV]   = { NULL, NULL, _stddev_query },
+    [AGGREGATE_GEOMEAN]  = { _geomean_insert, _geomean_delete, _geomean_query },
+};
+
+void aggregates_clear(Aggregates* state)
+{
+    assert(state != NULL);
+    memset(state, 0, sizeof(Aggregates));
+}
+
+void aggregates_insert(Aggregates* state, value_type type, Value n, long count)
+{
+    assert(state != NULL && count >= 0);
+    if (count == 0) return;
+    for (int i = 0; i < TOTAL_AGGREGATES; i++) {
+        if (aggregators[i].insert != NULL) aggregators[i].insert(state, type, n, count);
+    }
+    state->count += count;
+}
+
+void aggregates_delete(Aggregates* state, value_type type, Value n, long count)
+{
+    assert(state != NULL && count >= 0 && count <= state->count);
+    if (count == 0) return;
+    if (count == state->count) {
+        aggregates_clear(state);    // Emptied, drop any rounding left behind
+        return;
+    }
+    for (int i = 0; i < TOTAL_AGGREGATES; i++) {
+        if (aggregators[i].delete != NULL) aggregators[i].delete(state, type, n, count);
+    }
+    state->count -= count;
+}
+
+bool aggregates_query(const Aggregates* state, value_type type, aggregate_type aggregate, Value* result)
+{
+    assert(state != NULL && result != NULL && state->count > 0);
+    assert(aggregate >= 0 && aggregate < TOTAL_AGGREGATES);
+    return aggregators[aggregate].query(state, type, result);
+}
@@ -0,0 +1,104 @@
+/**
+ * Aggregator Header - Incremental Dataset Statistics
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#pragma once
+#ifndef _AGGREGATOR_H_
+#define _AGGREGATOR_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "Value.h"
+
+/**
+ * Statistics kept up to date on every insert and delete so each
+ * is answered in O(1), whatever the dataset's engine. Every aggregator
+ * registers an insert hook, a delete hook (both nullable, for those
+ * derived from another's state) and a query in Aggregator.c. Adding one
+ * is a new aggregate_type, its fields in Aggregates and a registry entry.
+ *
+ * Accumulators never lose what a long long or a plain double sum would:
+ * int64 sums are 128-bit, double sums and log sums are compensated
+ * (Neumaier) and the variance is Welford's running mean and M2, which
+ * also supports removing values. All of them reset once the dataset
+ * empties, so rounding left by deletes doesn't carry over.
+ */
+
+// Statistics answered by the aggregators
+typedef enum {
+    AGGREGATE_COUNT,        // Number of elements, int64
+    AGGREGATE_SUM,          // Sum, of the dataset's type (fails if it overflows int64)
+    AGGREGATE_MEAN,         // Mean, double
+    AGGREGATE_VARIANCE,     // Population variance, double
+    AGGREGATE_STDDEV,       // Population standard deviation, double
+    AGGREGATE_GEOMEAN,      // Geometric mean, double (fails if an element is negative)
+    TOTAL_AGGREGATES
+} aggregate_type;
+
+// Running state of every aggregator
+typedef struct {
+    long long count;        // Elements, updated after the hooks run
+    __int128 sum_i64;       // VALUE_INT64: exact sum
+    double sum_f64;         // VALUE_DOUBLE: compensated sum
+    double sum_error;       // VALUE_DOUBLE: rounding error missing from sum_f64
+    double mean;            // Welford running mean
+    double m2;              // Welford sum of squared deviations from the mean
+    double log_sum;         // Compensated sum of the logs of the positive elements
+    double log_error;       // Rounding error missing from log_sum
+    long long zeros;        // Elements equal to 0
+    long long negatives;    // Elements < 0, the geometric mean is undefined while any
+} Aggregates;
+
+// An aggregator's hooks, count is the number of copies of n inserted or deleted.
+// Hooks see state->count as the number of elements before the update.
+typedef struct {
+    void (*insert)(Aggregates* state, value_type type, Value n, long count);    // Nullable
+    void (*delete)(Aggregates* state, value_type type, Value n, long count);    // Nullable
+    bool (*query)(const Aggregates* state, value_type type, Value* result);     // Non-empty state only
+} Aggregator;
+
+/**
+ * @brief Resets the aggregates to those of an empty dataset.
+ *
+ * @param[out] state, the aggregates to reset.
+ */
+void aggregates_clear(Aggregates* state);
+
+/**
+ * @brief Runs every aggregator's insert hook
+ * for count copies of n.
+ *
+ * @param[inout] state, the aggregates.
+ * @param[in] type, the dataset's value type.
+ * @param[in] n, the number inserted.
+ * @param[in] count, how many copies were inserted.
+ */
+void aggregates_insert(Aggregates* state, value_type type, Value n, long count);
+
+/**
+ * @brief Runs every aggregator's delete hook
+ * for count copies of n, which must have been inserted.
+ *
+ * @param[inout] state, the aggregates.
+ * @param[in] type, the dataset's value type.
+ * @param[in] n, the number deleted.
+ * @param[in] count, how many copies were deleted.
+ */
+void aggregates_delete(Aggregates* state, value_type type, Value n, long count);
+
+/**
+ * @brief Answers the specified aggregate in O(1).
+ *
+ * @param[in] state, the aggregates, of a non-empty dataset.
+ * @param[in] type, the dataset's value type.
+ * @param[in] aggregate, the aggregate to answer.
+ * @param[out] result, stores the result (see aggregate_type for its type).
+ * @return true if answered, false if undefined or not representable.
+ */
+bool aggregates_query(const Aggregates* state, value_type type, aggregate_type aggregate, Value* result);
+
+#endif
@@ -0,0 +1,348 @@
+/**
+ * Dataset - Calculator Storage Engines
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+
+#include "Dataset.h"
+
+/**
+ * @brief Returns the frequency sketch key of a number: the
+ * number itself for int64, the bit pattern for doubles (with -0.0
+ * folded into 0.0, they compare equal).
+ *
+ * @param[in] type, the number's type.
+ * @param[in] n, the number.
+ * @return long long, the key.
+ */
+long long _frequency_key(value_type type, Value n)
+{
+    if (type == VALUE_INT64) return n.i;
+    long long key;
+    double f = (n.f == 0) ? 0.0 : n.f;
+    memcpy(&key, &f, sizeof(key));
+    return key;
+}
+
+/**
+ * @brief Inverse of _frequency_key.
+ *
+ * @param[in] type, the number's type.
+ * @param[in] key, the key.
+ * @return Value, the number.
+ */
+Value _frequency_value(value_type type, long long key)
+{
+    Value n;
+    if (type == VALUE_INT64) n.i = key;
+    else memcpy(&n.f, &key, sizeof(key));
+    return n;
+}
+
+/**
+ * @brief Returns the number of elements <= n in a dense
+ * dataset, and their sum. n may lie outside the counter's range.
+ *
+ * @param[in] dense, the dense counter.
+ * @param[in] n, the bound, inclusive.
+ * @param[out] sum, stores the sum (nullable).
+ * @return long, the count.
+ */
+long _dense_prefix(const DenseCounter* dense, long long n, long long* sum)
+{
+    if (n < dense->lo) {
+        if (sum != NULL) *sum = 0;
+        return 0;
+    }
+    return densecounter_prefix(dense, (n > dense->hi) ? dense->hi : (int)n, sum);
+}
+
+/**
+ * @brief Returns the exact number of distinct elements, O(1):
+ * every engine already keeps one entry per distinct element.
+ * Used after a delete in sketch mode, which the HyperLogLog
+ * can't forget.
+ *
+ * @param[in] dataset, the dataset.
+ * @return long, the distinct count.
+ */
+long _distinct_elements(const Dataset* dataset)
+{
+    if (dataset->engine == ENGINE_DENSE) return dataset->dense->distinct;
+    if (dataset->engine == ENGINE_LAZY && dataset->type == VALUE_INT64) return hashmap_size(dataset->lazy_i64->live);
+    if (dataset->engine == ENGINE_LAZY) return hashmap_size(dataset->lazy_f64->live);
+    if (dataset->type == VALUE_INT64) return dataset->ranges_i64->size;
+    return dataset->ranges_f64->size;
+}
+
+Dataset* dataset_create_heap(int capacity, value_type type, const SketchConfig* config)
+{
+    Dataset* dataset = (Dataset *)calloc(1, sizeof(Dataset));
+    assert(dataset != NULL);
+
+    dataset->engine = ENGINE_HEAP;
+    dataset->type = type;
+    if (type == VALUE_INT64) {
+        dataset->heap_i64 = medianheap_create_i64(capacity);
+        dataset->ranges_i64 = rangeindex_create_i64(capacity);
+    } else {
+        dataset->heap_f64 = medianheap_create_f64(capacity);
+        dataset->ranges_f64 = rangeindex_create_f64(capacity);
+    }
+    dataset->frequencies = frequencysketch_create(config);
+    aggregates_clear(&dataset->aggregates);
+    return dataset;
+}
+
+Dataset* dataset_create_dense(int lo, int hi, const SketchConfig* config)
+{
+    Dataset* dataset = (Dataset *)calloc(1, sizeof(Dataset));
+    assert(dataset != NULL);
+
+    dataset->engine = ENGINE_DENSE;
+    dataset->type = VALUE_INT64;
+    dataset->dense = densecounter_create(lo, hi);
+    if (dataset->dense == NULL) {
+        free(dataset);
+        return NULL;
+    }
+    dataset->frequencies = frequencysketch_create(config);
+    aggregates_clear(&dataset->aggregates);
+    return dataset;
+}
+
+Dataset* dataset_create_lazy(int capacity, value_type type, const SketchConfig* config)
+{
+    Dataset* dataset = (Dataset *)calloc(1, sizeof(Dataset));
+    assert(dataset != NULL);
+
+    dataset->engine = ENGINE_LAZY;
+    dataset->type = type;
+    if (type == VALUE_INT64) dataset->lazy_i64 = lazymedian_create_i64(capacity);
+    else dataset->lazy_f64 = lazymedian_create_f64(capacity);
+    dataset->frequencies = frequencysketch_create(config);
+    aggregates_clear(&dataset->aggregates);
+    return dataset;
+}
+
+bool dataset_insert(Dataset* dataset, Value n)
+{
+    assert(dataset != NULL);
+    if (dataset->engine == ENGINE_DENSE) {
+        if (n.i < INT_MIN || n.i > INT_MAX || !densecounter_insert(dataset->dense, n.i)) return false;
+    } else if (dataset->engine == ENGINE_LAZY && dataset->type == VALUE_INT64) {
+        lazymedian_insert_i64(dataset->lazy_i64, n.i);
+    } else if (dataset->engine == ENGINE_LAZY) {
+        if (n.f != n.f) return false;   // NaN has no place in an ordering
+        lazymedian_insert_f64(dataset->lazy_f64, n.f);
+    } else if (dataset->type == VALUE_INT64) {
+        medianheap_insert_i64(dataset->heap_i64, n.i);
+        rangeindex_insert_i64(dataset->ranges_i64, n.i);
+    } else {
+        if (n.f != n.f) return false;   // NaN has no place in an ordering
+        medianheap_insert_f64(dataset->heap_f64, n.f);
+        rangeindex_insert_f64(dataset->ranges_f64, n.f);
+    }
+    frequencysketch_add(dataset->frequencies, _frequency_key(dataset->type, n), 1);
+    aggregates_insert(&dataset->aggregates, dataset->type, n, 1);
+    return true;
+}
+
+void dataset_delete_all(Dataset* dataset, Value n)
+{
+    assert(dataset != NULL);
+    long deleted;
+    if (dataset->engine == ENGINE_DENSE) {
+        if (n.i < INT_MIN || n.i > INT_MAX) return;
+        deleted = densecounter_delete_all(dataset->dense, n.i);
+    } else if (dataset->engine == ENGINE_LAZY && dataset->type == VALUE_INT64) {
+        deleted = lazymedian_delete_all_i64(dataset->lazy_i64, n.i);
+    } else if (dataset->engine == ENGINE_LAZY) {
+        deleted = lazymedian_delete_all_f64(dataset->lazy_f64, n.f);
+    } else if (dataset->type == VALUE_INT64) {
+        medianheap_delete_all_i64(dataset->heap_i64, n.i);
+        deleted = rangeindex_delete_all_i64(dataset->ranges_i64, n.i);
+    } else {
+        medianheap_delete_all_f64(dataset->heap_f64, n.f);
+        deleted = rangeindex_delete_all_f64(dataset->ranges_f64, n.f);
+    }
+    frequencysketch_delete_all(dataset->frequencies, _frequency_key(dataset->type, n));
+    aggregates_delete(&dataset->aggregates, dataset->type, n, deleted);
+}
+
+bool dataset_get_median2(Dataset* dataset, Value medians[])
+{
+    assert(dataset != NULL && !dataset_is_empty(dataset));
+    if (dataset->engine == ENGINE_LAZY && dataset->type == VALUE_INT64) {
+        long long middle[2] = { 0 };
+        bool two = lazymedian_get_median2_i64(dataset->lazy_i64, middle);
+        medians[0].i = middle[0]; medians[1].i = middle[1];
+        return two;
+    }
+    if (dataset->engine == ENGINE_LAZY) {
+        double middle[2] = { 0 };
+        bool two = lazymedian_get_median2_f64(dataset->lazy_f64, middle);
+        medians[0].f = middle[0]; medians[1].f = middle[1];
+        return two;
+    }
+    if (dataset->engine == ENGINE_HEAP && dataset->type == VALUE_INT64) {
+        long long middle[2] = { 0 };
+        bool two = medianheap_get_median2_i64(dataset->heap_i64, middle);
+        medians[0].i = middle[0]; medians[1].i = middle[1];
+        return two;
+    }
+    if (dataset->engine == ENGINE_HEAP) {
+        double middle[2] = { 0 };
+        bool two = medianheap_get_median2_f64(dataset->heap_f64, middle);
+        medians[0].f = middle[0]; medians[1].f = middle[1];
+        return two;
+    }
+
+    // Same as the median heap: the lower middle element is the
+    // max heap root, the upper one the min heap root.
+    long size = densecounter_size(dataset->dense);
+    if (size % 2 == 0) {
+        medians[0].i = densecounter_select(dataset->dense, size / 2 - 1);
+        medians[1].i = densecounter_select(dataset->dense, size / 2);
+        return true;
+    }
+    medians[0].i = densecounter_select(dataset->dense, size / 2);
+    return false;
+}
+
+Value dataset_get_min(Dataset* dataset)
+{
+    assert(dataset != NULL && !dataset_is_empty(dataset));
+    Value min;
+    if (dataset->engine == ENGINE_DENSE) min.i = densecounter_select(dataset->dense, 0);
+    else if (dataset->engine == ENGINE_LAZY && dataset->type == VALUE_INT64) min.i = lazymedian_get_min_i64(dataset->lazy_i64);
+    else if (dataset->engine == ENGINE_LAZY) min.f = lazymedian_get_min_f64(dataset->lazy_f64);
+    else if (dataset->type == VALUE_INT64) min.i = medianheap_get_min_i64(dataset->heap_i64);
+    else min.f = medianheap_get_min_f64(dataset->heap_f64);
+    return min;
+}
+
+Value dataset_get_max(Dataset* dataset)
+{
+    assert(dataset != NULL && !dataset_is_empty(dataset));
+    Value max;
+    if (dataset->engine == ENGINE_DENSE) max.i = densecounter_select(dataset->dense, densecounter_size(dataset->dense) - 1);
+    else if (dataset->engine == ENGINE_LAZY && dataset->type == VALUE_INT64) max.i = lazymedian_get_max_i64(dataset->lazy_i64);
+    else if (dataset->engine == ENGINE_LAZY) max.f = lazymedian_get_max_f64(dataset->lazy_f64);
+    else if (dataset->type == VALUE_INT64) max.i = rangeindex_get_max_i64(dataset->ranges_i64);
+    else max.f = rangeindex_get_max_f64(dataset->ranges_f64);
+    return max;
+}
+
+bool dataset_aggregate(const Dataset* dataset, aggregate_type aggregate, Value* result)
+{
+    assert(dataset != NULL && !dataset_is_empty(dataset));
+    return aggregates_query(&dataset->aggregates, dataset->type, aggregate, result);
+}
+
+long dataset_count_range(Dataset* dataset, Value lo, Value hi)
+{
+    assert(dataset != NULL);
+    if (dataset->engine == ENGINE_DENSE) {
+        if (lo.i > hi.i) return 0;
+        return _dense_prefix(dataset->dense, hi.i, NULL) -
+            (lo.i > dataset->dense->lo ? _dense_prefix(dataset->dense, lo.i - 1, NULL) : 0);
+    }
+    if (dataset->engine == ENGINE_LAZY && dataset->type == VALUE_INT64) return lazymedian_count_range_i64(dataset->lazy_i64, lo.i, hi.i, NULL);
+    if (dataset->engine == ENGINE_LAZY) return lazymedian_count_range_f64(dataset->lazy_f64, lo.f, hi.f, NULL);
+    if (dataset->type == VALUE_INT64) return rangeindex_count_range_i64(dataset->ranges_i64, lo.i, hi.i);
+    return rangeindex_count_range_f64(dataset->ranges_f64, lo.f, hi.f);
+}
+
+bool dataset_sum_range(Dataset* dataset, Value lo, Value hi, Value* sum)
+{
+    assert(dataset != NULL && sum != NULL);
+    sum->i = 0;
+    if (dataset->engine == ENGINE_DENSE) {
+        if (lo.i > hi.i) return true;
+        long long upper, lower = 0;
+        _dense_prefix(dataset->dense, hi.i, &upper);
+        if (lo.i > dataset->dense->lo) _dense_prefix(dataset->dense, lo.i - 1, &lower);
+        sum->i = upper - lower;
+        return true;
+    }
+    if (dataset->type == VALUE_DOUBLE) {
+        if (dataset->engine == ENGINE_LAZY) lazymedian_count_range_f64(dataset->lazy_f64, lo.f, hi.f, &sum->f);
+        else sum->f = rangeindex_sum_range_f64(dataset->ranges_f64, lo.f, hi.f);
+        return true;
+    }
+
+    // Integer sums are kept in 128 bits, like the aggregates.
+    __int128 wide;
+    if (dataset->engine == ENGINE_LAZY) lazymedian_count_range_i64(dataset->lazy_i64, lo.i, hi.i, &wide);
+    else wide = rangeindex_sum_range_i64(dataset->ranges_i64, lo.i, hi.i);
+    if (wide < LLONG_MIN || wide > LLONG_MAX) return false;
+    sum->i = (long long)wide;
+    return true;
+}
+
+long dataset_rank(Dataset* dataset, Value n)
+{
+    assert(dataset != NULL);
+    if (dataset->engine == ENGINE_DENSE) return _dense_prefix(dataset->dense, n.i, NULL);
+    if (dataset->engine == ENGINE_LAZY && dataset->type == VALUE_INT64) return lazymedian_count_range_i64(dataset->lazy_i64, LLONG_MIN, n.i, NULL);
+    if (dataset->engine == ENGINE_LAZY) return lazymedian_count_range_f64(dataset->lazy_f64, -INFINITY, n.f, NULL);
+    if (dataset->type == VALUE_INT64) return rangeindex_rank_i64(dataset->ranges_i64, n.i);
+    return rangeindex_rank_f64(dataset->ranges_f64, n.f);
+}
+
+double dataset_distinct(Dataset* dataset, double* error)
+{
+    assert(dataset != NULL);
+    double distinct;
+    if (frequencysketch_distinct(dataset->frequencies, &distinct, error)) return distinct;
+    *error = 0;
+    return _distinct_elements(dataset);
+}
+
+bool dataset_topk(Dataset* dataset, int rank, Counter* counter, Value* value)
+{
+    assert(dataset != NULL && value != NULL);
+    if (!frequencysketch_topk(dataset->frequencies, rank, counter)) return false;
+    *value = _frequency_value(dataset->type, counter->value);
+    return true;
+}
+
+value_type dataset_type(const Dataset* dataset)
+{
+    assert(dataset != NULL);
+    return dataset->type;
+}
+
+long dataset_size(const Dataset* dataset)
+{
+    assert(dataset != NULL);
+    if (dataset->engine == ENGINE_DENSE) return densecounter_size(dataset->dense);
+    if (dataset->engine == ENGINE_LAZY && dataset->type == VALUE_INT64) return lazymedian_size_i64(dataset->lazy_i64);
+    if (dataset->engine == ENGINE_LAZY) return lazymedian_size_f64(dataset->lazy_f64);
+    if (dataset->type == VALUE_INT64) return medianheap_size_i64(dataset->heap_i64);
+    return medianheap_size_f64(dataset->heap_f64);
+}
+
+bool dataset_is_empty(const Dataset* dataset)
+{
+    return dataset_size(dataset) == 0;
+}
+
+void dataset_destroy(Dataset* dataset)
+{
+    assert(dataset != NULL);
+    if (dataset->heap_i64 != NULL) medianheap_destroy_i64(dataset->heap_i64);
+    if (dataset->ranges_i64 != NULL) rangeindex_destroy_i64(dataset->ranges_i64);
+    if (dataset->heap_f64 != NULL) medianheap_destroy_f64(dataset->heap_f64);
+    if (dataset->ranges_f64 != NULL) rangeindex_destroy_f64(dataset->ranges_f64);
+    if (dataset->dense != NULL) densecounter_destroy(dataset->dense);
+    if (dataset->lazy_i64 != NULL) lazymedian_destroy_i64(dataset->lazy_i64);
+    if (dataset->lazy_f64 != NULL) lazymedian_destroy_f64(dataset->lazy_f64);
+    frequencysketch_destroy(dataset->frequencies);
+    free(dataset);
+}
@@ -0,0 +1,225 @@
+/**
+ * Dataset Header - Calculator Storage Engines
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#pragma once
+#ifndef _DATASET_H_
+#define _DATASET_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "Value.h"
+#include "MedianHeap.h"
+#include "LazyMedian.h"
+#include "RangeIndex.h"
+#include "DenseCounter.h"
+#include "FrequencySketch.h"
+#include "Aggregator.h"
+
+// Storage engine backing a dataset
+typedef enum {
+    ENGINE_HEAP,    // Median heap + range index, any integers
+    ENGINE_DENSE,   // Counting array, integers in a declared [lo, hi]
+    ENGINE_LAZY     // Append buffer, ordered only when read (see LazyMedian.h)
+} engine_type;
+
+/**
+ * Every value passed to or returned by a dataset is of the dataset's
+ * type (see dataset_type), except counts, ranks and averages which have
+ * fixed types. Callers convert with value_convert first.
+ */
+
+// Dataset Struct
+typedef struct {
+    engine_type engine;             // Which of the members below are used
+    value_type type;                // Type of the numbers, always VALUE_INT64 for ENGINE_DENSE
+    MedianHeap_i64* heap_i64;       // ENGINE_HEAP, VALUE_INT64: the numbers
+    RangeIndex_i64* ranges_i64;     // ENGINE_HEAP, VALUE_INT64: the same numbers, for range queries
+    MedianHeap_f64* heap_f64;       // ENGINE_HEAP, VALUE_DOUBLE: the numbers
+    RangeIndex_f64* ranges_f64;     // ENGINE_HEAP, VALUE_DOUBLE: the same numbers, for range queries
+    DenseCounter* dense;            // ENGINE_DENSE: the numbers
+    LazyMedian_i64* lazy_i64;       // ENGINE_LAZY, VALUE_INT64: the numbers
+    LazyMedian_f64* lazy_f64;       // ENGINE_LAZY, VALUE_DOUBLE: the numbers
+    FrequencySketch* frequencies;   // Distinct count and top-k, all engines
+    Aggregates aggregates;          // Count, sum, mean, variance..., all engines
+} Dataset;
+
+/**
+ * @brief Allocates and initializes a new, empty dataset
+ * backed by a median heap with the specified capacity.
+ *
+ * @param[in] capacity, the initializing capacity.
+ * @param[in] type, the type of the numbers.
+ * @param[in] config, the distinct/top-k sketch sizing.
+ * @return Dataset*, the dataset.
+ */
+Dataset* dataset_create_heap(int capacity, value_type type, const SketchConfig* config);
+
+/**
+ * @brief Allocates and initializes a new, empty dataset
+ * of int64 backed by a dense counter over [lo, hi].
+ * Precondition: lo <= hi, hi - lo < MAX_DENSE_RANGE.
+ *
+ * @param[in] lo, the smallest storable value.
+ * @param[in] hi, the largest storable value.
+ * @param[in] config, the distinct/top-k sketch sizing.
+ * @return Dataset*, the dataset, NULL if the counts don't fit in memory.
+ */
+Dataset* dataset_create_dense(int lo, int hi, const SketchConfig* config);
+
+/**
+ * @brief Allocates and initializes a new, empty dataset backed
+ * by a lazy median with the specified capacity. Inserts and deletes
+ * are O(1), the median, minimum and maximum are computed by the first
+ * read after a mutation, range queries and ranks scan the dataset.
+ *
+ * @param[in] capacity, the initializing capacity.
+ * @param[in] type, the type of the numbers.
+ * @param[in] config, the distinct/top-k sketch sizing.
+ * @return Dataset*, the dataset.
+ */
+Dataset* dataset_create_lazy(int capacity, value_type type, const SketchConfig* config);
+
+/**
+ * @brief Inserts the specified number into the dataset.
+ *
+ * @param[inout] dataset, the dataset to insert into.
+ * @param[in] n, the number to insert.
+ * @return true if inserted, false if the engine can't store n.
+ */
+bool dataset_insert(Dataset* dataset, Value n);
+
+/**
+ * @brief Deletes all instances of n from the dataset.
+ *
+ * @param[inout] dataset, the dataset to delete from.
+ * @param[in] n, the number to delete.
+ */
+void dataset_delete_all(Dataset* dataset, Value n);
+
+/**
+ * @brief Gets the median of the dataset if odd size. Else,
+ * gets the *two* elements located at the middle of the sorted set.
+ *
+ * @param[inout] dataset, the dataset to get the median for (a lazy median may be selected).
+ * @param[out] medians, stores the median(s).
+ * @return flag as true if two medians, else false.
+ */
+bool dataset_get_median2(Dataset* dataset, Value medians[]);
+
+/**
+ * @brief Returns the minimum value in the dataset.
+ *
+ * @param[inout] dataset, the dataset to return the minimum for (a lazy median may be scanned).
+ * @return Value, the minimum.
+ */
+Value dataset_get_min(Dataset* dataset);
+
+/**
+ * @brief Returns the maximum value in the dataset.
+ *
+ * @param[inout] dataset, the dataset to return the maximum for (the range index may be compacted,
+ * a lazy median scanned).
+ * @return Value, the maximum.
+ */
+Value dataset_get_max(Dataset* dataset);
+
+/**
+ * @brief Answers an aggregate (count, sum, mean, variance,
+ * standard deviation, geometric mean) in O(1).
+ *
+ * @param[in] dataset, the dataset to aggregate, not empty.
+ * @param[in] aggregate, the aggregate.
+ * @param[out] result, stores the result (see aggregate_type for its type).
+ * @return true if answered, false if undefined or not representable.
+ */
+bool dataset_aggregate(const Dataset* dataset, aggregate_type aggregate, Value* result);
+
+/**
+ * @brief Returns the number of elements k with lo <= k <= hi.
+ *
+ * @param[inout] dataset, the dataset to query.
+ * @param[in] lo, the lower bound, inclusive.
+ * @param[in] hi, the upper bound, inclusive.
+ * @return long, the count.
+ */
+long dataset_count_range(Dataset* dataset, Value lo, Value hi);
+
+/**
+ * @brief Computes the sum of the elements k with lo <= k <= hi.
+ *
+ * @param[inout] dataset, the dataset to query.
+ * @param[in] lo, the lower bound, inclusive.
+ * @param[in] hi, the upper bound, inclusive.
+ * @param[out] sum, stores the sum.
+ * @return bool, false if the sum of integers overflows 64 bits.
+ */
+bool dataset_sum_range(Dataset* dataset, Value lo, Value hi, Value* sum);
+
+/**
+ * @brief Returns the number of elements <= n.
+ *
+ * @param[inout] dataset, the dataset to query.
+ * @param[in] n, the number to rank.
+ * @return long, the rank.
+ */
+long dataset_rank(Dataset* dataset, Value n);
+
+/**
+ * @brief Returns the number of distinct elements.
+ *
+ * @param[inout] dataset, the dataset to query (rankings are cached).
+ * @param[out] error, stores the absolute standard error, 0 if exact.
+ * @return double, the (estimated) distinct count.
+ */
+double dataset_distinct(Dataset* dataset, double* error);
+
+/**
+ * @brief Gets the rank-th (1-indexed) most frequent element.
+ *
+ * @param[inout] dataset, the dataset to query (rankings are cached).
+ * @param[in] rank, the rank.
+ * @param[out] counter, stores the element's count and the
+ * count's maximum overestimate (0 if exact).
+ * @param[out] value, stores the element.
+ * @return true if there is such an element, else false.
+ */
+bool dataset_topk(Dataset* dataset, int rank, Counter* counter, Value* value);
+
+/**
+ * @brief Returns the type of the numbers in the dataset.
+ *
+ * @param[in] dataset, the dataset.
+ * @return value_type, the type.
+ */
+value_type dataset_type(const Dataset* dataset);
+
+/**
+ * @brief Returns the number of elements in the dataset.
+ *
+ * @param[in] dataset, the dataset to get the size of.
+ * @return long, the size.
+ */
+long dataset_size(const Dataset* dataset);
+
+/**
+ * @brief Returns whether the dataset is empty.
+ *
+ * @param[in] dataset, the dataset to check if empty.
+ * @return true if empty, else false.
+ */
+bool dataset_is_empty(const Dataset* dataset);
+
+/**
+ * @brief Destroys and cleans up the specified dataset.
+ *
+ * @param[in] dataset, the dataset to destroy.
+ */
+void dataset_destroy(Dataset* dataset);
+
+#endif
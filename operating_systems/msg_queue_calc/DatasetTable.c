@@ -0,0 +1,142 @@
+/**
+ * Dataset Table - Named Datasets with Per-Dataset Locks
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#include <sys/time.h>
+
+#include "DatasetTable.h"
+
+#define INITIAL_CAPACITY 10 // Initial dataset capacity
+
+DatasetTable* datasettable_create(const DatasetDefaults* defaults)
+{
+    assert(defaults != NULL);
+    DatasetTable* table = (DatasetTable *)calloc(1, sizeof(DatasetTable));
+    assert(table != NULL);
+
+    table->defaults = *defaults;
+
+    // Versions start from the wall clock, so they keep increasing
+    // across restarts (no dataset changes more than once per micro second).
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    table->epoch = (unsigned long long)now.tv_sec * 1000000 + now.tv_usec;
+    table->index = hashmap_create(INITIAL_CAPACITY);
+    table->capacity = INITIAL_CAPACITY;
+    table->entries = (DatasetEntry **)malloc(table->capacity * sizeof(DatasetEntry *));
+    assert(table->entries != NULL);
+    assert(pthread_rwlock_init(&table->lock, NULL) == 0);
+    return table;
+}
+
+Dataset* datasettable_new_dataset(const DatasetDefaults* defaults)
+{
+    assert(defaults != NULL);
+    if (defaults->engine == ENGINE_DENSE) {
+        return dataset_create_dense(defaults->lo, defaults->hi, &defaults->sketches);
+    }
+    if (defaults->engine == ENGINE_LAZY) {
+        return dataset_create_lazy(INITIAL_CAPACITY, defaults->type, &defaults->sketches);
+    }
+    return dataset_create_heap(INITIAL_CAPACITY, defaults->type, &defaults->sketches);
+}
+
+DatasetEntry* datasettable_get(DatasetTable* table, unsigned int id, bool create)
+{
+    assert(table != NULL);
+    long position;
+
+    // Common case, the dataset exists.
+    pthread_rwlock_rdlock(&table->lock);
+    DatasetEntry* entry = hashmap_get(table->index, id, &position) ? table->entries[position] : NULL;
+    pthread_rwlock_unlock(&table->lock);
+    if (entry != NULL || !create) return entry;
+
+    // Otherwise create it, unless another thread beat us to it.
+    pthread_rwlock_wrlock(&table->lock);
+    if (hashmap_get(table->index, id, &position)) {
+        entry = table->entries[position];
+    } else {
+        entry = (DatasetEntry *)malloc(sizeof(DatasetEntry));
+        assert(entry != NULL);
+        entry->id = id;
+        entry->dataset = datasettable_new_dataset(&table->defaults);
+        assert(entry->dataset != NULL);
+        entry->version = table->epoch;
+        assert(pthread_mutex_init(&entry->lock, NULL) == 0);
+
+        if (table->size == table->capacity) {
+            table->capacity *= 2;
+            table->entries = (DatasetEntry **)realloc(table->entries, table->capacity * sizeof(DatasetEntry *));
+            assert(table->entries != NULL);
+        }
+        hashmap_put(table->index, id, table->size);
+        table->entries[table->size++] = entry;
+    }
+    pthread_rwlock_unlock(&table->lock);
+    return entry;
+}
+
+void datasettable_for_each(DatasetTable* table, void (*fn)(DatasetEntry* entry, void* context), void* context)
+{
+    assert(table != NULL && fn != NULL);
+    pthread_rwlock_rdlock(&table->lock);
+    for (int i = 0; i < table->size; i++) {
+        DatasetEntry* entry = table->entries[i];
+        pthread_mutex_lock(&entry->lock);
+        fn(entry, context);
+        pthread_mutex_unlock(&entry->lock);
+    }
+    pthread_rwlock_unlock(&table->lock);
+}
+
+void datasettable_set_defaults(DatasetTable* table, const DatasetDefaults* defaults)
+{
+    assert(table != NULL && defaults != NULL);
+    pthread_rwlock_wrlock(&table->lock);    // Read by datasettable_get under the write lock
+    table->defaults = *defaults;
+    pthread_rwlock_unlock(&table->lock);
+}
+
+void datasettable_lock_all(DatasetTable* table)
+{
+    assert(table != NULL);
+    pthread_rwlock_rdlock(&table->lock);    // Same order as datasettable_for_each
+    for (int i = 0; i < table->size; i++) {
+        pthread_mutex_lock(&table->entries[i]->lock);
+    }
+}
+
+void datasettable_unlock_all(DatasetTable* table)
+{
+    assert(table != NULL);
+    for (int i = table->size - 1; i >= 0; i--) {
+        pthread_mutex_unlock(&table->entries[i]->lock);
+    }
+    pthread_rwlock_unlock(&table->lock);
+}
+
+int datasettable_size(DatasetTable* table)
+{
+    assert(table != NULL);
+    pthread_rwlock_rdlock(&table->lock);
+    int size = table->size;
+    pthread_rwlock_unlock(&table->lock);
+    return size;
+}
+
+void datasettable_destroy(DatasetTable* table)
+{
+    assert(table != NULL);
+    for (int i = 0; i < table->size; i++) {
+        dataset_destroy(table->entries[i]->dataset);
+        pthread_mutex_destroy(&table->entries[i]->lock);
+        free(table->entries[i]);
+    }
+    free(table->entries);
+    hashmap_destroy(table->index);
+    pthread_rwlock_destroy(&table->lock);
+    free(table);
+}
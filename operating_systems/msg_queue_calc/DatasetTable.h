@@ -0,0 +1,129 @@
+/**
+ * Dataset Table Header - Named Datasets with Per-Dataset Locks
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#pragma once
+#ifndef _DATASET_TABLE_H_
+#define _DATASET_TABLE_H_
+
+#include <pthread.h>
+
+#include "Dataset.h"
+#include "HashMap.h"
+
+/**
+ * Maps dataset ids to datasets. The table itself is guarded by a
+ * reader/writer lock, taken for writing only to add a dataset, and every
+ * dataset has its own mutex so requests on different datasets never
+ * contend. Entries are never removed, so an entry pointer stays valid
+ * after the table lock is released.
+ */
+
+// A dataset and its lock
+typedef struct {
+    unsigned int id;        // Dataset id
+    Dataset* dataset;       // The dataset, guarded by lock
+    pthread_mutex_t lock;   // Held for every operation on the dataset
+    unsigned long long version; // Bumped by every applied mutation, kept across Create
+} DatasetEntry;
+
+// Engine used for datasets created implicitly, by their first insert
+typedef struct {
+    engine_type engine;     // ENGINE_HEAP, ENGINE_DENSE or ENGINE_LAZY
+    value_type type;        // ENGINE_HEAP, ENGINE_LAZY: type of the numbers
+    int lo;                 // ENGINE_DENSE: smallest storable value
+    int hi;                 // ENGINE_DENSE: largest storable value
+    SketchConfig sketches;  // Distinct/top-k sizing
+} DatasetDefaults;
+
+// Dataset Table Struct
+typedef struct {
+    HashMap* index;             // Dataset id -> position in entries
+    DatasetEntry** entries;     // Entries, in creation order
+    int size;                   // Number of entries
+    int capacity;               // Space in entries
+    DatasetDefaults defaults;   // Engine for new datasets
+    unsigned long long epoch;   // First version of every dataset, the creation time in micro seconds
+    pthread_rwlock_t lock;      // Guards index and entries
+} DatasetTable;
+
+/**
+ * @brief Allocates and initializes a new, empty dataset table.
+ *
+ * @param[in] defaults, the engine for implicitly created datasets.
+ * @return DatasetTable*, the table.
+ */
+DatasetTable* datasettable_create(const DatasetDefaults* defaults);
+
+/**
+ * @brief Creates a new, empty dataset with the specified engine.
+ *
+ * @param[in] defaults, the engine (and sketch sizing) to use.
+ * @return Dataset*, the dataset, NULL if dense counts don't fit in memory.
+ */
+Dataset* datasettable_new_dataset(const DatasetDefaults* defaults);
+
+/**
+ * @brief Returns the entry for the specified dataset id,
+ * creating an empty dataset with the default engine if requested.
+ * The entry is returned unlocked.
+ *
+ * @param[inout] table, the table.
+ * @param[in] id, the dataset id.
+ * @param[in] create, whether to create the dataset if it doesn't exist.
+ * @return DatasetEntry*, the entry, NULL if it doesn't exist and !create.
+ */
+DatasetEntry* datasettable_get(DatasetTable* table, unsigned int id, bool create);
+
+/**
+ * @brief Calls fn on every entry, with the table read-locked
+ * and the entry's lock held.
+ *
+ * @param[in] table, the table.
+ * @param[in] fn, the function to call.
+ * @param[inout] context, passed to fn.
+ */
+void datasettable_for_each(DatasetTable* table, void (*fn)(DatasetEntry* entry, void* context), void* context);
+
+/**
+ * @brief Replaces the engine used for implicitly created datasets.
+ *
+ * @param[inout] table, the table.
+ * @param[in] defaults, the new engine.
+ */
+void datasettable_set_defaults(DatasetTable* table, const DatasetDefaults* defaults);
+
+/**
+ * @brief Locks the table and every dataset, so no command
+ * is in progress until datasettable_unlock_all.
+ *
+ * @param[inout] table, the table to lock.
+ */
+void datasettable_lock_all(DatasetTable* table);
+
+/**
+ * @brief Releases the locks taken by datasettable_lock_all.
+ *
+ * @param[inout] table, the table to unlock.
+ */
+void datasettable_unlock_all(DatasetTable* table);
+
+/**
+ * @brief Returns the number of datasets in the table.
+ *
+ * @param[in] table, the table.
+ * @return int, the size.
+ */
+int datasettable_size(DatasetTable* table);
+
+/**
+ * @brief Destroys the table and every dataset in it.
+ * No other thread may be using the table.
+ *
+ * @param[in] table, the table to destroy.
+ */
+void datasettable_destroy(DatasetTable* table);
+
+#endif
@@ -0,0 +1,157 @@
+/**
+ * Dense Counter - Counting Array over a Bounded Integer Range
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#include "DenseCounter.h"
+
+/**
+ * @brief Adds delta occurrences of n (at index idx
+ * in the counts) to every level of the hierarchy.
+ *
+ * @param[inout] counter, the counter to update.
+ * @param[in] idx, the index of n in the counts.
+ * @param[in] n, the number.
+ * @param[in] delta, the change in occurrences.
+ */
+void _update_levels(DenseCounter* counter, long idx, int n, long delta)
+{
+    long long weighted = (long long)n * delta;
+    long before = counter->counts[0][idx];
+    counter->counts[0][idx] += delta;
+    counter->distinct += (before == 0) - (counter->counts[0][idx] == 0);
+    for (int level = 1; level < counter->num_levels; level++) {
+        idx /= SUMMARY_FANOUT;
+        counter->counts[level][idx] += delta;
+        counter->sums[level][idx] += weighted;
+    }
+    counter->size += delta;
+    counter->sum += weighted;
+}
+
+DenseCounter* densecounter_create(int lo, int hi)
+{
+    assert(lo <= hi && (long)hi - lo < MAX_DENSE_RANGE);
+    DenseCounter* counter = (DenseCounter *)calloc(1, sizeof(DenseCounter));
+    if (counter == NULL) return NULL;
+
+    counter->lo = lo;
+    counter->hi = hi;
+
+    // Add summary levels until a single root remains.
+    long nodes = (long)hi - lo + 1;
+    do {
+        assert(counter->num_levels < MAX_SUMMARY_LEVELS);
+        int level = counter->num_levels++;
+        counter->level_size[level] = nodes;
+        counter->counts[level] = (long *)calloc(nodes, sizeof(long));
+        // Level 0 sums are count * value, no need to store them.
+        if (level > 0) counter->sums[level] = (long long *)calloc(nodes, sizeof(long long));
+        if (counter->counts[level] == NULL || (level > 0 && counter->sums[level] == NULL)) {
+            densecounter_destroy(counter);
+            return NULL;
+        }
+        nodes = (nodes + SUMMARY_FANOUT - 1) / SUMMARY_FANOUT;
+    } while (counter->level_size[counter->num_levels - 1] > 1);
+
+    return counter;
+}
+
+bool densecounter_insert(DenseCounter* counter, int n)
+{
+    assert(counter != NULL);
+    if (n < counter->lo || n > counter->hi) return false;
+    _update_levels(counter, (long)n - counter->lo, n, 1);
+    return true;
+}
+
+long densecounter_delete_all(DenseCounter* counter, int n)
+{
+    assert(counter != NULL);
+    if (n < counter->lo || n > counter->hi) return 0;
+
+    long idx = (long)n - counter->lo;
+    long removed = counter->counts[0][idx];
+    if (removed > 0) _update_levels(counter, idx, n, -removed);
+    return removed;
+}
+
+int densecounter_select(const DenseCounter* counter, long k)
+{
+    assert(counter != NULL && k >= 0 && k < counter->size);
+
+    // Descend from the root, at each level skip over whole children
+    // until the one holding the k-th element is found.
+    long node = 0;
+    for (int level = counter->num_levels - 2; level >= 0; level--) {
+        long child = node * SUMMARY_FANOUT;
+        while (k >= counter->counts[level][child]) {
+            k -= counter->counts[level][child++];
+        }
+        node = child;
+    }
+    return counter->lo + (int)node;
+}
+
+long densecounter_prefix(const DenseCounter* counter, int n, long long* sum)
+{
+    assert(counter != NULL);
+    long count = 0;
+    long long total = 0;
+
+    if (n >= counter->hi) {
+        count = counter->size;
+        total = counter->sum;
+    } else if (n >= counter->lo) {
+        // Climb from n to the root, at each level adding the
+        // siblings to the left of the current node.
+        long idx = (long)n - counter->lo;
+        for (long i = idx - idx % SUMMARY_FANOUT; i <= idx; i++) {
+            count += counter->counts[0][i];
+            total += (long long)counter->counts[0][i] * (counter->lo + i);
+        }
+        for (int level = 1; level < counter->num_levels; level++) {
+            idx /= SUMMARY_FANOUT;
+            for (long i = idx - idx % SUMMARY_FANOUT; i < idx; i++) {
+                count += counter->counts[level][i];
+                total += counter->sums[level][i];
+            }
+        }
+    }
+
+    if (sum != NULL) *sum = total;
+    return count;
+}
+
+long densecounter_size(const DenseCounter* counter)
+{
+    assert(counter != NULL);
+    return counter->size;
+}
+
+long long densecounter_get_sum(const DenseCounter* counter)
+{
+    assert(counter != NULL);
+    return counter->sum;
+}
+
+size_t densecounter_allocated_bytes(const DenseCounter* counter)
+{
+    assert(counter != NULL);
+    size_t bytes = sizeof(DenseCounter) + counter->level_size[0] * sizeof(long);
+    for (int level = 1; level < counter->num_levels; level++) {
+        bytes += counter->level_size[level] * (sizeof(long) + sizeof(long long));
+    }
+    return bytes;
+}
+
+void densecounter_destroy(DenseCounter* counter)
+{
+    assert(counter != NULL);
+    for (int level = 0; level < counter->num_levels; level++) {
+        free(counter->counts[level]);
+        free(counter->sums[level]);
+    }
+    free(counter);
+}
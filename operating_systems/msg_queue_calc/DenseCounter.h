@@ -0,0 +1,136 @@
+/**
+ * Dense Counter Header - Counting Array over a Bounded Integer Range
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#pragma once
+#ifndef _DENSE_COUNTER_H_
+#define _DENSE_COUNTER_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <assert.h>
+
+// Children summarized by each node of the level above
+#define SUMMARY_FANOUT 64
+// Enough levels for any int range with a fanout of 64
+#define MAX_SUMMARY_LEVELS 7
+// Values a counter may span, 2^24 (about 130 MB of counts)
+#define MAX_DENSE_RANGE (1L << 24)
+
+/**
+ * Stores a multiset of integers in [lo, hi] as one count per value.
+ * Above the counts sits a summary hierarchy: each level holds the count
+ * and sum of SUMMARY_FANOUT consecutive nodes of the level below, up to
+ * a single root. A 65536 value range has 3 levels above the counts.
+ *
+ * Insert and delete-all touch one node per level, O(log_64 range) which
+ * is constant for a declared range. Selecting the k-th smallest (median,
+ * minimum) and prefix counts/sums scan at most SUMMARY_FANOUT nodes per
+ * level, O(SUMMARY_FANOUT * log_64 range).
+ */
+
+// Dense Counter Struct
+typedef struct {
+    int lo;                                 // Smallest storable value
+    int hi;                                 // Largest storable value
+    int num_levels;                         // Levels, including the counts (level 0)
+    long level_size[MAX_SUMMARY_LEVELS];    // Nodes in each level
+    long* counts[MAX_SUMMARY_LEVELS];       // Occurrences under each node
+    long long* sums[MAX_SUMMARY_LEVELS];    // Sum of values under each node (level > 0)
+    long size;                              // Total occurrences
+    long distinct;                          // Values occurring at least once
+    long long sum;                          // Sum of all values
+} DenseCounter;
+
+/**
+ * @brief Allocates and initializes a new, empty
+ * dense counter for values in [lo, hi].
+ * Precondition: lo <= hi, hi - lo < MAX_DENSE_RANGE.
+ *
+ * @param[in] lo, the smallest storable value.
+ * @param[in] hi, the largest storable value.
+ * @return DenseCounter*, the dense counter, NULL if out of memory.
+ */
+DenseCounter* densecounter_create(int lo, int hi);
+
+/**
+ * @brief Inserts the specified number
+ * into the dense counter.
+ *
+ * @param[inout] counter, the counter to insert into.
+ * @param[in] n, the number to insert.
+ * @return true if inserted, false if n is out of range.
+ */
+bool densecounter_insert(DenseCounter* counter, int n);
+
+/**
+ * @brief Deletes all instances of n
+ * from the dense counter.
+ *
+ * @param[inout] counter, the counter to delete from.
+ * @param[in] n, the number to delete.
+ * @return long, the number of elements removed.
+ */
+long densecounter_delete_all(DenseCounter* counter, int n);
+
+/**
+ * @brief Returns the k-th smallest (0-indexed) number
+ * in the dense counter.
+ * Precondition: 0 <= k < size.
+ *
+ * @param[in] counter, the counter to select from.
+ * @param[in] k, the rank to select.
+ * @return int, the k-th smallest number.
+ */
+int densecounter_select(const DenseCounter* counter, long k);
+
+/**
+ * @brief Returns the count of the numbers <= n,
+ * and optionally their sum.
+ *
+ * @param[in] counter, the counter to query.
+ * @param[in] n, the inclusive upper bound.
+ * @param[out] sum, stores the sum of the numbers <= n (nullable).
+ * @return long, the count.
+ */
+long densecounter_prefix(const DenseCounter* counter, int n, long long* sum);
+
+/**
+ * @brief Returns the number of elements
+ * in the dense counter.
+ *
+ * @param[in] counter, the counter to get the size of.
+ * @return long, the size.
+ */
+long densecounter_size(const DenseCounter* counter);
+
+/**
+ * @brief Returns the sum of the elements
+ * in the dense counter.
+ *
+ * @param[in] counter, the counter to get the sum of.
+ * @return long long, the sum.
+ */
+long long densecounter_get_sum(const DenseCounter* counter);
+
+/**
+ * @brief Returns the number of bytes allocated
+ * by the specified dense counter.
+ *
+ * @param[in] counter, the counter.
+ * @return size_t, the allocated bytes.
+ */
+size_t densecounter_allocated_bytes(const DenseCounter* counter);
+
+/**
+ * @brief Destroys and cleans up the
+ * specified dense counter.
+ *
+ * @param[in] counter, the counter to destroy.
+ */
+void densecounter_destroy(DenseCounter* counter);
+
+#endif
@@ -0,0 +1,146 @@
+/**
+ * Frequency Sketch - Distinct Counts and Heavy Hitters
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#include "FrequencySketch.h"
+
+#define INITIAL_COUNTS 16   // Exact mode map capacity, grows up to exact_limit
+
+/**
+ * @brief Folds the exact counts into the HyperLogLog
+ * and Space Saving sketches and leaves exact mode.
+ *
+ * @param[inout] sketch, the sketch.
+ */
+void _switch_to_sketches(FrequencySketch* sketch)
+{
+    if (sketch->hll == NULL) sketch->hll = hyperloglog_create(sketch->config.hll_precision);
+    if (sketch->topk == NULL) sketch->topk = spacesaving_create(sketch->config.topk_capacity);
+
+    int cursor = 0;
+    long long value;
+    long count;
+    while (hashmap_next(sketch->counts, &cursor, &value, &count)) {
+        hyperloglog_add(sketch->hll, hash_int64(value));
+        spacesaving_add(sketch->topk, value, count);
+    }
+    hashmap_clear(sketch->counts);
+    sketch->exact = false;
+}
+
+void sketchconfig_default(SketchConfig* config)
+{
+    assert(config != NULL);
+    config->hll_precision = DEFAULT_HLL_PRECISION;
+    config->topk_capacity = DEFAULT_TOPK_CAPACITY;
+    config->exact_limit = DEFAULT_EXACT_LIMIT;
+}
+
+FrequencySketch* frequencysketch_create(const SketchConfig* config)
+{
+    assert(config != NULL && config->exact_limit >= 0);
+    FrequencySketch* sketch = (FrequencySketch *)calloc(1, sizeof(FrequencySketch));
+    assert(sketch != NULL);
+
+    sketch->config = *config;
+    sketch->exact = true;
+    // Start small, a calculator may hold thousands of mostly small datasets.
+    sketch->counts = hashmap_create(INITIAL_COUNTS);
+    return sketch;
+}
+
+void frequencysketch_add(FrequencySketch* sketch, long long value, long weight)
+{
+    assert(sketch != NULL && weight > 0);
+    if (sketch->exact) {
+        hashmap_add(sketch->counts, value, weight);
+        sketch->ranked_valid = false;
+        if (hashmap_size(sketch->counts) > sketch->config.exact_limit) _switch_to_sketches(sketch);
+        return;
+    }
+    hyperloglog_add(sketch->hll, hash_int64(value));
+    spacesaving_add(sketch->topk, value, weight);
+}
+
+void frequencysketch_delete_all(FrequencySketch* sketch, long long value)
+{
+    assert(sketch != NULL);
+    if (sketch->exact) {
+        if (hashmap_remove(sketch->counts, value) != 0) sketch->ranked_valid = false;
+        return;
+    }
+    spacesaving_remove(sketch->topk, value);
+    sketch->deleted = true;
+}
+
+void frequencysketch_clear(FrequencySketch* sketch)
+{
+    assert(sketch != NULL);
+    hashmap_clear(sketch->counts);
+    if (sketch->hll != NULL) hyperloglog_clear(sketch->hll);
+    if (sketch->topk != NULL) spacesaving_clear(sketch->topk);
+    sketch->exact = true;
+    sketch->ranked_valid = false;
+    sketch->deleted = false;
+}
+
+bool frequencysketch_distinct(const FrequencySketch* sketch, double* distinct, double* error)
+{
+    assert(sketch != NULL && distinct != NULL && error != NULL);
+    if (sketch->exact) {
+        *distinct = hashmap_size(sketch->counts);
+        *error = 0;
+        return true;
+    }
+    if (sketch->deleted) return false;
+    *distinct = hyperloglog_estimate(sketch->hll);
+    *error = *distinct * hyperloglog_error(sketch->hll);
+    return true;
+}
+
+bool frequencysketch_topk(FrequencySketch* sketch, int rank, Counter* counter)
+{
+    assert(sketch != NULL && counter != NULL);
+    if (!sketch->exact) return spacesaving_get(sketch->topk, rank, counter);
+
+    int size = hashmap_size(sketch->counts);
+    if (rank < 1 || rank > size) return false;
+    if (!sketch->ranked_valid) {
+        if (size > sketch->ranked_capacity) {
+            sketch->ranked_capacity = size;
+            sketch->ranked = (Counter *)realloc(sketch->ranked, size * sizeof(Counter));
+            assert(sketch->ranked != NULL);
+        }
+        int cursor = 0, i = 0;
+        Counter entry = { 0 };
+        while (hashmap_next(sketch->counts, &cursor, &entry.value, &entry.count)) {
+            sketch->ranked[i++] = entry;
+        }
+        qsort(sketch->ranked, size, sizeof(Counter), counter_rank_compare);
+        sketch->ranked_valid = true;
+    }
+    *counter = sketch->ranked[rank - 1];
+    return true;
+}
+
+size_t frequencysketch_allocated_bytes(const FrequencySketch* sketch)
+{
+    assert(sketch != NULL);
+    size_t bytes = sizeof(FrequencySketch) + hashmap_allocated_bytes(sketch->counts) +
+        sketch->ranked_capacity * sizeof(Counter);
+    if (sketch->hll != NULL) bytes += hyperloglog_allocated_bytes(sketch->hll);
+    if (sketch->topk != NULL) bytes += spacesaving_allocated_bytes(sketch->topk);
+    return bytes;
+}
+
+void frequencysketch_destroy(FrequencySketch* sketch)
+{
+    assert(sketch != NULL);
+    hashmap_destroy(sketch->counts);
+    free(sketch->ranked);
+    if (sketch->hll != NULL) hyperloglog_destroy(sketch->hll);
+    if (sketch->topk != NULL) spacesaving_destroy(sketch->topk);
+    free(sketch);
+}
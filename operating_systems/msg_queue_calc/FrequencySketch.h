@@ -0,0 +1,131 @@
+/**
+ * Frequency Sketch Header - Distinct Counts and Heavy Hitters
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#pragma once
+#ifndef _FREQUENCY_SKETCH_H_
+#define _FREQUENCY_SKETCH_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "HashMap.h"
+#include "HyperLogLog.h"
+#include "SpaceSaving.h"
+
+#define DEFAULT_HLL_PRECISION 14    // 16 KiB of registers, 0.81% standard error
+#define DEFAULT_TOPK_CAPACITY 64    // Counters kept for the heavy hitters
+#define DEFAULT_EXACT_LIMIT 1024    // Distinct values counted exactly before sketching
+
+// Sketch sizing, picks the memory / error trade-off
+typedef struct {
+    int hll_precision;  // HyperLogLog registers = 2^hll_precision
+    int topk_capacity;  // Space Saving counters
+    int exact_limit;    // Distinct values kept in an exact count map
+} SketchConfig;
+
+/**
+ * Answers distinct-count and top-k queries incrementally. While the
+ * number of distinct values is at most exact_limit, every value is
+ * counted exactly in a hash map. Past that, the map is folded into a
+ * HyperLogLog and a Space Saving sketch and dropped, so memory stays fixed.
+ *
+ * A delete in sketch mode frees the value's Space Saving counter. The
+ * HyperLogLog can't forget a value, so after a delete the distinct count
+ * is left to the owner, which knows it exactly from its own data.
+ */
+
+// Frequency Sketch Struct
+typedef struct {
+    SketchConfig config;    // Sizing
+    bool exact;             // Whether counts are still exact
+    HashMap* counts;        // Exact mode: value -> occurrences
+    Counter* ranked;        // Exact mode: counts sorted for top-k, cached
+    int ranked_capacity;    // Space in ranked, grown on demand
+    bool ranked_valid;      // Exact mode: whether ranked is up to date
+    HyperLogLog* hll;       // Sketch mode: distinct values
+    SpaceSaving* topk;      // Sketch mode: heavy hitters
+    bool deleted;           // Sketch mode: a delete happened, the HyperLogLog overcounts
+} FrequencySketch;
+
+/**
+ * @brief Fills in the default sketch configuration.
+ *
+ * @param[out] config, the configuration to fill in.
+ */
+void sketchconfig_default(SketchConfig* config);
+
+/**
+ * @brief Allocates and initializes a new, empty, exact frequency
+ * sketch with the specified configuration.
+ *
+ * @param[in] config, the sketch sizing.
+ * @return FrequencySketch*, the sketch.
+ */
+FrequencySketch* frequencysketch_create(const SketchConfig* config);
+
+/**
+ * @brief Adds weight occurrences of value.
+ *
+ * @param[inout] sketch, the sketch.
+ * @param[in] value, the value.
+ * @param[in] weight, the occurrences.
+ */
+void frequencysketch_add(FrequencySketch* sketch, long long value, long weight);
+
+/**
+ * @brief Removes all occurrences of value, in O(1).
+ *
+ * @param[inout] sketch, the sketch.
+ * @param[in] value, the value.
+ */
+void frequencysketch_delete_all(FrequencySketch* sketch, long long value);
+
+/**
+ * @brief Resets the sketch to empty and exact.
+ *
+ * @param[inout] sketch, the sketch.
+ */
+void frequencysketch_clear(FrequencySketch* sketch);
+
+/**
+ * @brief Gets the number of distinct values, unless a delete in
+ * sketch mode left the owner to count them.
+ *
+ * @param[in] sketch, the sketch.
+ * @param[out] distinct, stores the (estimated) distinct count.
+ * @param[out] error, stores the absolute standard error, 0 if exact.
+ * @return true if answered, false if the owner must count them.
+ */
+bool frequencysketch_distinct(const FrequencySketch* sketch, double* distinct, double* error);
+
+/**
+ * @brief Gets the rank-th (1-indexed) most frequent value.
+ *
+ * @param[inout] sketch, the sketch (the ranking is cached).
+ * @param[in] rank, the rank.
+ * @param[out] counter, stores the value, its count and the count's
+ * maximum overestimate (0 if exact).
+ * @return true if there is such a value, else false.
+ */
+bool frequencysketch_topk(FrequencySketch* sketch, int rank, Counter* counter);
+
+/**
+ * @brief Returns the number of bytes allocated by the sketch.
+ *
+ * @param[in] sketch, the sketch.
+ * @return size_t, the allocated bytes.
+ */
+size_t frequencysketch_allocated_bytes(const FrequencySketch* sketch);
+
+/**
+ * @brief Destroys and cleans up the specified sketch.
+ *
+ * @param[in] sketch, the sketch to destroy.
+ */
+void frequencysketch_destroy(FrequencySketch* sketch);
+
+#endif
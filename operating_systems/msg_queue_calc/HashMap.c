@@ -0,0 +1,196 @@
+/**
+ * Hash Map - Open Addressing Integer Map
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#include <string.h>
+
+#include "HashMap.h"
+
+uint64_t hash_int64(long long key)
+{
+    uint64_t x = (uint64_t)key + 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+/**
+ * @brief Returns the slot holding the specified key, or
+ * the empty slot that ends its probe run.
+ *
+ * @param[in] map, the map to search.
+ * @param[in] key, the key to search for.
+ * @return int, the slot.
+ */
+int _find_slot(const HashMap* map, long long key)
+{
+    int mask = map->capacity - 1;
+    int slot = hash_int64(key) & mask;
+    while (map->used[slot] && map->keys[slot] != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/**
+ * @brief Allocates the slot arrays of the specified map.
+ *
+ * @param[inout] map, the map.
+ * @param[in] capacity, the number of slots (power of two).
+ */
+void _allocate_slots(HashMap* map, int capacity)
+{
+    map->capacity = capacity;
+    map->keys = (long long *)malloc(capacity * sizeof(long long));
+    map->values = (long *)malloc(capacity * sizeof(long));
+    map->used = (bool *)calloc(capacity, sizeof(bool));
+    assert(map->keys != NULL && map->values != NULL && map->used != NULL);
+}
+
+/**
+ * @brief Doubles the number of slots of the
+ * specified map and reinserts every entry.
+ *
+ * @param[inout] map, the map to grow.
+ */
+void _grow_slots(HashMap* map)
+{
+    long long* keys = map->keys;
+    long* values = map->values;
+    bool* used = map->used;
+    int capacity = map->capacity;
+
+    _allocate_slots(map, 2 * capacity);
+    for (int i = 0; i < capacity; i++) {
+        if (!used[i]) continue;
+        int slot = _find_slot(map, keys[i]);
+        map->used[slot] = true;
+        map->keys[slot] = keys[i];
+        map->values[slot] = values[i];
+    }
+
+    free(keys);
+    free(values);
+    free(used);
+}
+
+HashMap* hashmap_create(int capacity)
+{
+    HashMap* map = (HashMap *)malloc(sizeof(HashMap));
+    assert(map != NULL);
+
+    // Smallest power of two keeping capacity entries 3/4 full.
+    int slots = 8;
+    while (slots * 3 < capacity * 4) slots *= 2;
+    _allocate_slots(map, slots);
+    map->size = 0;
+    return map;
+}
+
+bool hashmap_get(const HashMap* map, long long key, long* value)
+{
+    assert(map != NULL);
+    int slot = _find_slot(map, key);
+    if (!map->used[slot]) return false;
+    if (value != NULL) *value = map->values[slot];
+    return true;
+}
+
+void hashmap_put(HashMap* map, long long key, long value)
+{
+    assert(map != NULL);
+    int slot = _find_slot(map, key);
+    if (!map->used[slot]) {
+        if (4 * (map->size + 1) > 3 * map->capacity) {
+            _grow_slots(map);
+            slot = _find_slot(map, key);
+        }
+        map->used[slot] = true;
+        map->keys[slot] = key;
+        map->size++;
+    }
+    map->values[slot] = value;
+}
+
+long hashmap_add(HashMap* map, long long key, long delta)
+{
+    assert(map != NULL);
+    long value = 0;
+    hashmap_get(map, key, &value);
+    value += delta;
+
+    if (value == 0) hashmap_remove(map, key);
+    else hashmap_put(map, key, value);
+    return value;
+}
+
+long hashmap_remove(HashMap* map, long long key)
+{
+    assert(map != NULL);
+    int mask = map->capacity - 1;
+    int hole = _find_slot(map, key);
+    if (!map->used[hole]) return 0;
+
+    long value = map->values[hole];
+    map->used[hole] = false;
+    map->size--;
+
+    // Shift back any entry of the probe run that
+    // would no longer be reachable past the hole.
+    for (int slot = (hole + 1) & mask; map->used[slot]; slot = (slot + 1) & mask) {
+        int home = hash_int64(map->keys[slot]) & mask;
+        // Entry can move into the hole if its home is not in (hole, slot].
+        bool movable = (hole <= slot) ? (home <= hole || home > slot) : (home <= hole && home > slot);
+        if (!movable) continue;
+
+        map->keys[hole] = map->keys[slot];
+        map->values[hole] = map->values[slot];
+        map->used[hole] = true;
+        map->used[slot] = false;
+        hole = slot;
+    }
+    return value;
+}
+
+bool hashmap_next(const HashMap* map, int* cursor, long long* key, long* value)
+{
+    assert(map != NULL && cursor != NULL);
+    while (*cursor < map->capacity) {
+        int slot = (*cursor)++;
+        if (!map->used[slot]) continue;
+        *key = map->keys[slot];
+        *value = map->values[slot];
+        return true;
+    }
+    return false;
+}
+
+int hashmap_size(const HashMap* map)
+{
+    assert(map != NULL);
+    return map->size;
+}
+
+void hashmap_clear(HashMap* map)
+{
+    assert(map != NULL);
+    memset(map->used, 0, map->capacity * sizeof(bool));
+    map->size = 0;
+}
+
+size_t hashmap_allocated_bytes(const HashMap* map)
+{
+    assert(map != NULL);
+    return sizeof(HashMap) + map->capacity * (sizeof(long long) + sizeof(long) + sizeof(bool));
+}
+
+void hashmap_destroy(HashMap* map)
+{
+    assert(map != NULL);
+    free(map->keys);
+    free(map->values);
+    free(map->used);
+    free(map);
+}
@@ -0,0 +1,134 @@
+/**
+ * Hash Map Header - Open Addressing Integer Map
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#pragma once
+#ifndef _HASH_MAP_H_
+#define _HASH_MAP_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+/**
+ * Maps 64-bit integer keys to long values with linear probing
+ * in power of two tables kept at most 3/4 full. Removals shift the
+ * following probe run back rather than leaving tombstones.
+ */
+
+// Hash Map Struct
+typedef struct {
+    long long* keys;    // Key in each slot
+    long* values;       // Value in each slot
+    bool* used;         // Whether each slot holds an entry
+    int capacity;       // Number of slots (power of two)
+    int size;           // Number of entries
+} HashMap;
+
+/**
+ * @brief Mixes the bits of the specified key (splitmix64
+ * finalizer), for hash tables and sketches.
+ *
+ * @param[in] key, the key to hash.
+ * @return uint64_t, the hash.
+ */
+uint64_t hash_int64(long long key);
+
+/**
+ * @brief Allocates and initializes a new, empty hash map
+ * with room for at least the specified number of entries.
+ *
+ * @param[in] capacity, the initializing number of entries.
+ * @return HashMap*, the hash map.
+ */
+HashMap* hashmap_create(int capacity);
+
+/**
+ * @brief Gets the value mapped to the specified key.
+ *
+ * @param[in] map, the map to search.
+ * @param[in] key, the key to look up.
+ * @param[out] value, stores the value if found (nullable).
+ * @return true if the key is mapped, else false.
+ */
+bool hashmap_get(const HashMap* map, long long key, long* value);
+
+/**
+ * @brief Adds delta to the value mapped to the specified key,
+ * mapping it from 0 first if needed. The key is removed
+ * when its value becomes 0.
+ *
+ * @param[inout] map, the map to update.
+ * @param[in] key, the key to update.
+ * @param[in] delta, the amount to add.
+ * @return long, the new value.
+ */
+long hashmap_add(HashMap* map, long long key, long delta);
+
+/**
+ * @brief Maps the specified key to the specified value.
+ *
+ * @param[inout] map, the map to update.
+ * @param[in] key, the key to map.
+ * @param[in] value, the value.
+ */
+void hashmap_put(HashMap* map, long long key, long value);
+
+/**
+ * @brief Removes the specified key from the map.
+ *
+ * @param[inout] map, the map to remove from.
+ * @param[in] key, the key to remove.
+ * @return long, the value that was mapped, 0 if none.
+ */
+long hashmap_remove(HashMap* map, long long key);
+
+/**
+ * @brief Iterates over the entries of the map. Start with
+ * *cursor = 0 and call until it returns false. The map
+ * must not be modified during the iteration.
+ *
+ * @param[in] map, the map to iterate.
+ * @param[inout] cursor, the iteration position.
+ * @param[out] key, stores the next key.
+ * @param[out] value, stores the next value.
+ * @return true if an entry was returned, false when done.
+ */
+bool hashmap_next(const HashMap* map, int* cursor, long long* key, long* value);
+
+/**
+ * @brief Returns the number of entries in the map.
+ *
+ * @param[in] map, the map.
+ * @return int, the size.
+ */
+int hashmap_size(const HashMap* map);
+
+/**
+ * @brief Removes all entries from the map.
+ *
+ * @param[inout] map, the map to clear.
+ */
+void hashmap_clear(HashMap* map);
+
+/**
+ * @brief Returns the number of bytes allocated
+ * by the specified map.
+ *
+ * @param[in] map, the map.
+ * @return size_t, the allocated bytes.
+ */
+size_t hashmap_allocated_bytes(const HashMap* map);
+
+/**
+ * @brief Destroys and cleans up the specified map.
+ *
+ * @param[in] map, the map to destroy.
+ */
+void hashmap_destroy(HashMap* map);
+
+#endif
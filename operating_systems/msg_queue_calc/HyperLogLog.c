@@ -0,0 +1,80 @@
+/**
+ * HyperLogLog - Distinct Count Sketch
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "HyperLogLog.h"
+
+HyperLogLog* hyperloglog_create(int precision)
+{
+    assert(precision >= HLL_MIN_PRECISION && precision <= HLL_MAX_PRECISION);
+    HyperLogLog* hll = (HyperLogLog *)malloc(sizeof(HyperLogLog));
+    assert(hll != NULL);
+
+    hll->precision = precision;
+    hll->registers = (uint8_t *)calloc((size_t)1 << precision, sizeof(uint8_t));
+    assert(hll->registers != NULL);
+    return hll;
+}
+
+void hyperloglog_add(HyperLogLog* hll, uint64_t hash)
+{
+    assert(hll != NULL);
+    // Top bits pick the bucket, the rest give the run of leading zeros.
+    uint64_t bucket = hash >> (64 - hll->precision);
+    uint64_t rest = (hash << hll->precision) | ((uint64_t)1 << (hll->precision - 1));
+    uint8_t rank = __builtin_clzll(rest) + 1;
+
+    if (rank > hll->registers[bucket]) hll->registers[bucket] = rank;
+}
+
+double hyperloglog_estimate(const HyperLogLog* hll)
+{
+    assert(hll != NULL);
+    int m = 1 << hll->precision;
+    double alpha = (m == 16) ? 0.673 : (m == 32) ? 0.697 : (m == 64) ? 0.709 : 0.7213 / (1 + 1.079 / m);
+
+    // Harmonic mean of 2^register over all buckets.
+    double harmonic = 0;
+    int zeros = 0;
+    for (int i = 0; i < m; i++) {
+        harmonic += ldexp(1.0, -hll->registers[i]);
+        if (hll->registers[i] == 0) zeros++;
+    }
+    double estimate = alpha * m * m / harmonic;
+
+    // Small cardinalities: linear counting over the empty buckets is more accurate.
+    if (estimate <= 2.5 * m && zeros > 0) {
+        estimate = m * log((double)m / zeros);
+    }
+    return estimate;
+}
+
+double hyperloglog_error(const HyperLogLog* hll)
+{
+    assert(hll != NULL);
+    return 1.04 / sqrt((double)(1 << hll->precision));
+}
+
+void hyperloglog_clear(HyperLogLog* hll)
+{
+    assert(hll != NULL);
+    memset(hll->registers, 0, (size_t)1 << hll->precision);
+}
+
+size_t hyperloglog_allocated_bytes(const HyperLogLog* hll)
+{
+    assert(hll != NULL);
+    return sizeof(HyperLogLog) + ((size_t)1 << hll->precision);
+}
+
+void hyperloglog_destroy(HyperLogLog* hll)
+{
+    assert(hll != NULL);
+    free(hll->registers);
+    free(hll);
+}
@@ -0,0 +1,85 @@
+/**
+ * HyperLogLog Header - Distinct Count Sketch
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#pragma once
+#ifndef _HYPER_LOG_LOG_H_
+#define _HYPER_LOG_LOG_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+
+#define HLL_MIN_PRECISION 4
+#define HLL_MAX_PRECISION 16
+
+/**
+ * Estimates the number of distinct values added with 2^precision
+ * one byte registers. The relative standard error is 1.04 / sqrt(2^precision),
+ * e.g. 0.81% with 16 KiB of registers at precision 14.
+ */
+
+// HyperLogLog Struct
+typedef struct {
+    uint8_t* registers;     // Max leading zero run + 1 seen in each bucket
+    int precision;          // Bits of the hash selecting the bucket
+} HyperLogLog;
+
+/**
+ * @brief Allocates and initializes a new, empty
+ * sketch with 2^precision registers.
+ *
+ * @param[in] precision, in [HLL_MIN_PRECISION, HLL_MAX_PRECISION].
+ * @return HyperLogLog*, the sketch.
+ */
+HyperLogLog* hyperloglog_create(int precision);
+
+/**
+ * @brief Adds a value, by its 64-bit hash, to the sketch.
+ *
+ * @param[inout] hll, the sketch.
+ * @param[in] hash, the hash of the value.
+ */
+void hyperloglog_add(HyperLogLog* hll, uint64_t hash);
+
+/**
+ * @brief Returns the estimated number of distinct values added.
+ *
+ * @param[in] hll, the sketch.
+ * @return double, the estimate.
+ */
+double hyperloglog_estimate(const HyperLogLog* hll);
+
+/**
+ * @brief Returns the relative standard error of the sketch's estimates.
+ *
+ * @param[in] hll, the sketch.
+ * @return double, the relative standard error.
+ */
+double hyperloglog_error(const HyperLogLog* hll);
+
+/**
+ * @brief Resets the sketch to empty.
+ *
+ * @param[inout] hll, the sketch.
+ */
+void hyperloglog_clear(HyperLogLog* hll);
+
+/**
+ * @brief Returns the number of bytes allocated by the sketch.
+ *
+ * @param[in] hll, the sketch.
+ * @return size_t, the allocated bytes.
+ */
+size_t hyperloglog_allocated_bytes(const HyperLogLog* hll);
+
+/**
+ * @brief Destroys and cleans up the specified sketch.
+ *
+ * @param[in] hll, the sketch to destroy.
+ */
+void hyperloglog_destroy(HyperLogLog* hll);
+
+#endif
@@ -0,0 +1,28 @@
+/**
+ * Lazy Median - Append Buffer with Cached Selection
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#include <string.h>
+#include <pthread.h>
+
+#include "LazyMedian.h"
+
+// LazyMedian_i64
+#define TEMPLATE_TYPE TEMPLATE_I64_TYPE
+#define TEMPLATE_SUM_TYPE TEMPLATE_I64_SUM_TYPE
+#define TEMPLATE_SUFFIX i64
+#include "LazyMedianTemplate.c"
+#undef TEMPLATE_TYPE
+#undef TEMPLATE_SUM_TYPE
+#undef TEMPLATE_SUFFIX
+
+// LazyMedian_f64
+#define TEMPLATE_TYPE TEMPLATE_F64_TYPE
+#define TEMPLATE_SUM_TYPE TEMPLATE_F64_SUM_TYPE
+#define TEMPLATE_SUFFIX f64
+#include "LazyMedianTemplate.c"
+#undef TEMPLATE_TYPE
+#undef TEMPLATE_SUM_TYPE
+#undef TEMPLATE_SUFFIX
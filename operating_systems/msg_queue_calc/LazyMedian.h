@@ -0,0 +1,60 @@
+/**
+ * Lazy Median Header - Append Buffer with Cached Selection
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#pragma once
+#ifndef _LAZY_MEDIAN_H_
+#define _LAZY_MEDIAN_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "Template.h"
+#include "HashMap.h"
+
+#define LAZY_PARALLEL_MIN (1 << 20)     // Elements from which a selection is split across threads
+#define LAZY_THREADS 4                  // Threads a large selection is split across
+
+/**
+ * A median structure for write heavy, rarely read datasets. Inserts
+ * append to an unordered array in O(1) amortized, deletes only record
+ * a tombstone in O(1); nothing is ordered until a read needs it.
+ *
+ * The first Median after a mutation applies the pending deletes in one
+ * pass and runs an introselect (quickselect with a median of three pivot
+ * and three way partitioning, falling back to sorting the remaining range
+ * past 2 log2(n) rounds) for the middle element(s), O(n) expected. Ranges
+ * of LAZY_PARALLEL_MIN elements or more are partitioned by LAZY_THREADS
+ * threads, each counting then scattering its own slice. Minimum and
+ * maximum are found by a single pass. Results are cached until the next
+ * insert or delete, so reads between two write batches are O(1).
+ *
+ * A tombstone records the array length when its key was deleted: only
+ * copies before that position are deleted, so a key inserted again after
+ * its delete survives. Occurrences of every key are counted in a hash map,
+ * so the size (and a delete's count) are always exact.
+ */
+
+// LazyMedian_i64, lazymedian_*_i64: lazy median of long long
+#define TEMPLATE_TYPE TEMPLATE_I64_TYPE
+#define TEMPLATE_SUM_TYPE TEMPLATE_I64_SUM_TYPE
+#define TEMPLATE_SUFFIX i64
+#include "LazyMedianTemplate.h"
+#undef TEMPLATE_TYPE
+#undef TEMPLATE_SUM_TYPE
+#undef TEMPLATE_SUFFIX
+
+// LazyMedian_f64, lazymedian_*_f64: lazy median of double
+#define TEMPLATE_TYPE TEMPLATE_F64_TYPE
+#define TEMPLATE_SUM_TYPE TEMPLATE_F64_SUM_TYPE
+#define TEMPLATE_SUFFIX f64
+#include "LazyMedianTemplate.h"
+#undef TEMPLATE_TYPE
+#undef TEMPLATE_SUM_TYPE
+#undef TEMPLATE_SUFFIX
+
+#endif
@@ -0,0 +1,391 @@
+/**
+ * Lazy Median Template - Append Buffer with Cached Selection
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ *
+ * Included by LazyMedian.c once per value type, see Template.h.
+ */
+
+// A thread's slice of a parallel partition
+typedef struct {
+    const TEMPLATE_TYPE* from;  // The range being partitioned
+    TEMPLATE_TYPE* to;          // Where the partitioned range is written
+    long begin;                 // First element of the slice
+    long end;                   // One past the last element of the slice
+    TEMPLATE_TYPE pivot;        // The pivot
+    long counts[3];             // Elements below, equal to and above the pivot
+    long offsets[3];            // Where the slice writes each group in to
+} TEMPLATE(_PartitionSlice);
+
+long long TEMPLATE(lazymedian_key)(TEMPLATE_TYPE n)
+{
+    long long key = 0;
+    if (n == 0) n = 0;
+    memcpy(&key, &n, sizeof(n));
+    return key;
+}
+
+/**
+ * @brief Orders two numbers for qsort.
+ *
+ * @param[in] a, the first number.
+ * @param[in] b, the second number.
+ * @return int, negative, 0 or positive if a is below, equal to or above b.
+ */
+int TEMPLATE(_compare)(const void* a, const void* b)
+{
+    TEMPLATE_TYPE x = *(const TEMPLATE_TYPE *)a, y = *(const TEMPLATE_TYPE *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Returns the median of three numbers.
+ *
+ * @param[in] a, b, c, the numbers.
+ * @return TEMPLATE_TYPE, the median.
+ */
+TEMPLATE_TYPE TEMPLATE(_median3)(TEMPLATE_TYPE a, TEMPLATE_TYPE b, TEMPLATE_TYPE c)
+{
+    if (a > b) { TEMPLATE_TYPE t = a; a = b; b = t; }
+    if (b > c) b = c;
+    return (a > b) ? a : b;
+}
+
+/**
+ * @brief Returns the number of partitioning rounds after which
+ * a selection over n elements gives up and sorts: 2 log2(n).
+ *
+ * @param[in] n, the number of elements.
+ * @return int, the rounds.
+ */
+int TEMPLATE(_depth_limit)(long n)
+{
+    int depth = 0;
+    while (n > 1) { n >>= 1; depth += 2; }
+    return depth;
+}
+
+/**
+ * @brief Moves the k-th smallest element of items[lo, hi) to
+ * position k, smaller or equal elements before it and larger or
+ * equal ones after it.
+ *
+ * @param[inout] items, the elements.
+ * @param[in] lo, the first element of the range.
+ * @param[in] hi, one past the last element of the range.
+ * @param[in] k, the position to select, lo <= k < hi.
+ */
+void TEMPLATE(_introselect)(TEMPLATE_TYPE* items, long lo, long hi, long k)
+{
+    int depth = TEMPLATE(_depth_limit)(hi - lo);
+    while (hi - lo > 1) {
+        if (depth-- == 0) {
+            qsort(items + lo, hi - lo, sizeof(TEMPLATE_TYPE), TEMPLATE(_compare));
+            return;
+        }
+
+        // Three way partition: [lo, lt) < pivot, [lt, gt) == pivot, [gt, hi) > pivot.
+        TEMPLATE_TYPE pivot = TEMPLATE(_median3)(items[lo], items[lo + (hi - lo) / 2], items[hi - 1]);
+        long lt = lo, i = lo, gt = hi;
+        while (i < gt) {
+            TEMPLATE_TYPE item = items[i];
+            if (item < pivot) {
+                items[i++] = items[lt];
+                items[lt++] = item;
+            } else if (item > pivot) {
+                items[i] = items[--gt];
+                items[gt] = item;
+            } else {
+                i++;
+            }
+        }
+        if (k < lt) hi = lt;
+        else if (k >= gt) lo = gt;
+        else return;
+    }
+}
+
+/**
+ * @brief Thread body, counts the slice's elements below,
+ * equal to and above the pivot.
+ *
+ * @param[inout] arg, the TEMPLATE(_PartitionSlice).
+ * @return void*, NULL.
+ */
+void* TEMPLATE(_count_slice)(void* arg)
+{
+    TEMPLATE(_PartitionSlice)* slice = (TEMPLATE(_PartitionSlice) *)arg;
+    long below = 0, equal = 0;
+    for (long i = slice->begin; i < slice->end; i++) {
+        below += slice->from[i] < slice->pivot;
+        equal += slice->from[i] == slice->pivot;
+    }
+    slice->counts[0] = below;
+    slice->counts[1] = equal;
+    slice->counts[2] = (slice->end - slice->begin) - below - equal;
+    return NULL;
+}
+
+/**
+ * @brief Thread body, writes the slice's elements to
+ * its offsets in each group.
+ *
+ * @param[inout] arg, the TEMPLATE(_PartitionSlice).
+ * @return void*, NULL.
+ */
+void* TEMPLATE(_scatter_slice)(void* arg)
+{
+    TEMPLATE(_PartitionSlice)* slice = (TEMPLATE(_PartitionSlice) *)arg;
+    long next[3] = { slice->offsets[0], slice->offsets[1], slice->offsets[2] };
+    for (long i = slice->begin; i < slice->end; i++) {
+        TEMPLATE_TYPE item = slice->from[i];
+        int group = (item < slice->pivot) ? 0 : (item == slice->pivot) ? 1 : 2;
+        slice->to[next[group]++] = item;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Runs the body on every slice, one thread each.
+ *
+ * @param[inout] slices, the slices.
+ * @param[in] body, the thread body.
+ */
+void TEMPLATE(_run_slices)(TEMPLATE(_PartitionSlice) slices[], void* (*body)(void*))
+{
+    pthread_t threads[LAZY_THREADS];
+    for (int t = 0; t < LAZY_THREADS; t++) assert(pthread_create(&threads[t], NULL, body, &slices[t]) == 0);
+    for (int t = 0; t < LAZY_THREADS; t++) pthread_join(threads[t], NULL);
+}
+
+/**
+ * @brief Same as _introselect, but ranges of LAZY_PARALLEL_MIN elements
+ * or more are partitioned by LAZY_THREADS threads, through a scratch
+ * buffer, until the range holding k is small enough to finish alone.
+ *
+ * @param[inout] items, the elements.
+ * @param[in] n, the number of elements.
+ * @param[in] k, the position to select, 0 <= k < n.
+ */
+void TEMPLATE(_parallel_select)(TEMPLATE_TYPE* items, long n, long k)
+{
+    long lo = 0, hi = n;
+    int depth = TEMPLATE(_depth_limit)(n);
+    TEMPLATE_TYPE* scratch = NULL;
+    TEMPLATE(_PartitionSlice) slices[LAZY_THREADS];
+
+    while (hi - lo >= LAZY_PARALLEL_MIN && depth-- > 0) {
+        if (scratch == NULL) assert((scratch = (TEMPLATE_TYPE *)malloc(n * sizeof(TEMPLATE_TYPE))) != NULL);
+        TEMPLATE_TYPE pivot = TEMPLATE(_median3)(items[lo], items[lo + (hi - lo) / 2], items[hi - 1]);
+        long step = (hi - lo) / LAZY_THREADS;
+        for (int t = 0; t < LAZY_THREADS; t++) {
+            slices[t].from = items;
+            slices[t].to = scratch;
+            slices[t].begin = lo + t * step;
+            slices[t].end = (t == LAZY_THREADS - 1) ? hi : lo + (t + 1) * step;
+            slices[t].pivot = pivot;
+        }
+        TEMPLATE(_run_slices)(slices, TEMPLATE(_count_slice));
+
+        // Each group is laid out slice after slice, groups one after the other.
+        long offset = lo;
+        for (int group = 0; group < 3; group++) {
+            for (int t = 0; t < LAZY_THREADS; t++) {
+                slices[t].offsets[group] = offset;
+                offset += slices[t].counts[group];
+            }
+        }
+        TEMPLATE(_run_slices)(slices, TEMPLATE(_scatter_slice));
+        memcpy(items + lo, scratch + lo, (hi - lo) * sizeof(TEMPLATE_TYPE));
+
+        long lt = slices[0].offsets[1], gt = slices[0].offsets[2];
+        if (k < lt) hi = lt;
+        else if (k >= gt) lo = gt;
+        else lo = hi = k;
+    }
+    free(scratch);
+    if (hi - lo > 1) TEMPLATE(_introselect)(items, lo, hi, k);
+}
+
+/**
+ * @brief Drops the deleted copies from the array, in one pass.
+ * Selection may then reorder it freely: every remaining copy
+ * precedes the position recorded by a later delete.
+ *
+ * @param[inout] lazy, the lazy median.
+ */
+void TEMPLATE(_flush)(TEMPLATE(LazyMedian)* lazy)
+{
+    if (hashmap_size(lazy->tombstones) == 0) return;
+    long kept = 0, deleted_before;
+    for (long i = 0; i < lazy->length; i++) {
+        TEMPLATE_TYPE item = lazy->items[i];
+        if (hashmap_get(lazy->tombstones, TEMPLATE(lazymedian_key)(item), &deleted_before) && i < deleted_before) continue;
+        lazy->items[kept++] = item;
+    }
+    lazy->length = kept;
+    hashmap_clear(lazy->tombstones);
+    assert(lazy->length == lazy->size);
+}
+
+/**
+ * @brief Marks every cached result stale, after a mutation.
+ *
+ * @param[inout] lazy, the lazy median.
+ */
+void TEMPLATE(_invalidate)(TEMPLATE(LazyMedian)* lazy)
+{
+    lazy->extremes_cached = false;
+    lazy->medians_cached = false;
+}
+
+/**
+ * @brief Computes and caches the minimum and maximum, one pass.
+ *
+ * @param[inout] lazy, the lazy median, not empty.
+ */
+void TEMPLATE(_cache_extremes)(TEMPLATE(LazyMedian)* lazy)
+{
+    TEMPLATE(_flush)(lazy);
+    TEMPLATE_TYPE min = lazy->items[0], max = lazy->items[0];
+    for (long i = 1; i < lazy->length; i++) {
+        if (lazy->items[i] < min) min = lazy->items[i];
+        if (lazy->items[i] > max) max = lazy->items[i];
+    }
+    lazy->min = min;
+    lazy->max = max;
+    lazy->extremes_cached = true;
+}
+
+/**
+ * @brief Selects and caches the median(s). Like the median heap,
+ * the lower middle element is the first median, the upper one the second.
+ *
+ * @param[inout] lazy, the lazy median, not empty.
+ */
+void TEMPLATE(_cache_medians)(TEMPLATE(LazyMedian)* lazy)
+{
+    TEMPLATE(_flush)(lazy);
+    long n = lazy->length, k = (n % 2 == 0) ? n / 2 - 1 : n / 2;
+    TEMPLATE(_parallel_select)(lazy->items, n, k);
+    lazy->medians[0] = lazy->items[k];
+    lazy->two = (n % 2 == 0);
+
+    // Everything past k is >= the lower middle, the upper middle is their minimum.
+    if (lazy->two) {
+        TEMPLATE_TYPE upper = lazy->items[k + 1];
+        for (long i = k + 2; i < n; i++) {
+            if (lazy->items[i] < upper) upper = lazy->items[i];
+        }
+        lazy->medians[1] = upper;
+    }
+    lazy->medians_cached = true;
+}
+
+TEMPLATE(LazyMedian)* TEMPLATE(lazymedian_create)(long capacity)
+{
+    assert(capacity > 0);
+    TEMPLATE(LazyMedian)* lazy = (TEMPLATE(LazyMedian) *)calloc(1, sizeof(TEMPLATE(LazyMedian)));
+    assert(lazy != NULL);
+
+    lazy->items = (TEMPLATE_TYPE *)malloc(capacity * sizeof(TEMPLATE_TYPE));
+    assert(lazy->items != NULL);
+    lazy->capacity = capacity;
+    lazy->live = hashmap_create(16);
+    lazy->tombstones = hashmap_create(16);
+    return lazy;
+}
+
+void TEMPLATE(lazymedian_insert)(TEMPLATE(LazyMedian)* lazy, TEMPLATE_TYPE n)
+{
+    assert(lazy != NULL);
+    if (lazy->length == lazy->capacity) {
+        lazy->capacity *= 2;
+        lazy->items = (TEMPLATE_TYPE *)realloc(lazy->items, lazy->capacity * sizeof(TEMPLATE_TYPE));
+        assert(lazy->items != NULL);
+    }
+    lazy->items[lazy->length++] = n;
+    lazy->size++;
+    hashmap_add(lazy->live, TEMPLATE(lazymedian_key)(n), 1);
+
+    // A larger maximum or smaller minimum keeps the cached extremes valid.
+    if (lazy->extremes_cached) {
+        if (n < lazy->min) lazy->min = n;
+        if (n > lazy->max) lazy->max = n;
+    }
+    lazy->medians_cached = false;
+}
+
+long TEMPLATE(lazymedian_delete_all)(TEMPLATE(LazyMedian)* lazy, TEMPLATE_TYPE n)
+{
+    assert(lazy != NULL);
+    long long key = TEMPLATE(lazymedian_key)(n);
+    long deleted = hashmap_remove(lazy->live, key);
+    if (deleted == 0) return 0;
+
+    hashmap_put(lazy->tombstones, key, lazy->length);
+    lazy->size -= deleted;
+    TEMPLATE(_invalidate)(lazy);
+    return deleted;
+}
+
+bool TEMPLATE(lazymedian_get_median2)(TEMPLATE(LazyMedian)* lazy, TEMPLATE_TYPE medians[])
+{
+    assert(lazy != NULL && lazy->size > 0);
+    if (!lazy->medians_cached) TEMPLATE(_cache_medians)(lazy);
+    medians[0] = lazy->medians[0];
+    medians[1] = lazy->two ? lazy->medians[1] : 0;
+    return lazy->two;
+}
+
+TEMPLATE_TYPE TEMPLATE(lazymedian_get_min)(TEMPLATE(LazyMedian)* lazy)
+{
+    assert(lazy != NULL && lazy->size > 0);
+    if (!lazy->extremes_cached) TEMPLATE(_cache_extremes)(lazy);
+    return lazy->min;
+}
+
+TEMPLATE_TYPE TEMPLATE(lazymedian_get_max)(TEMPLATE(LazyMedian)* lazy)
+{
+    assert(lazy != NULL && lazy->size > 0);
+    if (!lazy->extremes_cached) TEMPLATE(_cache_extremes)(lazy);
+    return lazy->max;
+}
+
+long TEMPLATE(lazymedian_count_range)(TEMPLATE(LazyMedian)* lazy, TEMPLATE_TYPE lo, TEMPLATE_TYPE hi, TEMPLATE_SUM_TYPE* sum)
+{
+    assert(lazy != NULL);
+    TEMPLATE(_flush)(lazy);
+    long count = 0;
+    TEMPLATE_SUM_TYPE total = 0;
+    for (long i = 0; i < lazy->length; i++) {
+        TEMPLATE_TYPE item = lazy->items[i];
+        if (item < lo || item > hi) continue;
+        count++;
+        total += item;
+    }
+    if (sum != NULL) *sum = total;
+    return count;
+}
+
+long TEMPLATE(lazymedian_size)(const TEMPLATE(LazyMedian)* lazy)
+{
+    assert(lazy != NULL);
+    return lazy->size;
+}
+
+size_t TEMPLATE(lazymedian_allocated_bytes)(const TEMPLATE(LazyMedian)* lazy)
+{
+    assert(lazy != NULL);
+    return sizeof(TEMPLATE(LazyMedian)) + lazy->capacity * sizeof(TEMPLATE_TYPE) +
+        hashmap_allocated_bytes(lazy->live) + hashmap_allocated_bytes(lazy->tombstones);
+}
+
+void TEMPLATE(lazymedian_destroy)(TEMPLATE(LazyMedian)* lazy)
+{
+    assert(lazy != NULL);
+    hashmap_destroy(lazy->live);
+    hashmap_destroy(lazy->tombstones);
+    free(lazy->items);
+    free(lazy);
+}
@@ -0,0 +1,124 @@
+/**
+ * Lazy Median Template Header - Append Buffer with Cached Selection
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ *
+ * Included by LazyMedian.h once per value type, see Template.h.
+ * No include guard on purpose.
+ */
+
+// Lazy Median Struct
+typedef struct {
+    TEMPLATE_TYPE* items;       // Appended numbers in no order, deleted ones until the next flush
+    long length;                // Numbers in items
+    long capacity;              // Space in items
+    long size;                  // Numbers not deleted
+    HashMap* live;              // Key -> occurrences not deleted
+    HashMap* tombstones;        // Key -> length of items at its last delete, until the next flush
+    bool extremes_cached;       // min and max are of the current numbers
+    bool medians_cached;        // medians and two are of the current numbers
+    TEMPLATE_TYPE min;          // Cached minimum
+    TEMPLATE_TYPE max;          // Cached maximum
+    TEMPLATE_TYPE medians[2];   // Cached median(s)
+    bool two;                   // Whether there are two medians
+} TEMPLATE(LazyMedian);
+
+/**
+ * @brief Returns the hash map key of the specified
+ * number: its bits, with -0.0 folded into 0.0 since
+ * they compare equal.
+ *
+ * @param[in] n, the number.
+ * @return long long, the key.
+ */
+long long TEMPLATE(lazymedian_key)(TEMPLATE_TYPE n);
+
+/**
+ * @brief Allocates and initializes a new, empty
+ * lazy median with the specified capacity.
+ *
+ * @param[in] capacity, the initializing capacity.
+ * @return TEMPLATE(LazyMedian)*, the lazy median.
+ */
+TEMPLATE(LazyMedian)* TEMPLATE(lazymedian_create)(long capacity);
+
+/**
+ * @brief Appends the specified number, O(1) amortized.
+ *
+ * @param[inout] lazy, the lazy median to insert into.
+ * @param[in] n, the number to insert.
+ */
+void TEMPLATE(lazymedian_insert)(TEMPLATE(LazyMedian)* lazy, TEMPLATE_TYPE n);
+
+/**
+ * @brief Deletes all instances of n, O(1). The copies
+ * are dropped from the array by the next read.
+ *
+ * @param[inout] lazy, the lazy median to delete from.
+ * @param[in] n, the number to delete.
+ * @return long, the number of instances deleted.
+ */
+long TEMPLATE(lazymedian_delete_all)(TEMPLATE(LazyMedian)* lazy, TEMPLATE_TYPE n);
+
+/**
+ * @brief Gets the median if odd size. Else, gets the *two*
+ * elements located at the middle of the sorted set.
+ *
+ * @param[inout] lazy, the lazy median, not empty (selected if not cached).
+ * @param[out] medians, stores the median(s).
+ * @return true if two medians, else false.
+ */
+bool TEMPLATE(lazymedian_get_median2)(TEMPLATE(LazyMedian)* lazy, TEMPLATE_TYPE medians[]);
+
+/**
+ * @brief Returns the minimum.
+ *
+ * @param[inout] lazy, the lazy median, not empty (scanned if not cached).
+ * @return TEMPLATE_TYPE, the minimum.
+ */
+TEMPLATE_TYPE TEMPLATE(lazymedian_get_min)(TEMPLATE(LazyMedian)* lazy);
+
+/**
+ * @brief Returns the maximum.
+ *
+ * @param[inout] lazy, the lazy median, not empty (scanned if not cached).
+ * @return TEMPLATE_TYPE, the maximum.
+ */
+TEMPLATE_TYPE TEMPLATE(lazymedian_get_max)(TEMPLATE(LazyMedian)* lazy);
+
+/**
+ * @brief Returns the number of elements k with lo <= k <= hi,
+ * and their sum. Scans every number, O(n).
+ *
+ * @param[inout] lazy, the lazy median (pending deletes are applied).
+ * @param[in] lo, the lower bound, inclusive.
+ * @param[in] hi, the upper bound, inclusive.
+ * @param[out] sum, stores the sum, which may not fit in TEMPLATE_TYPE (nullable).
+ * @return long, the count.
+ */
+long TEMPLATE(lazymedian_count_range)(TEMPLATE(LazyMedian)* lazy, TEMPLATE_TYPE lo, TEMPLATE_TYPE hi, TEMPLATE_SUM_TYPE* sum);
+
+/**
+ * @brief Returns the number of elements not deleted.
+ *
+ * @param[in] lazy, the lazy median.
+ * @return long, the size.
+ */
+long TEMPLATE(lazymedian_size)(const TEMPLATE(LazyMedian)* lazy);
+
+/**
+ * @brief Returns the number of bytes allocated
+ * by the specified lazy median.
+ *
+ * @param[in] lazy, the lazy median.
+ * @return size_t, the allocated bytes.
+ */
+size_t TEMPLATE(lazymedian_allocated_bytes)(const TEMPLATE(LazyMedian)* lazy);
+
+/**
+ * @brief Destroys and cleans up the
+ * specified lazy median.
+ *
+ * @param[in] lazy, the lazy median to destroy.
+ */
+void TEMPLATE(lazymedian_destroy)(TEMPLATE(LazyMedian)* lazy);
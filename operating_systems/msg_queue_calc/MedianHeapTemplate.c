@@ -0,0 +1,169 @@
+/**
+ * Median Heap Template
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ *
+ * Included by MedianHeap.c once per value type, see Template.h.
+ */
+
+/**
+ * @brief Recursively rebalances the median heap 
+ * to ensure that the maximum difference in size
+ * between the min and max heaps is 1.
+ * 
+ * Used after insertions and deletes.
+ * 
+ * @param[inout] heap, the heap to rebalance.
+ */
+void TEMPLATE(_rebalance)(TEMPLATE(MedianHeap)* heap)
+{
+    assert(heap != NULL);
+    // If the difference between the two heaps is greater than 1
+    if (abs(TEMPLATE(priorityqueue_size)(heap->maxHeap) - TEMPLATE(priorityqueue_size)(heap->minHeap)) > 1)
+    {
+        if (TEMPLATE(priorityqueue_size)(heap->maxHeap) > TEMPLATE(priorityqueue_size)(heap->minHeap))
+        {
+            // Max heap has the extra element(s), then pop the max from max and add to min
+            TEMPLATE(priorityqueue_insert)(heap->minHeap, TEMPLATE(priorityqueue_pop_root)(heap->maxHeap));
+        }
+        else
+        {
+            // Min heap has the extra element(s), then pop the min from min and add to max
+            TEMPLATE(priorityqueue_insert)(heap->maxHeap, TEMPLATE(priorityqueue_pop_root)(heap->minHeap));
+        }
+    }
+    // If the difference between the heap size is still greater than 1, rebalance again.
+    if (abs(TEMPLATE(priorityqueue_size)(heap->maxHeap) - TEMPLATE(priorityqueue_size)(heap->minHeap)) > 1) TEMPLATE(_rebalance)(heap);
+}
+
+TEMPLATE(MedianHeap)* TEMPLATE(medianheap_create)(int capacity)
+{
+    TEMPLATE(MedianHeap)* heap = (TEMPLATE(MedianHeap) *)malloc(sizeof(TEMPLATE(MedianHeap)));
+    assert(heap != NULL);
+
+    // Initialize the median heap
+    // Lazy heaps: a delete leaves tombstones instead of rebuilding both heaps.
+    heap->maxHeap = TEMPLATE(priorityqueue_create_lazy)(capacity, MAX);
+    heap->minHeap = TEMPLATE(priorityqueue_create_lazy)(capacity, MIN);
+    return heap;
+}
+
+void TEMPLATE(medianheap_insert)(TEMPLATE(MedianHeap)* heap, TEMPLATE_TYPE n)
+{
+    assert(heap != NULL);
+    if (TEMPLATE(medianheap_is_empty)(heap)) 
+    { 
+        // If the median heap is empty, anything is larger
+        // than the median -> goes to minheap
+        TEMPLATE(priorityqueue_insert)(heap->minHeap, n); 
+    }
+    else
+    {
+        // Otherwise, add numbers < the max heap root (the lower middle
+        // element) to the max heap and the rest to the min heap. Comparing
+        // against the root rather than the (double) median keeps int64 exact.
+        if (TEMPLATE(priorityqueue_size)(heap->maxHeap) > 0 && n < TEMPLATE(priorityqueue_peek)(heap->maxHeap))
+        {
+            TEMPLATE(priorityqueue_insert)(heap->maxHeap, n);
+        }
+        else
+        {
+            TEMPLATE(priorityqueue_insert)(heap->minHeap, n);
+        }
+    }
+
+    TEMPLATE(_rebalance)(heap);   // Rebalance the median heap if needed
+}
+
+void TEMPLATE(medianheap_print)(const TEMPLATE(MedianHeap)* heap)
+{
+    assert(heap != NULL);
+    printf("Less than median, max heap: \n");
+    TEMPLATE(priorityqueue_print)(heap->maxHeap);
+    printf("Greater than median: \n");
+    TEMPLATE(priorityqueue_print)(heap->minHeap);
+}
+
+void TEMPLATE(medianheap_delete_all)(TEMPLATE(MedianHeap)* heap, TEMPLATE_TYPE n)
+{
+    /** To delete all instances of n, delete all
+     * instances of n in the sub heaps. Note that n can be in both 
+     * (consider all elements are equal to n).
+     */
+    assert(heap != NULL);
+    TEMPLATE(priorityqueue_delete)(heap->maxHeap, n);
+    TEMPLATE(priorityqueue_delete)(heap->minHeap, n);
+    TEMPLATE(_rebalance)(heap);
+}
+
+double TEMPLATE(medianheap_get_median)(const TEMPLATE(MedianHeap)* heap)
+{
+    assert(heap != NULL);
+    // If both heaps are equal in size, the two middle elements
+    // are the roots of both heaps. Median is their average.
+    if (TEMPLATE(priorityqueue_size)(heap->maxHeap) == TEMPLATE(priorityqueue_size)(heap->minHeap)) 
+    {
+        return ((double)TEMPLATE(priorityqueue_peek)(heap->maxHeap) + (double)TEMPLATE(priorityqueue_peek)(heap->minHeap)) / 2;
+    }
+    // Otherwise, if the max heap is larger (ensured to be by 1), the median is its root.
+    else if (TEMPLATE(priorityqueue_size)(heap->maxHeap) > TEMPLATE(priorityqueue_size)(heap->minHeap))
+    {
+        return (double)TEMPLATE(priorityqueue_peek)(heap->maxHeap);
+    }
+    
+    // Otherwise, the min heaps is larger by 1, the median is its root.
+    return (double)TEMPLATE(priorityqueue_peek)(heap->minHeap);
+}
+
+bool TEMPLATE(medianheap_get_median2)(const TEMPLATE(MedianHeap)* heap, TEMPLATE_TYPE medians[])
+{
+    assert(heap != NULL);
+    // If both heaps are equal in size, the two middle elements
+    // are the roots of both heaps. Return both.
+    if (TEMPLATE(priorityqueue_size)(heap->maxHeap) == TEMPLATE(priorityqueue_size)(heap->minHeap)) 
+    {
+        medians[0] = TEMPLATE(priorityqueue_peek)(heap->maxHeap);
+        medians[1] = TEMPLATE(priorityqueue_peek)(heap->minHeap);
+
+        return true;
+    }
+    // Otherwise, if the max heap is larger (ensured to be by 1), the median is its root.
+    else if (TEMPLATE(priorityqueue_size)(heap->maxHeap) > TEMPLATE(priorityqueue_size)(heap->minHeap))
+    {
+        medians[0] = TEMPLATE(priorityqueue_peek)(heap->maxHeap);
+        
+    }
+    // Otherwise, the min heaps is larger by 1, the median is its root.
+    else {
+        medians[0] = TEMPLATE(priorityqueue_peek)(heap->minHeap);
+    }
+    return false;
+}
+
+TEMPLATE_TYPE TEMPLATE(medianheap_get_min)(const TEMPLATE(MedianHeap)* heap)
+{
+    assert(heap != NULL && !(TEMPLATE(medianheap_is_empty)(heap)));
+    // The minimum is in the max heap, unless its empty
+    if (TEMPLATE(priorityqueue_size)(heap->maxHeap) == 0) { return TEMPLATE(priorityqueue_peek)(heap->minHeap); }
+    return TEMPLATE(max_heap_get_min)(heap->maxHeap);
+}
+
+bool TEMPLATE(medianheap_is_empty)(const TEMPLATE(MedianHeap)* heap)
+{
+    assert(heap != NULL);
+    return (TEMPLATE(priorityqueue_size)(heap->minHeap) == 0) && (TEMPLATE(priorityqueue_size)(heap->maxHeap) == 0);
+}
+
+int TEMPLATE(medianheap_size)(const TEMPLATE(MedianHeap)* heap)
+{
+    assert(heap != NULL);
+    return TEMPLATE(priorityqueue_size)(heap->maxHeap) + TEMPLATE(priorityqueue_size)(heap->minHeap);
+}
+
+void TEMPLATE(medianheap_destroy)(TEMPLATE(MedianHeap)* heap) {
+    assert(heap != NULL);
+    //printf("Cleanup median heap.\n");
+    TEMPLATE(priorityqueue_destroy)(heap->maxHeap);
+    TEMPLATE(priorityqueue_destroy)(heap->minHeap);
+    free(heap);
+}
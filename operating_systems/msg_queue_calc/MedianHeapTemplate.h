@@ -0,0 +1,105 @@
+/**
+ * Median Heap Template Header
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ *
+ * Included by MedianHeap.h once per value type, see Template.h.
+ * No include guard on purpose.
+ */
+
+// Median Heap Struct
+typedef struct {
+    TEMPLATE(PriorityQueue)* maxHeap; // Max heap of all elems < median
+    TEMPLATE(PriorityQueue)* minHeap; // Min heap of all elems > median
+} TEMPLATE(MedianHeap);
+
+/**
+ * @brief Allocates, initializes and returns
+ * a new median heap with the specified capacity.
+ * 
+ * @param[in] capacity, the intiializing capacity for the median heap.
+ * @return TEMPLATE(MedianHeap)*, the new median heap.
+ */
+TEMPLATE(MedianHeap)* TEMPLATE(medianheap_create)(int capacity);
+
+/**
+ * @brief Inserts the specified number
+ * into the median heap.
+ * 
+ * @param[inout] heap, the heap to insert into.
+ * @param[in] n, the number to insert. 
+ */
+void TEMPLATE(medianheap_insert)(TEMPLATE(MedianHeap)* heap, TEMPLATE_TYPE n);
+
+/**
+ * @brief Prints the median heap (its
+ * two sub heaps).
+ * 
+ * @param[in] heap, the median heap to print. 
+ */
+void TEMPLATE(medianheap_print)(const TEMPLATE(MedianHeap)* heap);
+
+/**
+ * @brief Deletes all instances of n 
+ * from the median heap.
+ * 
+ * @param[inout] heap, the heap to delete from.
+ * @param[in] n, the number of delete.
+ */
+void TEMPLATE(medianheap_delete_all)(TEMPLATE(MedianHeap)* heap, TEMPLATE_TYPE n);
+
+/**
+ * @brief Returns the median of all
+ * the elements in the median heap.
+ * 
+ * @param[in] heap, the heap to get the median for.
+ * @return double, the median.
+ */
+double TEMPLATE(medianheap_get_median)(const TEMPLATE(MedianHeap)* heap);
+
+/**
+ * @brief Gets the median of the median heap
+ * if odd size. Else, gets the *two* elements
+ * located at the middle of the sorted set of elements.
+ * 
+ * @param[in] heap, the heap to get the median for.
+ * @param[out] medians, stores the median(s).
+ * @return flag as true if two medians, else false.
+ */
+bool TEMPLATE(medianheap_get_median2)(const TEMPLATE(MedianHeap)* heap, TEMPLATE_TYPE medians[]);
+
+/**
+ * @brief Returns the minimum value
+ * in the median heap.
+ * 
+ * @param[in] heap, the heap to return the minimum for.
+ * @return TEMPLATE_TYPE, the minimum.
+ */
+TEMPLATE_TYPE TEMPLATE(medianheap_get_min)(const TEMPLATE(MedianHeap)* heap);
+
+/**
+ * @brief Returns the number of elements
+ * in the median heap.
+ * 
+ * @param[in] heap, the heap to get the size of.
+ * @return int, the size.
+ */
+int TEMPLATE(medianheap_size)(const TEMPLATE(MedianHeap)* heap);
+
+/**
+ * @brief Returns whether the median heap
+ * is empty.
+ * 
+ * @param[in] heap, the heap to check if empty.
+ * @return true if empty, else false.
+ */
+bool TEMPLATE(medianheap_is_empty)(const TEMPLATE(MedianHeap)* heap);
+
+
+/**
+ * @brief Destroys and cleans up the specified
+ * median heap.
+ * 
+ * @param[in] heap, the median heap to destroy. 
+ */
+void TEMPLATE(medianheap_destroy)(TEMPLATE(MedianHeap)* heap);
@@ -7,14 +7,28 @@
 #include <assert.h>
 #include <stdbool.h>
 
+#include "Value.h"
+
 // Operand buffer indices for message components
 #define RESULT 0
 #define ARGUMENT 0
+#define ARGUMENT_HI 1
 #define MEDIAN1 0
 #define MEDIAN2 1
 #define FLAG_TWO_MEDIAN 2
 #define TWO_MEDIANS 1
 #define ONE_MEDIAN 0
+#define ESTIMATE_ERROR 1
+#define FLAG_EXACT 2
+#define TOPK_VALUE 0
+#define TOPK_COUNT 1
+#define TOPK_ERROR 2
+#define ENGINE_ARGUMENT 0
+#define ENGINE_LO 1
+#define ENGINE_HI 2
+
+// Dataset used by clients that don't select one
+#define DEFAULT_DATASET 0
 
 // Legal operations enum
 typedef enum {
@@ -24,29 +38,112 @@ typedef enum {
     SUM,
     MINIMUM,
     MEDIAN,
+    COUNT_RANGE,
+    SUM_RANGE,
+    RANK,
+    DISTINCT,
+    TOPK,
+    MAXIMUM,
+    COUNT,
+    VARIANCE,
+    STDDEV,
+    GEOMEAN,
+    CREATE,
     QUIT, 
+    BGSAVE,
+    BUSY,
+    UNCHANGED,
     ERROR
 } operation_type;
 
+// Dataset commands precede QUIT, these are the ones we keep stats for.
+// QUIT and BGSAVE are server commands, they carry no dataset.
+// BUSY and UNCHANGED only appear in replies: the request was shed
+// unprocessed, or a conditional read found the dataset unchanged.
+#define TOTAL_COMMANDS QUIT
+
+// Request priority classes, sent as my_msg_type. Workers receive
+// with type -PRIORITY_WRITE, so the lowest (most urgent) class
+// queued is always served first.
+typedef enum {
+    PRIORITY_URGENT = 1,    // Quit, BgSave
+    PRIORITY_READ,          // O(1) reads: aggregates, minimum, maximum, median
+    PRIORITY_QUERY,         // Range, rank, distinct and top-k queries
+    PRIORITY_WRITE          // Insert, Delete, Create
+} priority_class;
+
+/**
+ * @brief Returns the priority class requests
+ * for the specified operation are sent with.
+ * 
+ * @param[in] op, the operation.
+ * @return priority_class, the priority class.
+ */
+static inline priority_class operation_priority(operation_type op)
+{
+    switch (op)
+    {
+        case QUIT: case BGSAVE: return PRIORITY_URGENT;
+        case COUNT_RANGE: case SUM_RANGE: case RANK: case DISTINCT: case TOPK: return PRIORITY_QUERY;
+        case INSERT: case DELETE: case CREATE: return PRIORITY_WRITE;
+        default: return PRIORITY_READ;
+    }
+}
+
 /** Message format struct 
  * A message sent by the client will simply be modified
  * with the reply information and sent back rather than defining req and res types.
  */
 typedef struct {
-    long int my_msg_type;           // Message type
+    long int my_msg_type;           // Message type, replies are typed with reply_type
+    long int reply_type;            // Type the client receives its replies as (its pid)
+    unsigned int dataset;           // Id of the dataset to operate on
     operation_type operation;       // Operation Type
-    float operands[3];              // Operand Buffer (Stores arguements and commands, more below)
-                                    // Float since we can still store ints, but can store float for the average.
-    float elapsed;                   // Average elapsed time in micro seconds.
+    value_type type;                // Type of the numbers in operands (see below)
+    Value operands[3];              // Operand Buffer (Stores arguements and commands, more below)
+                                    // Native int64 or double, never rounded through a float.
+    float elapsed;                  // Average elapsed time in micro seconds.
+    int backlog;                    // Replies: requests queued at the server when it replied.
+    unsigned long long version;     // Requests: answer only if the dataset's version is newer (0 = always).
+                                    // Replies: the dataset's version (0 if it doesn't exist).
 } Message;
 
 /**
+ * Numbers (arguments, bounds, medians, minimum, sums and top-k values) are
+ * of the message's type. A request may send either type: int64 numbers are
+ * converted for a double dataset, doubles for an int64 dataset only if they
+ * hold an integer. A reply's type is always the dataset's.
+ * Counts, ranks, flags and the Create/TopK arguments are always int64 (.i),
+ * the average, variance, standard deviation, geometric mean and the
+ * distinct estimate and error always double (.f).
+ *
  * When sending, argument is in operands[0]
+ * Range bounds [lo, hi] are in operands[0] and operands[1]
  * 
  * When receiving, result is in operands[0]
  * Median 1 is in operands[0], 2 in [1]. If two medians, operands[2] is flagged with a 1.
+ * Distinct: estimate in operands[0], its standard error in [1], [2] flagged with a 1 if exact.
+ * Top-k: send the rank (1 = most frequent) as the argument, receive the value in
+ * operands[0], its count in [1] and the count's maximum overestimate in [2].
+ * Create: engine in operands[0] (0 = heap, 1 = dense, 2 = lazy), dense range [lo, hi] in [1] and [2],
+ * the dataset's value type in type (dense datasets are always int64).
+ * Sum fails if an int64 dataset's sum doesn't fit in an int64, the geometric
+ * mean if the dataset holds a negative number. Variance is the population variance.
  * Elapsed is -1 if error
  * 
+ * Every operation applies to the dataset with the message's dataset id. Datasets
+ * are created on their first insert, with the calculator's default engine and type, or
+ * explicitly by Create while still empty. Replies are sent with my_msg_type set
+ * to reply_type, so concurrent clients each receive only their own replies.
+ *
+ * Every applied Insert, Delete and Create moves its dataset to a new, higher
+ * version. A read sent with the version of a result the client already holds is
+ * answered UNCHANGED (no result) while the dataset still has that version.
+ *
+ * Requests are sent with my_msg_type set to their operation_priority. While the
+ * request queue is nearly full, queries and writes are answered BUSY without
+ * being processed. Every reply advertises the server's backlog, clients slow
+ * down while it is high (see message_queue_throttle).
  */
 
 #endif
@@ -4,8 +4,21 @@
  * @Date: November 23, 2021
  */
 
+#include <time.h>
+
 #include "MessageQueueWrapper.h"
 
+/**
+ * @brief Sleeps for the specified number of micro seconds.
+ * 
+ * @param[in] us, the micro seconds.
+ */
+void _sleep_us(long us)
+{
+    struct timespec delay = { us / 1000000, (us % 1000000) * 1000 };
+    nanosleep(&delay, NULL);
+}
+
 int message_queue_create(key_t key)
 {
     return msgget(key, IPC_CREAT | 0666);
@@ -13,7 +26,27 @@ int message_queue_create(key_t key)
 
 int message_queue_send(int qid, Message* msg)
 {
-    return msgsnd(qid, (void *)msg, MAX_TEXT, 0);
+    return (msgsnd(qid, (void *)msg, MAX_TEXT, 0) == -1) ? -1 : (int)MAX_TEXT;
+}
+
+int message_queue_try_send(int qid, Message* msg, long timeout_ms)
+{
+    // Retry with a doubling pause, 50us up to 5ms, until the deadline.
+    long waited_us = 0, pause_us = 50;
+    while (msgsnd(qid, (void *)msg, MAX_TEXT, IPC_NOWAIT) == -1) {
+        if ((errno != EAGAIN && errno != EINTR) || waited_us >= timeout_ms * 1000) return -1;
+        _sleep_us(pause_us);
+        waited_us += pause_us;
+        if (pause_us < 5000) pause_us *= 2;
+    }
+    return MAX_TEXT;
+}
+
+void message_queue_throttle(int backlog)
+{
+    if (backlog <= THROTTLE_BACKLOG) return;
+    long delay = (long)(backlog - THROTTLE_BACKLOG) * THROTTLE_US;
+    _sleep_us(delay < MAX_THROTTLE_US ? delay : MAX_THROTTLE_US);
 }
 
 int message_queue_receive(int qid, Message* msg, long type)
@@ -21,7 +54,17 @@ int message_queue_receive(int qid, Message* msg, long type)
     return msgrcv(qid, (void *)msg, MAX_TEXT, type, 0);
 }
 
+int message_queue_try_receive(int qid, Message* msg, long type)
+{
+    return msgrcv(qid, (void *)msg, MAX_TEXT, type, IPC_NOWAIT);
+}
+
 int message_queue_delete(int qid)
 {
     return msgctl(qid, IPC_RMID, 0);
 }
+
+int message_queue_stat(int qid, struct msqid_ds* stat)
+{
+    return msgctl(qid, IPC_STAT, stat);
+}
@@ -17,7 +17,12 @@
 #include "errno.h"
 
 #include "Message.h"
-#define MAX_TEXT 35
+#define MAX_TEXT (sizeof(Message) - sizeof(long int))   // Payload, everything past my_msg_type
+
+#define SEND_TIMEOUT_MS 100     // Clients give up on a full request queue after this long
+#define THROTTLE_BACKLOG 32     // Clients slow down once the server advertises this many queued requests
+#define THROTTLE_US 20          // Delay per queued request past THROTTLE_BACKLOG
+#define MAX_THROTTLE_US 10000   // Longest delay between two requests
 
 /**
  * @brief Creates (or gets if created) a message
@@ -44,10 +49,31 @@ int message_queue_delete(int qid);
  * 
  * @param[in] qid, the id of the queue to send the message in.
  * @param[in] msg, the message to send.
- * @return int, -1 on failure, else 0.
+ * @return int, -1 on failure, else the payload bytes sent.
  */
 int message_queue_send(int qid, Message *msg);
 
+/**
+ * @brief Sends the specified message, waiting at most
+ * timeout_ms for room if the queue is full instead of
+ * blocking indefinitely.
+ * 
+ * @param[in] qid, the id of the queue to send the message in.
+ * @param[in] msg, the message to send.
+ * @param[in] timeout_ms, the longest wait for room in milliseconds.
+ * @return int, -1 on failure (errno EAGAIN if the queue stayed full), else the payload bytes sent.
+ */
+int message_queue_try_send(int qid, Message *msg, long timeout_ms);
+
+/**
+ * @brief Client side backpressure, sleeps in proportion to the
+ * backlog the server advertised in its last reply once it
+ * exceeds THROTTLE_BACKLOG.
+ * 
+ * @param[in] backlog, the advertised backlog.
+ */
+void message_queue_throttle(int backlog);
+
 /**
  * @brief Blocking receive for a message 
  * of the specified type on the the 
@@ -57,8 +83,29 @@ int message_queue_send(int qid, Message *msg);
  * @param[in] qid, the id of the queue to receive on.
  * @param[in] msg, the location where the received message is stored.
  * @param[in] type, the type of message to wait for. 
- * @return int, -1 on failure, else 0. 
+ * @return int, -1 on failure, else the payload bytes received.
  */
 int message_queue_receive(int qid, Message *msg, long type);
 
+/**
+ * @brief Non-blocking receive, like message_queue_receive
+ * but fails at once if no message of the type is queued.
+ * 
+ * @param[in] qid, the id of the queue to receive on.
+ * @param[in] msg, the location where the received message is stored.
+ * @param[in] type, the type of message to receive.
+ * @return int, -1 on failure (errno ENOMSG if none is queued), else the payload bytes received.
+ */
+int message_queue_try_receive(int qid, Message *msg, long type);
+
+/**
+ * @brief Gets the status of the message queue
+ * specified by qid (depth, bytes, limits).
+ * 
+ * @param[in] qid, the id of the queue to stat.
+ * @param[out] stat, stores the queue status.
+ * @return int, -1 on failure, else 0.
+ */
+int message_queue_stat(int qid, struct msqid_ds *stat);
+
 #endif
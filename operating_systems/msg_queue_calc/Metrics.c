@@ -0,0 +1,264 @@
+/**
+ * Metrics : Calculator Instrumentation
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+
+#include "Metrics.h"
+#include "Chrono.h"
+#include "MessageQueueWrapper.h"
+
+// Label for each command, indexed by operation_type.
+static const char* command_labels[TOTAL_COMMANDS] = {
+    "insert", "delete", "average", "sum", "minimum", "median",
+    "count_range", "sum_range", "rank", "distinct", "topk", "maximum",
+    "count", "variance", "stddev", "geomean", "create"
+};
+
+// Dataset totals, summed over every dataset in the table.
+typedef struct {
+    long datasets[3];           // Datasets per engine_type
+    long size;                  // Numbers in all datasets
+    long heap_size[2];          // Max and min heap elements
+    long heap_capacity[2];      // Max and min heap slots
+    long heap_tombstones[2];    // Max and min heap deleted elements not yet discarded
+    size_t heap_index;          // Bytes in the heaps' live/tombstone counts
+    size_t frequencysketch;     // Bytes in frequency sketches
+    size_t rangeindex;          // Bytes in range indexes
+    size_t densecounter;        // Bytes in dense counters
+    size_t lazymedian;          // Bytes in lazy medians
+} DatasetTotals;
+
+/**
+ * @brief Returns the bytes allocated by a lazy
+ * heap's live and tombstone counts.
+ *
+ * @param[in] live, the live counts (nullable).
+ * @param[in] tombstones, the tombstone counts (nullable).
+ * @return size_t, the allocated bytes.
+ */
+size_t _heap_index_bytes(const HashMap* live, const HashMap* tombstones)
+{
+    return (live != NULL ? hashmap_allocated_bytes(live) : 0) +
+        (tombstones != NULL ? hashmap_allocated_bytes(tombstones) : 0);
+}
+
+/**
+ * @brief Adds one dataset to the totals,
+ * called with the dataset's lock held.
+ *
+ * @param[in] entry, the dataset.
+ * @param[inout] context, the DatasetTotals.
+ */
+void _add_dataset(DatasetEntry* entry, void* context)
+{
+    DatasetTotals* totals = (DatasetTotals *)context;
+    const Dataset* dataset = entry->dataset;
+
+    totals->datasets[dataset->engine]++;
+    totals->size += dataset_size(dataset);
+    totals->frequencysketch += frequencysketch_allocated_bytes(dataset->frequencies);
+    if (dataset->engine == ENGINE_HEAP && dataset->type == VALUE_INT64) {
+        totals->heap_size[0] += priorityqueue_size_i64(dataset->heap_i64->maxHeap);
+        totals->heap_size[1] += priorityqueue_size_i64(dataset->heap_i64->minHeap);
+        totals->heap_capacity[0] += priorityqueue_capacity_i64(dataset->heap_i64->maxHeap);
+        totals->heap_capacity[1] += priorityqueue_capacity_i64(dataset->heap_i64->minHeap);
+        totals->heap_tombstones[0] += priorityqueue_tombstones_i64(dataset->heap_i64->maxHeap);
+        totals->heap_tombstones[1] += priorityqueue_tombstones_i64(dataset->heap_i64->minHeap);
+        totals->heap_index += _heap_index_bytes(dataset->heap_i64->maxHeap->live, dataset->heap_i64->maxHeap->tombstones) +
+            _heap_index_bytes(dataset->heap_i64->minHeap->live, dataset->heap_i64->minHeap->tombstones);
+        totals->rangeindex += rangeindex_allocated_bytes_i64(dataset->ranges_i64);
+    } else if (dataset->engine == ENGINE_HEAP) {
+        totals->heap_size[0] += priorityqueue_size_f64(dataset->heap_f64->maxHeap);
+        totals->heap_size[1] += priorityqueue_size_f64(dataset->heap_f64->minHeap);
+        totals->heap_capacity[0] += priorityqueue_capacity_f64(dataset->heap_f64->maxHeap);
+        totals->heap_capacity[1] += priorityqueue_capacity_f64(dataset->heap_f64->minHeap);
+        totals->heap_tombstones[0] += priorityqueue_tombstones_f64(dataset->heap_f64->maxHeap);
+        totals->heap_tombstones[1] += priorityqueue_tombstones_f64(dataset->heap_f64->minHeap);
+        totals->heap_index += _heap_index_bytes(dataset->heap_f64->maxHeap->live, dataset->heap_f64->maxHeap->tombstones) +
+            _heap_index_bytes(dataset->heap_f64->minHeap->live, dataset->heap_f64->minHeap->tombstones);
+        totals->rangeindex += rangeindex_allocated_bytes_f64(dataset->ranges_f64);
+    } else if (dataset->engine == ENGINE_LAZY) {
+        totals->lazymedian += (dataset->type == VALUE_INT64) ? lazymedian_allocated_bytes_i64(dataset->lazy_i64) :
+            lazymedian_allocated_bytes_f64(dataset->lazy_f64);
+    } else {
+        totals->densecounter += densecounter_allocated_bytes(dataset->dense);
+    }
+}
+
+/**
+ * @brief Returns the time in seconds between
+ * two time values.
+ *
+ * @param[in] from, the start time.
+ * @param[in] to, the end time.
+ * @return double, the seconds elapsed.
+ */
+double _seconds_between(const struct timeval* from, const struct timeval* to)
+{
+    return (double)((to->tv_sec * MICRO_SEC_IN_SEC + to->tv_usec) -
+        (from->tv_sec * MICRO_SEC_IN_SEC + from->tv_usec)) / MICRO_SEC_IN_SEC;
+}
+
+/**
+ * @brief Writes the HELP and TYPE header
+ * for a metric family.
+ *
+ * @param[in] out, the stream to write to.
+ * @param[in] name, the metric name.
+ * @param[in] type, the metric type (counter, gauge).
+ * @param[in] help, the metric description.
+ */
+void _write_header(FILE* out, const char* name, const char* type, const char* help)
+{
+    fprintf(out, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+Metrics* metrics_create()
+{
+    Metrics* metrics = (Metrics *)calloc(1, sizeof(Metrics));
+    assert(metrics != NULL);
+
+    gettimeofday(&metrics->started, NULL);
+    metrics->snapshot = metrics->started;
+    return metrics;
+}
+
+double metrics_record(Metrics* metrics, operation_type op, long elapsed)
+{
+    assert(metrics != NULL);
+    if (op < 0 || op >= TOTAL_COMMANDS) return 0;   // Not a dataset command
+    long commands = __atomic_add_fetch(&metrics->total_commands[op], 1, __ATOMIC_RELAXED);
+    long total = __atomic_add_fetch(&metrics->total_elapsed[op], elapsed, __ATOMIC_RELAXED);
+    return (double)total / (double)commands;
+}
+
+void metrics_write_prometheus(Metrics* metrics, FILE* out, const int qids[],
+    const char* qnames[], int num_queues, DatasetTable* datasets)
+{
+    assert(metrics != NULL && out != NULL && datasets != NULL);
+    struct timeval now;
+    struct msqid_ds stat;
+    gettimeofday(&now, NULL);
+    double interval = _seconds_between(&metrics->snapshot, &now);
+
+    // Message queues
+    _write_header(out, "calculator_queue_messages", "gauge", "Messages currently on the queue.");
+    for (int i = 0; i < num_queues; i++) {
+        if (message_queue_stat(qids[i], &stat) == -1) continue;
+        fprintf(out, "calculator_queue_messages{queue=\"%s\"} %lu\n", qnames[i], (unsigned long)stat.msg_qnum);
+    }
+    _write_header(out, "calculator_queue_bytes", "gauge", "Bytes currently on the queue.");
+    for (int i = 0; i < num_queues; i++) {
+        if (message_queue_stat(qids[i], &stat) == -1) continue;
+        fprintf(out, "calculator_queue_bytes{queue=\"%s\"} %lu\n", qnames[i], (unsigned long)stat.msg_cbytes);
+    }
+    _write_header(out, "calculator_queue_max_bytes", "gauge", "Maximum bytes allowed on the queue.");
+    for (int i = 0; i < num_queues; i++) {
+        if (message_queue_stat(qids[i], &stat) == -1) continue;
+        fprintf(out, "calculator_queue_max_bytes{queue=\"%s\"} %lu\n", qnames[i], (unsigned long)stat.msg_qbytes);
+    }
+
+    // Commands, loaded once since workers keep counting
+    long commands_total[TOTAL_COMMANDS], elapsed_total[TOTAL_COMMANDS];
+    for (int i = 0; i < TOTAL_COMMANDS; i++) {
+        commands_total[i] = __atomic_load_n(&metrics->total_commands[i], __ATOMIC_RELAXED);
+        elapsed_total[i] = __atomic_load_n(&metrics->total_elapsed[i], __ATOMIC_RELAXED);
+    }
+    _write_header(out, "calculator_commands_total", "counter", "Commands processed.");
+    for (int i = 0; i < TOTAL_COMMANDS; i++) {
+        fprintf(out, "calculator_commands_total{op=\"%s\"} %ld\n", command_labels[i], commands_total[i]);
+    }
+    _write_header(out, "calculator_command_seconds_total", "counter", "Time spent processing commands.");
+    for (int i = 0; i < TOTAL_COMMANDS; i++) {
+        fprintf(out, "calculator_command_seconds_total{op=\"%s\"} %.6f\n", command_labels[i],
+            (double)elapsed_total[i] / MICRO_SEC_IN_SEC);
+    }
+    _write_header(out, "calculator_commands_per_second", "gauge", "Commands processed per second since the last snapshot.");
+    for (int i = 0; i < TOTAL_COMMANDS; i++) {
+        long commands = commands_total[i] - metrics->snapshot_commands[i];
+        fprintf(out, "calculator_commands_per_second{op=\"%s\"} %.3f\n", command_labels[i],
+            interval > 0 ? commands / interval : 0.0);
+        metrics->snapshot_commands[i] = commands_total[i];
+    }
+
+    // Datasets
+    DatasetTotals totals = { 0 };
+    datasettable_for_each(datasets, _add_dataset, &totals);
+    _write_header(out, "calculator_datasets", "gauge", "Datasets held by the calculator.");
+    fprintf(out, "calculator_datasets{engine=\"heap\"} %ld\n", totals.datasets[ENGINE_HEAP]);
+    fprintf(out, "calculator_datasets{engine=\"dense\"} %ld\n", totals.datasets[ENGINE_DENSE]);
+    fprintf(out, "calculator_datasets{engine=\"lazy\"} %ld\n", totals.datasets[ENGINE_LAZY]);
+    _write_header(out, "calculator_dataset_size", "gauge", "Numbers currently in all datasets.");
+    fprintf(out, "calculator_dataset_size %ld\n", totals.size);
+    _write_header(out, "calculator_heap_size", "gauge", "Elements in each heap of the median heaps.");
+    fprintf(out, "calculator_heap_size{heap=\"max\"} %ld\n", totals.heap_size[0]);
+    fprintf(out, "calculator_heap_size{heap=\"min\"} %ld\n", totals.heap_size[1]);
+    _write_header(out, "calculator_heap_capacity", "gauge", "Allocated slots in each heap of the median heaps.");
+    fprintf(out, "calculator_heap_capacity{heap=\"max\"} %ld\n", totals.heap_capacity[0]);
+    fprintf(out, "calculator_heap_capacity{heap=\"min\"} %ld\n", totals.heap_capacity[1]);
+    _write_header(out, "calculator_heap_tombstones", "gauge", "Deleted elements each heap has yet to discard.");
+    fprintf(out, "calculator_heap_tombstones{heap=\"max\"} %ld\n", totals.heap_tombstones[0]);
+    fprintf(out, "calculator_heap_tombstones{heap=\"min\"} %ld\n", totals.heap_tombstones[1]);
+
+    // Memory
+    _write_header(out, "calculator_allocated_bytes", "gauge", "Bytes allocated by the calculator data structures.");
+    fprintf(out, "calculator_allocated_bytes{structure=\"vector\"} %zu\n", vec_allocated_bytes());
+    fprintf(out, "calculator_allocated_bytes{structure=\"priorityqueue\"} %zu\n", priorityqueue_allocated_bytes());
+    fprintf(out, "calculator_allocated_bytes{structure=\"heapindex\"} %zu\n", totals.heap_index);
+    fprintf(out, "calculator_allocated_bytes{structure=\"frequencysketch\"} %zu\n", totals.frequencysketch);
+    fprintf(out, "calculator_allocated_bytes{structure=\"rangeindex\"} %zu\n", totals.rangeindex);
+    fprintf(out, "calculator_allocated_bytes{structure=\"densecounter\"} %zu\n", totals.densecounter);
+    fprintf(out, "calculator_allocated_bytes{structure=\"lazymedian\"} %zu\n", totals.lazymedian);
+
+    _write_header(out, "calculator_requests_shed_total", "counter", "Requests answered Busy while the request queue was nearly full.");
+    fprintf(out, "calculator_requests_shed_total %ld\n", __atomic_load_n(&metrics->shed, __ATOMIC_RELAXED));
+    _write_header(out, "calculator_reads_coalesced_total", "counter", "Reads answered with an identical pending read's result, computations saved.");
+    fprintf(out, "calculator_reads_coalesced_total %ld\n", __atomic_load_n(&metrics->coalesced, __ATOMIC_RELAXED));
+
+    // Background saves
+    _write_header(out, "calculator_bgsaves_total", "counter", "Background dataset snapshots, by outcome.");
+    fprintf(out, "calculator_bgsaves_total{result=\"failed\"} %ld\n", metrics->bgsaves[0]);
+    fprintf(out, "calculator_bgsaves_total{result=\"ok\"} %ld\n", metrics->bgsaves[1]);
+    _write_header(out, "calculator_bgsave_fork_seconds", "gauge", "Time the last background save paused requests to fork.");
+    fprintf(out, "calculator_bgsave_fork_seconds %.6f\n", metrics->last_bgsave.fork_us / 1e6);
+    _write_header(out, "calculator_bgsave_seconds", "gauge", "Time the last background save took to write the snapshot.");
+    fprintf(out, "calculator_bgsave_seconds %.6f\n", metrics->last_bgsave.save_us / 1e6);
+    _write_header(out, "calculator_bgsave_cow_bytes", "gauge", "Memory copied on write during the last background save.");
+    fprintf(out, "calculator_bgsave_cow_bytes %ld\n", metrics->last_bgsave.cow_bytes);
+    _write_header(out, "calculator_bgsave_bytes", "gauge", "Size of the last background save.");
+    fprintf(out, "calculator_bgsave_bytes %lld\n", metrics->last_bgsave.bytes);
+
+    _write_header(out, "calculator_uptime_seconds", "gauge", "Seconds since the calculator started.");
+    fprintf(out, "calculator_uptime_seconds %.3f\n", _seconds_between(&metrics->started, &now));
+
+    metrics->snapshot = now;
+}
+
+void metrics_record_shed(Metrics* metrics)
+{
+    assert(metrics != NULL);
+    __atomic_add_fetch(&metrics->shed, 1, __ATOMIC_RELAXED);
+}
+
+void metrics_record_coalesced(Metrics* metrics, long reads)
+{
+    assert(metrics != NULL);
+    __atomic_add_fetch(&metrics->coalesced, reads, __ATOMIC_RELAXED);
+}
+
+void metrics_record_bgsave(Metrics* metrics, const SnapshotReport* report)
+{
+    assert(metrics != NULL && report != NULL);
+    metrics->bgsaves[report->ok]++;
+    metrics->last_bgsave = *report;
+}
+
+void metrics_destroy(Metrics* metrics)
+{
+    assert(metrics != NULL);
+    free(metrics);
+}
@@ -0,0 +1,102 @@
+/**
+ * Metrics Header : Calculator Instrumentation
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#pragma once
+#ifndef _METRICS_H_
+#define _METRICS_H_
+
+#include <stdio.h>
+#include <sys/time.h>
+
+#include "Message.h"
+#include "DatasetTable.h"
+#include "Snapshot.h"
+
+// Metrics Struct
+typedef struct {
+    long total_commands[TOTAL_COMMANDS];    // Tracks total commands received for each command.
+    long total_elapsed[TOTAL_COMMANDS];     // Tracks total proc. time (us) for each command.
+    long snapshot_commands[TOTAL_COMMANDS]; // Command totals at the last snapshot, for rates.
+    struct timeval started;                 // Time the metrics were created
+    struct timeval snapshot;                // Time of the last snapshot
+    long shed;                              // Requests answered Busy, unprocessed
+    long coalesced;                         // Reads answered with another identical read's result
+    long bgsaves[2];                        // Background saves (dataset snapshots) failed, succeeded
+    SnapshotReport last_bgsave;             // Outcome of the last background save
+} Metrics;
+
+/**
+ * @brief Allocates and initializes the metrics
+ * with all counters set to 0.
+ *
+ * @return Metrics*, the initialized metrics.
+ */
+Metrics* metrics_create();
+
+/**
+ * @brief Records a processed command and its
+ * processing time. This is the only bookkeeping done
+ * on the request path: two atomic increments, so any
+ * worker may record without a lock.
+ *
+ * @param[inout] metrics, the metrics to update.
+ * @param[in] op, the processed operation.
+ * @param[in] elapsed, the processing time in micro seconds.
+ * @return double, the average processing time for op in micro seconds.
+ */
+double metrics_record(Metrics* metrics, operation_type op, long elapsed);
+
+/**
+ * @brief Records a request shed (answered Busy) under
+ * backpressure. Lock-free, like metrics_record.
+ *
+ * @param[inout] metrics, the metrics to update.
+ */
+void metrics_record_shed(Metrics* metrics);
+
+/**
+ * @brief Records reads answered with the result of an identical
+ * pending read, computations saved. Lock-free, like metrics_record.
+ *
+ * @param[inout] metrics, the metrics to update.
+ * @param[in] reads, the number of reads coalesced.
+ */
+void metrics_record_coalesced(Metrics* metrics, long reads);
+
+/**
+ * @brief Records the outcome of a background save.
+ * Called by the main thread only.
+ *
+ * @param[inout] metrics, the metrics to update.
+ * @param[in] report, the save's outcome.
+ */
+void metrics_record_bgsave(Metrics* metrics, const SnapshotReport* report);
+
+/**
+ * @brief Writes a snapshot of the metrics, the message
+ * queues and the datasets in the Prometheus text
+ * exposition format. Per-operation rates are computed over the
+ * interval since the previous snapshot. Datasets are reported
+ * as totals, a series per dataset wouldn't scale to thousands.
+ *
+ * @param[inout] metrics, the metrics to snapshot.
+ * @param[in] out, the stream to write to.
+ * @param[in] qids, the ids of the message queues to report.
+ * @param[in] qnames, the label for each queue.
+ * @param[in] num_queues, the number of queues.
+ * @param[in] datasets, the datasets to report.
+ */
+void metrics_write_prometheus(Metrics* metrics, FILE* out, const int qids[],
+    const char* qnames[], int num_queues, DatasetTable* datasets);
+
+/**
+ * @brief Destroys and cleans up the specified metrics.
+ *
+ * @param[in] metrics, the metrics to destroy.
+ */
+void metrics_destroy(Metrics* metrics);
+
+#endif
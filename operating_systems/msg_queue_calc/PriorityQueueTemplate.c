@@ -0,0 +1,359 @@
+/**
+ * Priority Queue Template - Min/Max Heap
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ *
+ * Included by PriorityQueue.c once per value type, see Template.h.
+ * Counts its allocations in PriorityQueue.c's allocated_bytes.
+ */
+
+/**
+ * @brief Recursively heapifies (percolates) the specified 
+ * node down the specified queue's binary heap.
+ * 
+ * Used for popping roots, swap root with last leaf
+ * 
+ * @param[inout] queue, the queue to heapify.
+ * @param[in] parent_node, the node to heapify down.
+ */
+void TEMPLATE(_heapify_top_bottom)(TEMPLATE(PriorityQueue)* queue, int parent_node) {
+    assert(queue != NULL);
+    int left = parent_node * 2 + 1;     // Property: left @ 2p + 1
+    int right = parent_node * 2 + 2;    // Property: right @ 2p + 2
+    int minmax;                         // Current min/max (min for MIN heap, max for MAX heap)
+
+    // Reference
+    TEMPLATE(Vector)* vec = queue->items;
+    int size = TEMPLATE(vec_size)(vec);
+
+    // If there's a left child, check if it does not satisfy the heap property.
+    bool predicate = (queue->heap_type == MIN) ?
+        !(left >= size || left < 0) && TEMPLATE(vec_get)(vec, left) < TEMPLATE(vec_get)(vec, parent_node)  // Min: ! child > parent
+        :
+        !(left >= size || left < 0) && TEMPLATE(vec_get)(vec, left) > TEMPLATE(vec_get)(vec, parent_node); // Max: ! child < parent
+
+    // If the heap property is not satisfied, assign
+    // the child to minmax.
+    if (predicate) {
+        minmax = left;
+    } else {
+        minmax = parent_node;
+    }
+
+    // Repeat for right child...
+    // If there's a right child, check if it does not satisfy the heap property.
+    predicate = (queue->heap_type == MIN) ? 
+        !(right >= size || right < 0) && TEMPLATE(vec_get)(vec, right) < TEMPLATE(vec_get)(vec, minmax)    // Min: ! child > parent
+        :
+        !(right >= size || right < 0) && TEMPLATE(vec_get)(vec, right) > TEMPLATE(vec_get)(vec, minmax);   // Max: ! child < parent
+
+    // If the heap property is not satisfied, assign
+    // the child to minmax.
+    if (predicate){
+        minmax = right;
+    }
+
+    /** If the minmax was not the parent, the heap property
+     * was not satisfied and we have the smallest/largest of the children
+     * in minmax. Swap it with the parent and then continue
+     * percolating down from that index.
+     */ 
+    if (minmax != parent_node) {
+        TEMPLATE(vec_swap)(vec, parent_node, minmax);
+        TEMPLATE(_heapify_top_bottom)(queue, minmax);
+    }
+    // Otherwise we're done.
+}
+
+/**
+ * @brief Recursively heapifies (percolates) the specified 
+ * node up the specified queue's binary heap.
+ * 
+ * Used for inserts, add to end then bubble up
+ * 
+ * @param[inout] queue, the queue to heapify.
+ * @param[in] parent_node, the node to heapify up.
+ */
+void TEMPLATE(_heapify_bottom_top)(TEMPLATE(PriorityQueue)* queue, int index) {
+    assert(queue != NULL);
+    // Property: parent @ (i - 1) / 2
+    int parent_node = (index - 1) / 2;  
+
+    // Reference
+    TEMPLATE(Vector)* vec = queue->items;
+
+    // Check if heap structure is *not* satisfied
+    // MIN HEAP: parent is smaller or equal than child
+    // MAX HEAP: parent is larger or equal than child
+    bool predicate = (queue->heap_type == MIN) ?
+        TEMPLATE(vec_get)(vec, parent_node) > TEMPLATE(vec_get)(vec, index) 
+        :
+        TEMPLATE(vec_get)(vec, parent_node) < TEMPLATE(vec_get)(vec, index);
+
+    if (predicate) {
+        // Heap structure not satisfied, swap 
+        // the parent and child to restore.
+        TEMPLATE(vec_swap)(vec, parent_node, index);
+        // Continue bubbling up from the parent index
+        // until no swaps
+        TEMPLATE(_heapify_bottom_top)(queue, parent_node);
+    }
+}
+
+/**
+ * @brief Rebuild the specified queue's 
+ * items queue to satisfy the associated heap property.
+ * 
+ * Used to reestablish the heap property after 
+ * a delete (not a pop).
+ * 
+ * @param[inout] queue, the queue to rebuild.
+ */
+void TEMPLATE(_rebuild_heap)(TEMPLATE(PriorityQueue)* queue) {
+    assert(queue != NULL);
+    // Percolate up from every leaf from the
+    // bottom row and every node will fall into its place.
+    int start = TEMPLATE(vec_size)(queue->items) / 2 - 1;
+
+    for (int i = start; i >= 0; i--)
+    {
+        TEMPLATE(_heapify_top_bottom)(queue, i);
+    }
+}
+
+/**
+ * @brief Returns the hash map key of the specified
+ * number: its bits, with -0.0 folded into 0.0 since
+ * they compare equal.
+ * 
+ * @param[in] n, the number.
+ * @return long long, the key.
+ */
+long long TEMPLATE(_tombstone_key)(TEMPLATE_TYPE n) {
+    long long key = 0;
+    if (n == 0) n = 0;
+    memcpy(&key, &n, sizeof(n));
+    return key;
+}
+
+/**
+ * @brief Removes the root of the specified queue's
+ * binary heap, dead or alive, and returns it.
+ * 
+ * @param[inout] queue, the queue to pop.
+ * @return TEMPLATE_TYPE, the value of the root.
+ */
+TEMPLATE_TYPE TEMPLATE(_pop)(TEMPLATE(PriorityQueue)* queue) {
+    TEMPLATE(Vector)* vec = queue->items;
+    TEMPLATE_TYPE pop = TEMPLATE(vec_get)(vec, 0);  // Get value of root
+    TEMPLATE(vec_swap)(vec, 0, vec->size - 1);    // Swap root with last leaf
+    TEMPLATE(vec_pop)(vec);                       // Remove last elem (the root)
+    TEMPLATE(_heapify_top_bottom)(queue, 0);      // Percolate the last leaf down
+    return pop;
+}
+
+/**
+ * @brief Discards deleted keys from the root of the specified
+ * lazy queue until a live one surfaces, so peek never sees one.
+ * Copies of a key are interchangeable, whichever copy surfaces
+ * first is dropped while the key has tombstones.
+ * 
+ * @param[inout] queue, the lazy queue.
+ */
+void TEMPLATE(_discard_dead_roots)(TEMPLATE(PriorityQueue)* queue) {
+    while (queue->dead > 0 && TEMPLATE(vec_size)(queue->items) > 0) {
+        long long key = TEMPLATE(_tombstone_key)(TEMPLATE(vec_get)(queue->items, 0));
+        if (!hashmap_get(queue->tombstones, key, NULL)) break;
+
+        TEMPLATE(_pop)(queue);
+        hashmap_add(queue->tombstones, key, -1);
+        queue->dead--;
+    }
+}
+
+TEMPLATE(PriorityQueue)* TEMPLATE(priorityqueue_create)(int capacity, const enum HEAP_TYPE heap_type) 
+{
+    TEMPLATE(PriorityQueue)* queue = (TEMPLATE(PriorityQueue) *)malloc(sizeof(TEMPLATE(PriorityQueue)));
+    assert(queue != NULL);
+
+    // Initialize the priority queue
+    queue->heap_type = heap_type;
+    queue->items = TEMPLATE(vec_allocate)(capacity);
+    queue->live = NULL;
+    queue->tombstones = NULL;
+    queue->dead = 0;
+    __atomic_add_fetch(&allocated_bytes, sizeof(TEMPLATE(PriorityQueue)), __ATOMIC_RELAXED);
+    return queue;
+}
+
+TEMPLATE(PriorityQueue)* TEMPLATE(priorityqueue_create_lazy)(int capacity, const enum HEAP_TYPE heap_type) 
+{
+    TEMPLATE(PriorityQueue)* queue = TEMPLATE(priorityqueue_create)(capacity, heap_type);
+    queue->live = hashmap_create(capacity);
+    queue->tombstones = hashmap_create(0);
+    return queue;
+}
+
+void TEMPLATE(priorityqueue_insert)(TEMPLATE(PriorityQueue)* queue, TEMPLATE_TYPE key) {
+    assert(queue != NULL);
+    // Append the element to the last leaf (bottom right) of the heap, 
+    // then percolate it up until it reaches the correct location
+    TEMPLATE(vec_pushback)(queue->items, key);
+    TEMPLATE(_heapify_bottom_top)(queue, queue->items->size - 1);
+    if (queue->live != NULL) hashmap_add(queue->live, TEMPLATE(_tombstone_key)(key), 1);
+}
+
+int TEMPLATE(priorityqueue_delete)(TEMPLATE(PriorityQueue)* queue, TEMPLATE_TYPE key) {
+    assert(queue != NULL);
+    if (queue->live != NULL) {
+        // Lazy: the live copies become tombstones, left in place
+        // until they surface or there are too many of them.
+        long long hashed = TEMPLATE(_tombstone_key)(key);
+        int num_removed = (int)hashmap_remove(queue->live, hashed);
+        if (num_removed == 0) return 0;
+
+        hashmap_add(queue->tombstones, hashed, num_removed);
+        queue->dead += num_removed;
+        if ((long)queue->dead * 100 > (long)TEMPLATE(vec_size)(queue->items) * TOMBSTONE_COMPACT_PERCENT) {
+            TEMPLATE(priorityqueue_compact)(queue);
+        } else {
+            TEMPLATE(_discard_dead_roots)(queue);
+        }
+        return num_removed;
+    }
+
+    // Create a new vector to store the filtered 
+    // elements (will filter out key).
+    TEMPLATE(Vector)* filtered = TEMPLATE(vec_allocate)(queue->items->capacity);
+
+    int num_removed = 0;
+    TEMPLATE_TYPE curr_elem;
+
+    // Go through the current heap and leave out 
+    // all instances of key in the new array
+    for (int i = 0; i < queue->items->size; i++) {
+        curr_elem = TEMPLATE(vec_get)(queue->items, i);
+        if (curr_elem != key) {
+            TEMPLATE(vec_pushback)(filtered, curr_elem);
+        } else {
+            num_removed++;
+        }
+    }
+
+    if (num_removed > 0)
+    {
+        // Something was removed, free the 
+        // old heap and assign the new filtered one
+        TEMPLATE(vec_destroy)(queue->items);
+        queue->items = filtered;
+        // Then rebuild to restore heap structure
+        TEMPLATE(_rebuild_heap)(queue);
+    } else {
+        // Otherwise, keep the current heap and free 
+        // filtered.
+        TEMPLATE(vec_destroy)(filtered);
+    }
+
+    return num_removed;
+}
+
+TEMPLATE_TYPE TEMPLATE(priorityqueue_pop_root)(TEMPLATE(PriorityQueue)* queue) {
+    assert(queue != NULL);
+    assert(TEMPLATE(priorityqueue_size)(queue) > 0);
+
+    // The root is always live, see _discard_dead_roots
+    TEMPLATE_TYPE pop = TEMPLATE(_pop)(queue);
+    if (queue->live != NULL) {
+        hashmap_add(queue->live, TEMPLATE(_tombstone_key)(pop), -1);
+        TEMPLATE(_discard_dead_roots)(queue);
+    }
+    return pop;
+}
+
+void TEMPLATE(priorityqueue_compact)(TEMPLATE(PriorityQueue)* queue) {
+    assert(queue != NULL);
+    if (queue->dead == 0) return;
+
+    // Same as an eager delete, but of every tombstoned copy at once.
+    TEMPLATE(Vector)* filtered = TEMPLATE(vec_allocate)(queue->items->capacity);
+    for (int i = 0; i < TEMPLATE(vec_size)(queue->items); i++) {
+        TEMPLATE_TYPE curr_elem = TEMPLATE(vec_get)(queue->items, i);
+        long long key = TEMPLATE(_tombstone_key)(curr_elem);
+        if (hashmap_get(queue->tombstones, key, NULL)) {
+            hashmap_add(queue->tombstones, key, -1);
+        } else {
+            TEMPLATE(vec_pushback)(filtered, curr_elem);
+        }
+    }
+    TEMPLATE(vec_destroy)(queue->items);
+    queue->items = filtered;
+    queue->dead = 0;
+    TEMPLATE(_rebuild_heap)(queue);
+}
+
+TEMPLATE_TYPE TEMPLATE(max_heap_get_min)(const TEMPLATE(PriorityQueue)* queue) {
+    assert(queue != NULL && TEMPLATE(vec_size)(queue->items) > 0);
+    assert(queue->heap_type == MAX);    // Ensure this is a max heap
+
+    int n = TEMPLATE(vec_size)(queue->items);
+
+    // With tombstones, a live parent may only have deleted children,
+    // so search every live element instead (the root is always live).
+    if (queue->dead > 0) {
+        TEMPLATE_TYPE minimum_elem = TEMPLATE(vec_get)(queue->items, 0);
+        for (int i = 1; i < n; i++)
+        {
+            TEMPLATE_TYPE elem = TEMPLATE(vec_get)(queue->items, i);
+            if (elem < minimum_elem && hashmap_get(queue->live, TEMPLATE(_tombstone_key)(elem), NULL)) minimum_elem = elem;
+        }
+        return minimum_elem;
+    }
+
+    // For a max heap, the minimum will be in the last row (second half of the array)
+    TEMPLATE_TYPE minimum_elem = TEMPLATE(vec_get)(queue->items,  n / 2);
+    // Go through the last row and keep updating the minimum
+    for (int i = 1 + n / 2; i < n; i++)
+    {
+        TEMPLATE_TYPE elem = TEMPLATE(vec_get)(queue->items, i);
+        if (elem < minimum_elem) minimum_elem = elem;
+    }
+
+    return minimum_elem;
+}
+
+TEMPLATE_TYPE TEMPLATE(priorityqueue_peek)(const TEMPLATE(PriorityQueue)* queue) {
+    assert(queue != NULL);
+    assert(TEMPLATE(vec_capacity)(queue->items) > 0);
+
+    return TEMPLATE(vec_get)(queue->items, 0);
+}
+
+void TEMPLATE(priorityqueue_print)(const TEMPLATE(PriorityQueue)* queue) {
+    assert(queue != NULL);
+    TEMPLATE(vec_print)(queue->items);
+}
+
+int TEMPLATE(priorityqueue_capacity)(const TEMPLATE(PriorityQueue)* queue) {
+    assert(queue != NULL);
+    return TEMPLATE(vec_capacity)(queue->items);
+}
+
+int TEMPLATE(priorityqueue_size)(const TEMPLATE(PriorityQueue)* queue) {
+    assert(queue != NULL);
+    return TEMPLATE(vec_size)(queue->items) - queue->dead;
+}
+
+int TEMPLATE(priorityqueue_tombstones)(const TEMPLATE(PriorityQueue)* queue) {
+    assert(queue != NULL);
+    return queue->dead;
+}
+
+void TEMPLATE(priorityqueue_destroy)(TEMPLATE(PriorityQueue)* queue) {
+    assert(queue != NULL);
+    //printf("Cleanup pqueue.\n");
+    TEMPLATE(vec_destroy)(queue->items);
+    if (queue->live != NULL) hashmap_destroy(queue->live);
+    if (queue->tombstones != NULL) hashmap_destroy(queue->tombstones);
+    __atomic_sub_fetch(&allocated_bytes, sizeof(TEMPLATE(PriorityQueue)), __ATOMIC_RELAXED);
+    free(queue);
+}
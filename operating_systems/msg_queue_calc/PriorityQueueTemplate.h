@@ -0,0 +1,139 @@
+/**
+ * Priority Queue Template Header - Min/Max Heap
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ *
+ * Included by PriorityQueue.h once per value type, see Template.h.
+ * No include guard on purpose.
+ */
+
+// Priority Queue Struct
+typedef struct {
+    TEMPLATE(Vector)* items;    // Vector-based Binary Heap
+    enum HEAP_TYPE heap_type;   // Priority Queue type (max/min)
+    HashMap* live;              // Lazy: key -> live occurrences in items, NULL if eager
+    HashMap* tombstones;        // Lazy: key -> deleted occurrences still in items
+    int dead;                   // Lazy: deleted occurrences still in items
+} TEMPLATE(PriorityQueue);
+
+/**
+ * @brief Allocates and intializes a new priority queue.
+ * 
+ * @param[in] capacity The initializing capacity of the queue.
+ * @param[in] heap_type The type of pqueue, MAX or MIN.
+ * @return PriorityQueue*, the priority queue.
+ */
+TEMPLATE(PriorityQueue)* TEMPLATE(priorityqueue_create)(int capacity, const enum HEAP_TYPE heap_type);
+
+/**
+ * @brief Allocates and intializes a new priority queue
+ * that deletes lazily: deleted keys are only counted as tombstones
+ * and discarded once they surface at the root, or all at once when
+ * more than TOMBSTONE_COMPACT_PERCENT of the items are deleted.
+ * Deletes become amortized O(log n) instead of O(n), every
+ * other operation behaves as in an eager queue.
+ * 
+ * @param[in] capacity The initializing capacity of the queue.
+ * @param[in] heap_type The type of pqueue, MAX or MIN.
+ * @return PriorityQueue*, the priority queue.
+ */
+TEMPLATE(PriorityQueue)* TEMPLATE(priorityqueue_create_lazy)(int capacity, const enum HEAP_TYPE heap_type);
+
+/**
+ * @brief Inserts a key into the specified priority queue,
+ *  satisfying the queue type.
+ * 
+ * @param[inout] queue, the queue to insert to.
+ * @param[in] key, the key to insert.
+ */
+void TEMPLATE(priorityqueue_insert)(TEMPLATE(PriorityQueue)* queue, TEMPLATE_TYPE key);
+
+/**
+ * @brief Prints the specified priority queue
+ * (including tombstoned keys, for lazy queues).
+ * 
+ * @param[in] queue, the queue to print.
+ */
+void TEMPLATE(priorityqueue_print)(const TEMPLATE(PriorityQueue)* queue);
+
+/**
+ * @brief Pops the root element of the specified queue
+ * and returns the value.
+ * 
+ * @param[inout] queue, the queue to pop.
+ * @return TEMPLATE_TYPE, the value of the root.
+ */
+TEMPLATE_TYPE TEMPLATE(priorityqueue_pop_root)(TEMPLATE(PriorityQueue)* queue);
+
+/**
+ * @brief Returns the root element of the 
+ * specified queue.
+ * 
+ * @param[in] queue, the queue to peek.
+ * @return TEMPLATE_TYPE, the element at the root of the queue.
+ */
+TEMPLATE_TYPE TEMPLATE(priorityqueue_peek)(const TEMPLATE(PriorityQueue)* queue);
+
+/**
+ * @brief Returns the total space in the 
+ * specified queue.
+ * 
+ * @param[in] queue, the queue to get the capacity of.
+ * @return int, the capacity.
+ */
+int TEMPLATE(priorityqueue_capacity)(const TEMPLATE(PriorityQueue)* queue);
+
+/**
+ * @brief Returns the total number of
+ * elements in the specified queue.
+ * 
+ * @param[in] queue, the queue to get the size of.
+ * @return int, the size.
+ */
+int TEMPLATE(priorityqueue_size)(const TEMPLATE(PriorityQueue)* queue);
+
+/**
+ * @brief Returns the number of deleted elements
+ * still held by the specified (lazy) queue.
+ * 
+ * @param[in] queue, the queue.
+ * @return int, the tombstones, 0 for an eager queue.
+ */
+int TEMPLATE(priorityqueue_tombstones)(const TEMPLATE(PriorityQueue)* queue);
+
+/**
+ * @brief Drops every deleted element from the
+ * specified (lazy) queue and rebuilds the heap, O(n).
+ * Afterwards items holds exactly the queue's elements.
+ * 
+ * @param[inout] queue, the queue to compact.
+ */
+void TEMPLATE(priorityqueue_compact)(TEMPLATE(PriorityQueue)* queue);
+
+/**
+ * @brief Returns the minimum number in a
+ * max heap.
+ * Precondition: The specified queue is of type MAX.
+ * 
+ * @param[in] queue, the maxheap queue to get the minimum from.
+ * @return TEMPLATE_TYPE, the minimum.
+ */
+TEMPLATE_TYPE TEMPLATE(max_heap_get_min)(const TEMPLATE(PriorityQueue)* queue);
+
+/**
+ * @brief Deletes all instances of n in 
+ * the specified priority queue.
+ * 
+ * @param[inout] queue, the priority queue to delete from.
+ * @param[in] n, the number to delete.
+ * @return int, the number of elements removed.
+ */
+int TEMPLATE(priorityqueue_delete)(TEMPLATE(PriorityQueue)* queue, TEMPLATE_TYPE n);
+
+/**
+ * @brief Destroys and cleans up the
+ * specified priority queue.
+ * 
+ * @param[in] queue, the queue to delete.
+ */
+void TEMPLATE(priorityqueue_destroy)(TEMPLATE(PriorityQueue)* queue);
@@ -0,0 +1,25 @@
+/**
+ * Range Index - Order Statistic Treap
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#include "RangeIndex.h"
+
+// RangeIndex_i64
+#define TEMPLATE_TYPE TEMPLATE_I64_TYPE
+#define TEMPLATE_SUM_TYPE TEMPLATE_I64_SUM_TYPE
+#define TEMPLATE_SUFFIX i64
+#include "RangeIndexTemplate.c"
+#undef TEMPLATE_TYPE
+#undef TEMPLATE_SUM_TYPE
+#undef TEMPLATE_SUFFIX
+
+// RangeIndex_f64
+#define TEMPLATE_TYPE TEMPLATE_F64_TYPE
+#define TEMPLATE_SUM_TYPE TEMPLATE_F64_SUM_TYPE
+#define TEMPLATE_SUFFIX f64
+#include "RangeIndexTemplate.c"
+#undef TEMPLATE_TYPE
+#undef TEMPLATE_SUM_TYPE
+#undef TEMPLATE_SUFFIX
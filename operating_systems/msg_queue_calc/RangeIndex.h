@@ -0,0 +1,49 @@
+/**
+ * Range Index Header - Order Statistic Treap
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#pragma once
+#ifndef _RANGE_INDEX_H_
+#define _RANGE_INDEX_H_
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "Template.h"
+
+/**
+ * Answers count/sum range and rank queries in O(log d), d the number
+ * of distinct keys. The distinct keys are the nodes of a treap (a binary
+ * search tree kept balanced, in expectation, by random heap priorities),
+ * each with its occurrences and the occurrences and sum of its subtree.
+ * A prefix query walks one root-to-leaf path, adding up the left subtrees
+ * it passes.
+ *
+ * Inserting a key, new or seen, and deleting all of a key are O(log d)
+ * too, updating the subtree totals on the way back up. Nodes live in one
+ * growable array and are linked by index, deleted ones are reused.
+ */
+
+// RangeIndex_i64, rangeindex_*_i64: long long keys, __int128 sums
+#define TEMPLATE_TYPE TEMPLATE_I64_TYPE
+#define TEMPLATE_SUM_TYPE TEMPLATE_I64_SUM_TYPE
+#define TEMPLATE_SUFFIX i64
+#include "RangeIndexTemplate.h"
+#undef TEMPLATE_TYPE
+#undef TEMPLATE_SUM_TYPE
+#undef TEMPLATE_SUFFIX
+
+// RangeIndex_f64, rangeindex_*_f64: double keys and sums
+#define TEMPLATE_TYPE TEMPLATE_F64_TYPE
+#define TEMPLATE_SUM_TYPE TEMPLATE_F64_SUM_TYPE
+#define TEMPLATE_SUFFIX f64
+#include "RangeIndexTemplate.h"
+#undef TEMPLATE_TYPE
+#undef TEMPLATE_SUM_TYPE
+#undef TEMPLATE_SUFFIX
+
+#endif
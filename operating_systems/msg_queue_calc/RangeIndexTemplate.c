@@ -0,0 +1,306 @@
+/**
+ * Range Index Template - Order Statistic Treap
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ *
+ * Included by RangeIndex.c once per value type, see Template.h.
+ * Nodes are referred to by their position in index->nodes, never
+ * by pointer, since allocating a node may move the array.
+ */
+
+/**
+ * @brief Returns the next node priority, from a xorshift generator.
+ *
+ * @param[inout] index, the range index holding the generator state.
+ * @return unsigned int, the priority.
+ */
+unsigned int TEMPLATE(_next_priority)(TEMPLATE(RangeIndex)* index)
+{
+    unsigned int x = index->seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    index->seed = x;
+    return x;
+}
+
+/**
+ * @brief Hands out a node holding one occurrence of key n,
+ * reusing a deleted node or growing the array if needed.
+ *
+ * @param[inout] index, the range index to allocate from.
+ * @param[in] n, the key of the node.
+ * @return int, the node.
+ */
+int TEMPLATE(_alloc_node)(TEMPLATE(RangeIndex)* index, TEMPLATE_TYPE n)
+{
+    int t = index->free_list;
+    if (t != 0) {
+        index->free_list = index->nodes[t].left;
+    } else {
+        if (index->used == index->capacity) {
+            index->capacity = index->capacity > 0 ? 2 * index->capacity : 1;
+            index->nodes = (TEMPLATE(RangeNode) *)realloc(index->nodes,
+                (index->capacity + 1) * sizeof(TEMPLATE(RangeNode)));
+            assert(index->nodes != NULL);
+        }
+        t = ++index->used;
+    }
+
+    TEMPLATE(RangeNode)* node = &index->nodes[t];
+    node->key = n;
+    node->sum = n;
+    node->count = 1;
+    node->total = 1;
+    node->left = 0;
+    node->right = 0;
+    node->priority = TEMPLATE(_next_priority)(index);
+    return t;
+}
+
+/**
+ * @brief Recomputes the subtree totals of node t from its children.
+ *
+ * @param[inout] index, the range index holding the node.
+ * @param[in] t, the node, not the empty tree.
+ */
+void TEMPLATE(_pull)(TEMPLATE(RangeIndex)* index, int t)
+{
+    TEMPLATE(RangeNode)* node = &index->nodes[t];
+    const TEMPLATE(RangeNode)* left = &index->nodes[node->left];
+    const TEMPLATE(RangeNode)* right = &index->nodes[node->right];
+    node->total = left->total + node->count + right->total;
+    node->sum = left->sum + (TEMPLATE_SUM_TYPE)node->count * node->key + right->sum;
+}
+
+/**
+ * @brief Rotates the left child of node t above it.
+ *
+ * @param[inout] index, the range index holding the node.
+ * @param[in] t, the node.
+ * @return int, the new subtree root.
+ */
+int TEMPLATE(_rotate_right)(TEMPLATE(RangeIndex)* index, int t)
+{
+    int l = index->nodes[t].left;
+    index->nodes[t].left = index->nodes[l].right;
+    index->nodes[l].right = t;
+    TEMPLATE(_pull)(index, t);
+    TEMPLATE(_pull)(index, l);
+    return l;
+}
+
+/**
+ * @brief Rotates the right child of node t above it.
+ *
+ * @param[inout] index, the range index holding the node.
+ * @param[in] t, the node.
+ * @return int, the new subtree root.
+ */
+int TEMPLATE(_rotate_left)(TEMPLATE(RangeIndex)* index, int t)
+{
+    int r = index->nodes[t].right;
+    index->nodes[t].right = index->nodes[r].left;
+    index->nodes[r].left = t;
+    TEMPLATE(_pull)(index, t);
+    TEMPLATE(_pull)(index, r);
+    return r;
+}
+
+/**
+ * @brief Adds an occurrence of key n to the subtree rooted at t.
+ *
+ * @param[inout] index, the range index holding the subtree.
+ * @param[in] t, the subtree root, 0 if empty.
+ * @param[in] n, the key to insert.
+ * @return int, the new subtree root.
+ */
+int TEMPLATE(_insert)(TEMPLATE(RangeIndex)* index, int t, TEMPLATE_TYPE n)
+{
+    if (t == 0) {
+        index->size++;
+        return TEMPLATE(_alloc_node)(index, n);
+    }
+
+    if (n == index->nodes[t].key) {
+        index->nodes[t].count++;
+    } else if (n < index->nodes[t].key) {
+        int left = TEMPLATE(_insert)(index, index->nodes[t].left, n);
+        index->nodes[t].left = left;
+        if (index->nodes[left].priority > index->nodes[t].priority) return TEMPLATE(_rotate_right)(index, t);
+    } else {
+        int right = TEMPLATE(_insert)(index, index->nodes[t].right, n);
+        index->nodes[t].right = right;
+        if (index->nodes[right].priority > index->nodes[t].priority) return TEMPLATE(_rotate_left)(index, t);
+    }
+    TEMPLATE(_pull)(index, t);
+    return t;
+}
+
+/**
+ * @brief Joins two subtrees, every key of a smaller than every key of b.
+ *
+ * @param[inout] index, the range index holding the subtrees.
+ * @param[in] a, the subtree with the smaller keys, 0 if empty.
+ * @param[in] b, the subtree with the larger keys, 0 if empty.
+ * @return int, the joined subtree root.
+ */
+int TEMPLATE(_merge)(TEMPLATE(RangeIndex)* index, int a, int b)
+{
+    if (a == 0) return b;
+    if (b == 0) return a;
+    if (index->nodes[a].priority > index->nodes[b].priority) {
+        int right = TEMPLATE(_merge)(index, index->nodes[a].right, b);
+        index->nodes[a].right = right;
+        TEMPLATE(_pull)(index, a);
+        return a;
+    }
+    int left = TEMPLATE(_merge)(index, a, index->nodes[b].left);
+    index->nodes[b].left = left;
+    TEMPLATE(_pull)(index, b);
+    return b;
+}
+
+/**
+ * @brief Removes the node of key n from the subtree rooted at t,
+ * and pushes it on the free list.
+ *
+ * @param[inout] index, the range index holding the subtree.
+ * @param[in] t, the subtree root, 0 if empty.
+ * @param[in] n, the key to delete.
+ * @param[out] removed, stores the occurrences removed.
+ * @return int, the new subtree root.
+ */
+int TEMPLATE(_delete)(TEMPLATE(RangeIndex)* index, int t, TEMPLATE_TYPE n, long* removed)
+{
+    if (t == 0) return 0;
+
+    if (n == index->nodes[t].key) {
+        *removed = index->nodes[t].count;
+        int joined = TEMPLATE(_merge)(index, index->nodes[t].left, index->nodes[t].right);
+        index->nodes[t].count = 0;     // Skipped by rangeindex_next
+        index->nodes[t].left = index->free_list;
+        index->free_list = t;
+        index->size--;
+        return joined;
+    }
+    if (n < index->nodes[t].key) index->nodes[t].left = TEMPLATE(_delete)(index, index->nodes[t].left, n, removed);
+    else index->nodes[t].right = TEMPLATE(_delete)(index, index->nodes[t].right, n, removed);
+    if (*removed > 0) TEMPLATE(_pull)(index, t);
+    return t;
+}
+
+/**
+ * @brief Counts (and sums) the keys below n, or up to n if inclusive,
+ * in one walk down from the root.
+ *
+ * @param[in] index, the range index to query.
+ * @param[in] n, the bound.
+ * @param[in] inclusive, whether keys equal to n are counted.
+ * @param[out] sum, stores the sum of the keys counted (nullable).
+ * @return long, the count.
+ */
+long TEMPLATE(_prefix)(const TEMPLATE(RangeIndex)* index, TEMPLATE_TYPE n, bool inclusive, TEMPLATE_SUM_TYPE* sum)
+{
+    long count = 0;
+    TEMPLATE_SUM_TYPE total = 0;
+    int t = index->root;
+    while (t != 0) {
+        const TEMPLATE(RangeNode)* node = &index->nodes[t];
+        if (node->key < n || (inclusive && node->key == n)) {
+            const TEMPLATE(RangeNode)* left = &index->nodes[node->left];
+            count += left->total + node->count;
+            total += left->sum + (TEMPLATE_SUM_TYPE)node->count * node->key;
+            t = node->right;
+        } else {
+            t = node->left;
+        }
+    }
+    if (sum != NULL) *sum = total;
+    return count;
+}
+
+TEMPLATE(RangeIndex)* TEMPLATE(rangeindex_create)(int capacity)
+{
+    assert(capacity >= 0);
+    TEMPLATE(RangeIndex)* index = (TEMPLATE(RangeIndex) *)calloc(1, sizeof(TEMPLATE(RangeIndex)));
+    assert(index != NULL);
+
+    index->capacity = capacity;
+    index->nodes = (TEMPLATE(RangeNode) *)calloc(capacity + 1, sizeof(TEMPLATE(RangeNode)));
+    assert(index->nodes != NULL);
+    index->seed = 2463534242u;
+    return index;
+}
+
+void TEMPLATE(rangeindex_insert)(TEMPLATE(RangeIndex)* index, TEMPLATE_TYPE n)
+{
+    assert(index != NULL);
+    index->root = TEMPLATE(_insert)(index, index->root, n);
+}
+
+long TEMPLATE(rangeindex_delete_all)(TEMPLATE(RangeIndex)* index, TEMPLATE_TYPE n)
+{
+    assert(index != NULL);
+    long removed = 0;
+    index->root = TEMPLATE(_delete)(index, index->root, n, &removed);
+    return removed;
+}
+
+long TEMPLATE(rangeindex_count_range)(const TEMPLATE(RangeIndex)* index, TEMPLATE_TYPE lo, TEMPLATE_TYPE hi)
+{
+    assert(index != NULL);
+    if (lo > hi) return 0;
+    return TEMPLATE(_prefix)(index, hi, true, NULL) - TEMPLATE(_prefix)(index, lo, false, NULL);
+}
+
+TEMPLATE_SUM_TYPE TEMPLATE(rangeindex_sum_range)(const TEMPLATE(RangeIndex)* index, TEMPLATE_TYPE lo, TEMPLATE_TYPE hi)
+{
+    assert(index != NULL);
+    if (lo > hi) return 0;
+    TEMPLATE_SUM_TYPE upper, lower;
+    TEMPLATE(_prefix)(index, hi, true, &upper);
+    TEMPLATE(_prefix)(index, lo, false, &lower);
+    return upper - lower;
+}
+
+long TEMPLATE(rangeindex_rank)(const TEMPLATE(RangeIndex)* index, TEMPLATE_TYPE n)
+{
+    assert(index != NULL);
+    return TEMPLATE(_prefix)(index, n, true, NULL);
+}
+
+TEMPLATE_TYPE TEMPLATE(rangeindex_get_max)(const TEMPLATE(RangeIndex)* index)
+{
+    assert(index != NULL && index->root != 0);
+    int t = index->root;
+    while (index->nodes[t].right != 0) t = index->nodes[t].right;
+    return index->nodes[t].key;
+}
+
+bool TEMPLATE(rangeindex_next)(const TEMPLATE(RangeIndex)* index, int* cursor, TEMPLATE_TYPE* key, long* count)
+{
+    assert(index != NULL && cursor != NULL && key != NULL && count != NULL);
+    // Walk the node array, deleted nodes hold no occurrences.
+    while (*cursor < index->used) {
+        const TEMPLATE(RangeNode)* node = &index->nodes[++*cursor];
+        if (node->count == 0) continue;
+        *key = node->key;
+        *count = node->count;
+        return true;
+    }
+    return false;
+}
+
+size_t TEMPLATE(rangeindex_allocated_bytes)(const TEMPLATE(RangeIndex)* index)
+{
+    assert(index != NULL);
+    return sizeof(TEMPLATE(RangeIndex)) + (index->capacity + 1) * sizeof(TEMPLATE(RangeNode));
+}
+
+void TEMPLATE(rangeindex_destroy)(TEMPLATE(RangeIndex)* index)
+{
+    assert(index != NULL);
+    free(index->nodes);
+    free(index);
+}
@@ -0,0 +1,124 @@
+/**
+ * Range Index Template Header - Order Statistic Treap
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ *
+ * Included by RangeIndex.h once per value type, see Template.h.
+ * No include guard on purpose.
+ */
+
+// Range Index Node, linked by index into the node array (0 is the empty tree)
+typedef struct {
+    TEMPLATE_TYPE key;      // Distinct key
+    TEMPLATE_SUM_TYPE sum;  // Sum of the keys in the subtree, with their occurrences
+    long count;             // Occurrences of the key
+    long total;             // Occurrences in the subtree
+    int left;               // Smaller keys
+    int right;              // Larger keys
+    unsigned int priority;  // Random, parents have larger priorities than their children
+} TEMPLATE(RangeNode);
+
+// Range Index Struct
+typedef struct {
+    TEMPLATE(RangeNode)* nodes; // Node array, nodes[0] is the empty tree
+    int root;               // Root node, 0 if empty
+    int size;               // Number of distinct keys
+    int capacity;           // Nodes the array holds, besides nodes[0]
+    int used;               // Nodes handed out so far, besides nodes[0]
+    int free_list;          // Deleted nodes, linked through left, 0 if none
+    unsigned int seed;      // State of the priority generator
+} TEMPLATE(RangeIndex);
+
+/**
+ * @brief Allocates and initializes a new, empty
+ * range index with the specified capacity.
+ *
+ * @param[in] capacity, the initializing number of distinct keys.
+ * @return TEMPLATE(RangeIndex)*, the range index.
+ */
+TEMPLATE(RangeIndex)* TEMPLATE(rangeindex_create)(int capacity);
+
+/**
+ * @brief Adds an occurrence of key n to the range index.
+ *
+ * @param[inout] index, the range index to insert into.
+ * @param[in] n, the key to insert.
+ */
+void TEMPLATE(rangeindex_insert)(TEMPLATE(RangeIndex)* index, TEMPLATE_TYPE n);
+
+/**
+ * @brief Removes all occurrences of key n
+ * from the range index.
+ *
+ * @param[inout] index, the range index to delete from.
+ * @param[in] n, the key to delete.
+ * @return long, the number of occurrences removed.
+ */
+long TEMPLATE(rangeindex_delete_all)(TEMPLATE(RangeIndex)* index, TEMPLATE_TYPE n);
+
+/**
+ * @brief Returns the number of keys k with lo <= k <= hi.
+ *
+ * @param[in] index, the range index to query.
+ * @param[in] lo, the lower bound, inclusive.
+ * @param[in] hi, the upper bound, inclusive.
+ * @return long, the count.
+ */
+long TEMPLATE(rangeindex_count_range)(const TEMPLATE(RangeIndex)* index, TEMPLATE_TYPE lo, TEMPLATE_TYPE hi);
+
+/**
+ * @brief Returns the sum of the keys k with lo <= k <= hi.
+ *
+ * @param[in] index, the range index to query.
+ * @param[in] lo, the lower bound, inclusive.
+ * @param[in] hi, the upper bound, inclusive.
+ * @return TEMPLATE_SUM_TYPE, the sum, which may not fit in TEMPLATE_TYPE.
+ */
+TEMPLATE_SUM_TYPE TEMPLATE(rangeindex_sum_range)(const TEMPLATE(RangeIndex)* index, TEMPLATE_TYPE lo, TEMPLATE_TYPE hi);
+
+/**
+ * @brief Returns the rank of n: the number of keys k <= n.
+ *
+ * @param[in] index, the range index to query.
+ * @param[in] n, the key to rank.
+ * @return long, the rank.
+ */
+long TEMPLATE(rangeindex_rank)(const TEMPLATE(RangeIndex)* index, TEMPLATE_TYPE n);
+
+/**
+ * @brief Returns the largest key, the index must not be empty.
+ *
+ * @param[in] index, the range index to query.
+ * @return TEMPLATE_TYPE, the maximum.
+ */
+TEMPLATE_TYPE TEMPLATE(rangeindex_get_max)(const TEMPLATE(RangeIndex)* index);
+
+/**
+ * @brief Iterates over the distinct keys, in no particular
+ * order. Start with *cursor = 0 and call until it returns false.
+ * The index must not be modified during the iteration.
+ *
+ * @param[in] index, the range index to iterate.
+ * @param[inout] cursor, the iteration position.
+ * @param[out] key, stores the next key.
+ * @param[out] count, stores its occurrences.
+ * @return true if a key was returned, false when done.
+ */
+bool TEMPLATE(rangeindex_next)(const TEMPLATE(RangeIndex)* index, int* cursor, TEMPLATE_TYPE* key, long* count);
+
+/**
+ * @brief Returns the number of bytes allocated
+ * by the specified range index.
+ *
+ * @param[in] index, the range index.
+ * @return size_t, the allocated bytes.
+ */
+size_t TEMPLATE(rangeindex_allocated_bytes)(const TEMPLATE(RangeIndex)* index);
+
+/**
+ * @brief Destroys and cleans up the
+ * specified range index.
+ *
+ * @param[in] index, the range index to destroy.
+ */
+void TEMPLATE(rangeindex_destroy)(TEMPLATE(RangeIndex)* index);
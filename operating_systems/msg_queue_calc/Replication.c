@@ -0,0 +1,220 @@
+/**
+ * Replication - Primary to Replica Mutation Stream
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#include <time.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/msg.h>
+
+#include "Replication.h"
+
+long long replication_now_ms()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Sleeps for the specified number of milliseconds.
+ *
+ * @param[in] ms, the milliseconds.
+ */
+void _sleep_ms(long ms)
+{
+    struct timespec delay = { ms / 1000, (ms % 1000) * 1000000 };
+    nanosleep(&delay, NULL);
+}
+
+/**
+ * @brief Sends the flusher's batch to every replica still fed and
+ * empties it. A replica whose queue stays full for REPLICA_TIMEOUT_MS
+ * is dropped, so a dead replica can't stall the primary.
+ * Called by the flusher, or once it stopped.
+ *
+ * @param[inout] log, the log.
+ * @param[in] last, whether this is the primary's last batch.
+ * @param[in] promote, with last, the replica to promote, 0 for none.
+ */
+void _flush(ReplicationLog* log, bool last, int promote)
+{
+    log->batch.last = last;
+    log->batch.promoted = promote;
+    size_t text = BATCH_TEXT_OF(log->batch.size);
+    for (int replica = log->first; replica <= log->replicas; replica++) {
+        if (log->dropped[replica]) continue;
+
+        log->batch.my_msg_type = replica;
+        log->batch.sequence = ++log->sequence[replica];
+        long long deadline = replication_now_ms() + REPLICA_TIMEOUT_MS;
+        while (msgsnd(log->qid, (void *)&log->batch, text, IPC_NOWAIT) == -1) {
+            if ((errno != EAGAIN && errno != EINTR) || replication_now_ms() > deadline) {
+                printf("Replica %d fell behind, no longer replicating to it.\n\n", replica);
+                log->dropped[replica] = true;
+                break;
+            }
+            _sleep_ms(1);
+        }
+    }
+    log->batch.size = 0;
+}
+
+/**
+ * @brief Sends mutations taken from the log in batches of up to
+ * REPLICATION_BATCH, at least one batch (a heartbeat if count is 0).
+ * Called by the flusher, or once it stopped.
+ *
+ * @param[inout] log, the log.
+ * @param[in] count, the mutations in log->sending.
+ * @param[in] last, whether these are the primary's last mutations.
+ * @param[in] promote, with last, the replica to promote, 0 for none.
+ */
+void _send(ReplicationLog* log, int count, bool last, int promote)
+{
+    int sent = 0;
+    do {
+        int size = (count - sent < REPLICATION_BATCH) ? count - sent : REPLICATION_BATCH;
+        memcpy(log->batch.mutations, log->sending + sent, size * sizeof(Mutation));
+        log->batch.size = size;
+        sent += size;
+        _flush(log, last && sent == count, promote);
+    } while (sent < count);
+}
+
+/**
+ * @brief Takes every pending mutation out of the log, into
+ * log->sending, so they can be sent without holding the lock.
+ * Called with the log's lock held.
+ *
+ * @param[inout] log, the log.
+ * @return int, the number of mutations taken.
+ */
+int _take(ReplicationLog* log)
+{
+    Mutation* swap = log->sending;
+    int swap_capacity = log->sending_capacity;
+    log->sending = log->pending;
+    log->sending_capacity = log->capacity;
+    log->pending = swap;
+    log->capacity = swap_capacity;
+
+    int count = log->size;
+    log->size = 0;
+    return count;
+}
+
+/**
+ * @brief Flusher thread, sends what is pending as soon as a full
+ * batch is, and at least every REPLICATION_INTERVAL_MS (a heartbeat
+ * if nothing is), until the log is destroyed.
+ *
+ * @param[in] arg, the log.
+ * @return void*, NULL.
+ */
+void* _flusher(void* arg)
+{
+    ReplicationLog* log = (ReplicationLog *)arg;
+    pthread_mutex_lock(&log->lock);
+    while (log->running) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_nsec += REPLICATION_INTERVAL_MS * 1000000L;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+        bool timed_out = false;
+        while (log->running && log->size < REPLICATION_BATCH && !timed_out) {
+            timed_out = pthread_cond_timedwait(&log->full, &log->lock, &deadline) == ETIMEDOUT;
+        }
+        if (!log->running) break;   // The pending mutations go with the last batch
+
+        int count = _take(log);
+        pthread_mutex_unlock(&log->lock);
+        _send(log, count, false, 0);
+        pthread_mutex_lock(&log->lock);
+    }
+    pthread_mutex_unlock(&log->lock);
+    return NULL;
+}
+
+ReplicationLog* replicationlog_create(int qid, int first, int replicas, const DatasetDefaults* defaults)
+{
+    assert(first >= 1 && replicas <= MAX_REPLICAS && defaults != NULL);
+    ReplicationLog* log = (ReplicationLog *)calloc(1, sizeof(ReplicationLog));
+    assert(log != NULL);
+
+    log->qid = qid;
+    log->first = first;
+    log->replicas = replicas;
+    log->batch.primary = getpid();
+    log->batch.replicas = replicas;
+    log->batch.defaults = *defaults;
+    log->capacity = log->sending_capacity = 4 * REPLICATION_BATCH;
+    log->pending = (Mutation *)malloc(log->capacity * sizeof(Mutation));
+    log->sending = (Mutation *)malloc(log->sending_capacity * sizeof(Mutation));
+    assert(log->pending != NULL && log->sending != NULL);
+    log->running = true;
+    assert(pthread_mutex_init(&log->lock, NULL) == 0);
+
+    // The flusher's deadlines are monotonic, like replication_now_ms.
+    pthread_condattr_t attributes;
+    assert(pthread_condattr_init(&attributes) == 0);
+    assert(pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC) == 0);
+    assert(pthread_cond_init(&log->full, &attributes) == 0);
+    pthread_condattr_destroy(&attributes);
+    assert(pthread_create(&log->flusher, NULL, _flusher, log) == 0);
+    return log;
+}
+
+void replicationlog_append(ReplicationLog* log, const Mutation* mutation)
+{
+    assert(log != NULL && mutation != NULL);
+    pthread_mutex_lock(&log->lock);
+    // Grows while a replica's queue is full, until the flusher drops it.
+    if (log->size == log->capacity) {
+        log->capacity *= 2;
+        log->pending = (Mutation *)realloc(log->pending, log->capacity * sizeof(Mutation));
+        assert(log->pending != NULL);
+    }
+    log->pending[log->size++] = *mutation;
+    if (log->size == REPLICATION_BATCH) pthread_cond_signal(&log->full);
+    pthread_mutex_unlock(&log->lock);
+}
+
+int replicationlog_destroy(ReplicationLog* log)
+{
+    assert(log != NULL);
+    pthread_mutex_lock(&log->lock);
+    log->running = false;
+    pthread_cond_signal(&log->full);
+    pthread_mutex_unlock(&log->lock);
+    pthread_join(log->flusher, NULL);
+
+    // Hand over to the lowest replica still fed, if any.
+    int promote = 0;
+    for (int replica = log->replicas; replica >= log->first; replica--) {
+        if (!log->dropped[replica]) promote = replica;
+    }
+    _send(log, _take(log), true, promote);
+    if (promote != 0 && log->dropped[promote]) promote = 0;   // Dropped by this very flush
+
+    pthread_cond_destroy(&log->full);
+    pthread_mutex_destroy(&log->lock);
+    free(log->pending);
+    free(log->sending);
+    free(log);
+    return promote;
+}
+
+int replication_receive(int qid, ReplicationBatch* batch, int replica)
+{
+    ssize_t received;
+    while ((received = msgrcv(qid, (void *)batch, BATCH_TEXT, replica, 0)) != -1) {
+        if (received >= (ssize_t)BATCH_TEXT_OF(0) && batch->size >= 0 && batch->size <= REPLICATION_BATCH &&
+            received == (ssize_t)BATCH_TEXT_OF(batch->size)) return (int)received;
+    }
+    return -1;
+}
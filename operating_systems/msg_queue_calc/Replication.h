@@ -0,0 +1,147 @@
+/**
+ * Replication Header - Primary to Replica Mutation Stream
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#pragma once
+#ifndef _REPLICATION_H_
+#define _REPLICATION_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+#include "Message.h"
+#include "DatasetTable.h"
+
+#define REPLICATION_BATCH 64        // Mutations per batch message
+#define REPLICATION_INTERVAL_MS 10  // Partial batches (or heartbeats) are sent at least this often
+#define REPLICA_TIMEOUT_MS 1000     // A replica whose queue stays full this long is dropped
+#define DEFAULT_STALENESS_MS 100    // Replicas refuse reads once the primary is silent this long
+#define MAX_REPLICAS 8
+
+// Replica r serves reads on the queues keyed ftok(path, REPLICA_QUEUE_ID(r))
+#define REPLICA_QUEUE_ID(replica) ('C' + (replica))
+// The mutation stream is the queue keyed ftok("calculator.c", REPLICATION_QUEUE_ID)
+#define REPLICATION_QUEUE_ID 'R'
+
+/**
+ * The primary appends every applied Insert, Delete and Create to a log
+ * while still holding the dataset's lock, so each dataset's mutations
+ * are logged in the order they were applied. Appending only copies the
+ * mutation, a flusher thread sends the log as batches on one SysV queue,
+ * each batch once per replica, typed with the replica's id (1..replicas),
+ * so a worker never waits on a replica's queue. A batch is sent once full
+ * and at least every REPLICATION_INTERVAL_MS, empty if need be, as a
+ * heartbeat. Only the mutations a batch holds are sent, a heartbeat is
+ * just the header.
+ *
+ * Replicas apply the batches in order and answer reads only while the
+ * primary was heard from within the staleness bound, so a read reflects
+ * every mutation older than REPLICATION_INTERVAL_MS plus the bound.
+ * When the primary exits its last batch promotes the lowest replica
+ * still fed, which takes over the primary's queues and the stream.
+ */
+
+// One applied mutation, in the dataset's type
+typedef struct {
+    unsigned int dataset;       // Dataset id
+    operation_type operation;   // INSERT, DELETE or CREATE
+    value_type type;            // Type of operands
+    Value operands[3];          // The argument, or the Create engine, lo and hi
+    unsigned long long version; // The dataset's version once the primary applied it
+} Mutation;
+
+// A batch of mutations, as sent on the queue
+typedef struct {
+    long int my_msg_type;               // Replica id the batch is addressed to
+    unsigned long sequence;             // Batches sent to this replica by this primary, from 1
+    pid_t primary;                      // The sending primary
+    int replicas;                       // Replica ids the primary feeds, 1..replicas
+    bool last;                          // Last batch of this primary, it is exiting
+    int promoted;                       // With last, the replica taking over (0 if none)
+    DatasetDefaults defaults;           // Engine for datasets created by an insert
+    int size;                           // Mutations in the batch
+    Mutation mutations[REPLICATION_BATCH];
+} ReplicationBatch;
+
+// Batch payload, everything past my_msg_type
+#define BATCH_TEXT (sizeof(ReplicationBatch) - sizeof(long int))
+// Payload of a batch holding size mutations, only those are sent
+#define BATCH_TEXT_OF(size) (offsetof(ReplicationBatch, mutations) - sizeof(long int) + (size) * sizeof(Mutation))
+
+// Primary side of the stream
+typedef struct {
+    int qid;                                    // Stream queue id
+    int first;                                  // Lowest replica id fed
+    int replicas;                               // Highest replica id fed
+    bool dropped[MAX_REPLICAS + 1];             // Flusher only: replicas that fell behind, no longer fed
+    unsigned long sequence[MAX_REPLICAS + 1];   // Flusher only: batches sent to each replica
+    ReplicationBatch batch;                     // Flusher only: the batch being sent
+    Mutation* sending;                          // Flusher only: mutations taken from the log
+    int sending_capacity;                       // Flusher only: space in sending
+    Mutation* pending;                          // Mutations not taken by the flusher yet
+    int size;                                   // Mutations pending
+    int capacity;                               // Space in pending, grown on demand
+    bool running;                               // Cleared to stop the flusher
+    pthread_mutex_t lock;                       // Guards pending, size, capacity and running
+    pthread_cond_t full;                        // Signalled when a full batch is pending, or to stop
+    pthread_t flusher;                          // Sends the pending mutations
+} ReplicationLog;
+
+/**
+ * @brief Returns a monotonic time in milliseconds.
+ *
+ * @return long long, the time.
+ */
+long long replication_now_ms();
+
+/**
+ * @brief Allocates a log feeding replicas first..replicas
+ * on the specified queue and starts its flusher thread.
+ *
+ * @param[in] qid, the stream queue id.
+ * @param[in] first, the lowest replica id to feed.
+ * @param[in] replicas, the highest replica id to feed.
+ * @param[in] defaults, the engine for implicitly created datasets.
+ * @return ReplicationLog*, the log.
+ */
+ReplicationLog* replicationlog_create(int qid, int first, int replicas, const DatasetDefaults* defaults);
+
+/**
+ * @brief Appends an applied mutation, waking the flusher
+ * once a full batch is pending. Never sends, called with
+ * the dataset's lock held.
+ *
+ * @param[inout] log, the log.
+ * @param[in] mutation, the mutation.
+ */
+void replicationlog_append(ReplicationLog* log, const Mutation* mutation);
+
+/**
+ * @brief Stops the flusher, sends the pending mutations with
+ * a promotion for the lowest replica still fed and destroys the log.
+ *
+ * @param[in] log, the log to destroy.
+ * @return int, the promoted replica id, 0 if none.
+ */
+int replicationlog_destroy(ReplicationLog* log);
+
+/**
+ * @brief Receives the next batch addressed to the specified replica.
+ * Batches are as long as the mutations they hold, one whose length
+ * doesn't match its size is discarded.
+ *
+ * @param[in] qid, the stream queue id.
+ * @param[out] batch, stores the batch.
+ * @param[in] replica, the replica id.
+ * @return int, the bytes received, -1 on error.
+ */
+int replication_receive(int qid, ReplicationBatch* batch, int replica);
+
+#endif
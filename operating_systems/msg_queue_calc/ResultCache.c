@@ -0,0 +1,113 @@
+/**
+ * Result Cache - Client Side Cache of Read Replies
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#include <time.h>
+
+#include "ResultCache.h"
+#include "HashMap.h"
+
+/**
+ * @brief Returns a monotonic time in milliseconds.
+ *
+ * @return long long, the time.
+ */
+long long _now_ms()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Returns whether two messages are the same read:
+ * same dataset, operation, type and arguments.
+ *
+ * @param[in] a, the first read.
+ * @param[in] b, the second read.
+ * @return true if the same, else false.
+ */
+bool _same_read(const Message* a, const Message* b)
+{
+    return a->dataset == b->dataset && a->operation == b->operation && a->type == b->type &&
+        memcmp(&a->operands[ARGUMENT], &b->operands[ARGUMENT], sizeof(Value)) == 0 &&
+        memcmp(&a->operands[ARGUMENT_HI], &b->operands[ARGUMENT_HI], sizeof(Value)) == 0;
+}
+
+/**
+ * @brief Returns the slot the specified read maps to.
+ *
+ * @param[in] cache, the cache.
+ * @param[in] request, the read.
+ * @return CachedResult*, the slot.
+ */
+CachedResult* _slot(ResultCache* cache, const Message* request)
+{
+    uint64_t hash = hash_int64(((long long)request->dataset << 32) | (request->operation << 8) | request->type);
+    hash = hash_int64(hash ^ request->operands[ARGUMENT].i);
+    hash = hash_int64(hash ^ request->operands[ARGUMENT_HI].i);
+    return &cache->slots[hash % RESULT_CACHE_SLOTS];
+}
+
+ResultCache* resultcache_create(long fresh_ms)
+{
+    assert(fresh_ms >= 0);
+    ResultCache* cache = (ResultCache *)calloc(1, sizeof(ResultCache));
+    assert(cache != NULL);
+    cache->fresh_ms = fresh_ms;
+    return cache;
+}
+
+bool resultcache_is_cacheable(operation_type op)
+{
+    return op < TOTAL_COMMANDS && !(op == INSERT || op == DELETE || op == CREATE);
+}
+
+bool resultcache_lookup(ResultCache* cache, Message* msg)
+{
+    assert(cache != NULL && msg != NULL);
+    CachedResult* cached = _slot(cache, msg);
+    bool found = cached->used && _same_read(&cached->request, msg);
+    if (found && cache->fresh_ms > 0 && _now_ms() - cached->fetched_ms < cache->fresh_ms) {
+        *msg = cached->reply;
+        cache->hits++;
+        return true;
+    }
+    msg->version = found ? cached->reply.version : 0;
+    return false;
+}
+
+void resultcache_store(ResultCache* cache, const Message* request, Message* reply)
+{
+    assert(cache != NULL && request != NULL && reply != NULL);
+    CachedResult* cached = _slot(cache, request);
+    if (reply->operation == UNCHANGED) {
+        assert(cached->used && _same_read(&cached->request, request));
+        cached->fetched_ms = _now_ms();
+        *reply = cached->reply;
+        cache->revalidated++;
+        return;
+    }
+
+    // Only results are kept, errors are asked again.
+    cache->misses++;
+    if (reply->operation == ERROR || reply->operation == BUSY) return;
+    cached->used = true;
+    cached->request = *request;
+    cached->reply = *reply;
+    cached->fetched_ms = _now_ms();
+}
+
+void resultcache_clear(ResultCache* cache)
+{
+    assert(cache != NULL);
+    for (int i = 0; i < RESULT_CACHE_SLOTS; i++) cache->slots[i].used = false;
+}
+
+void resultcache_destroy(ResultCache* cache)
+{
+    assert(cache != NULL);
+    free(cache);
+}
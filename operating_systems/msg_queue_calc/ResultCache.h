@@ -0,0 +1,99 @@
+/**
+ * Result Cache Header - Client Side Cache of Read Replies
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#pragma once
+#ifndef _RESULT_CACHE_H_
+#define _RESULT_CACHE_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "Message.h"
+
+#define RESULT_CACHE_SLOTS 64   // Cached replies, direct mapped by request
+
+/**
+ * Clients keep the replies to their reads, with the dataset version
+ * each was computed at. A reply younger than fresh_ms is reused
+ * without asking the server. Past that, the read is sent as a
+ * conditional read carrying the cached version, and an Unchanged
+ * reply renews the cached one. A fresh_ms of 0 never reuses a reply
+ * unasked, so results are never staler than the server's. Clients
+ * clear the cache after each of their own mutations.
+ */
+
+// A cached reply and the read it answers
+typedef struct {
+    bool used;                  // Whether the slot holds a reply
+    Message request;            // The read (dataset, operation, type, arguments)
+    Message reply;              // Its reply, with the dataset's version
+    long long fetched_ms;       // When the reply was last known current
+} CachedResult;
+
+// Result Cache Struct
+typedef struct {
+    CachedResult slots[RESULT_CACHE_SLOTS];
+    long fresh_ms;              // Replies are reused unasked for this long
+    long hits;                  // Reads answered from the cache, no round trip
+    long revalidated;           // Reads answered Unchanged by the server
+    long misses;                // Reads answered with a new result
+} ResultCache;
+
+/**
+ * @brief Allocates an empty cache.
+ *
+ * @param[in] fresh_ms, how long replies are reused without asking the server.
+ * @return ResultCache*, the cache.
+ */
+ResultCache* resultcache_create(long fresh_ms);
+
+/**
+ * @brief Returns whether replies to the operation
+ * may be cached, true for reads only.
+ *
+ * @param[in] op, the operation.
+ * @return true if cacheable, else false.
+ */
+bool resultcache_is_cacheable(operation_type op);
+
+/**
+ * @brief Answers a read from the cache if its reply is still
+ * fresh. Otherwise sets the read's version to the cached reply's
+ * (0 if none), making it a conditional read.
+ *
+ * @param[inout] cache, the cache.
+ * @param[inout] msg, the read, replaced with the cached reply if answered.
+ * @return true if answered from the cache, false if it must be sent.
+ */
+bool resultcache_lookup(ResultCache* cache, Message* msg);
+
+/**
+ * @brief Caches the reply to a read, or renews the cached
+ * reply if the server answered it Unchanged.
+ *
+ * @param[inout] cache, the cache.
+ * @param[in] request, the read, as sent.
+ * @param[inout] reply, the server's reply. An Unchanged reply
+ * is replaced with the cached one.
+ */
+void resultcache_store(ResultCache* cache, const Message* request, Message* reply);
+
+/**
+ * @brief Drops every cached reply.
+ *
+ * @param[inout] cache, the cache.
+ */
+void resultcache_clear(ResultCache* cache);
+
+/**
+ * @brief Destroys and cleans up the specified cache.
+ *
+ * @param[in] cache, the cache to destroy.
+ */
+void resultcache_destroy(ResultCache* cache);
+
+#endif
@@ -0,0 +1,271 @@
+/**
+ * Snapshot - Background (Fork) Dataset Snapshots
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "Snapshot.h"
+#include "Chrono.h"
+
+/**
+ * @brief Returns the calling process' private dirty memory,
+ * pages it no longer shares with its parent (or children).
+ *
+ * @return long, the memory in bytes, 0 if unavailable.
+ */
+long _private_dirty_bytes()
+{
+    FILE* smaps = fopen("/proc/self/smaps_rollup", "r");
+    if (smaps == NULL) return 0;
+
+    char line[128];
+    long kilobytes = 0;
+    while (fgets(line, sizeof(line), smaps) != NULL) {
+        if (sscanf(line, "Private_Dirty: %ld kB", &kilobytes) == 1) break;
+    }
+    fclose(smaps);
+    return kilobytes * 1024;
+}
+
+/**
+ * @brief Writes a dataset's header and its distinct
+ * numbers, see Snapshot.h for their order.
+ *
+ * @param[in] entry, the dataset entry.
+ * @param[in] out, the snapshot file.
+ * @return true if written, else false.
+ */
+bool _write_dataset(const DatasetEntry* entry, FILE* out)
+{
+    const Dataset* dataset = entry->dataset;
+    SnapshotHeader header = { entry->id, dataset->engine, dataset->type, 0, 0, 0, entry->version };
+    SnapshotPair pair;
+    bool ok;
+
+    if (dataset->engine == ENGINE_DENSE) {
+        const DenseCounter* dense = dataset->dense;
+        header.lo = dense->lo;
+        header.hi = dense->hi;
+        for (long i = 0; i < dense->level_size[0]; i++) header.pairs += (dense->counts[0][i] > 0);
+
+        ok = fwrite(&header, sizeof(header), 1, out) == 1;
+        for (long i = 0; ok && i < dense->level_size[0]; i++) {
+            if (dense->counts[0][i] == 0) continue;
+            pair.value.i = dense->lo + i;
+            pair.count = dense->counts[0][i];
+            ok = fwrite(&pair, sizeof(pair), 1, out) == 1;
+        }
+        return ok;
+    }
+
+    // Lazy datasets: the live counts hold every distinct number, in no order.
+    if (dataset->engine == ENGINE_LAZY) {
+        const HashMap* live = (dataset->type == VALUE_INT64) ? dataset->lazy_i64->live : dataset->lazy_f64->live;
+        int cursor = 0;
+        long long key;
+        header.pairs = hashmap_size(live);
+
+        ok = fwrite(&header, sizeof(header), 1, out) == 1;
+        while (ok && hashmap_next(live, &cursor, &key, &pair.count)) {
+            memcpy(&pair.value, &key, sizeof(key));    // The key is the number's bits
+            ok = fwrite(&pair, sizeof(pair), 1, out) == 1;
+        }
+        return ok;
+    }
+
+    // Heap datasets: the range index holds the same numbers, deduplicated.
+    int cursor = 0;
+    header.pairs = (dataset->type == VALUE_INT64) ? dataset->ranges_i64->size : dataset->ranges_f64->size;
+
+    ok = fwrite(&header, sizeof(header), 1, out) == 1;
+    while (ok && ((dataset->type == VALUE_INT64) ?
+        rangeindex_next_i64(dataset->ranges_i64, &cursor, &pair.value.i, &pair.count) :
+        rangeindex_next_f64(dataset->ranges_f64, &cursor, &pair.value.f, &pair.count))) {
+        ok = fwrite(&pair, sizeof(pair), 1, out) == 1;
+    }
+    return ok;
+}
+
+/**
+ * @brief Writes every dataset to path.tmp, syncs it and renames it to path.
+ *
+ * @param[in] table, the datasets.
+ * @param[in] path, the snapshot file.
+ * @param[out] report, stores the file's size and datasets written.
+ * @return true if written, else false.
+ */
+bool _write_file(const DatasetTable* table, const char* path, SnapshotReport* report)
+{
+    char temporary[strlen(path) + 5];
+    sprintf(temporary, "%s.tmp", path);
+    FILE* out = fopen(temporary, "wb");
+    if (out == NULL) return false;
+
+    int version = SNAPSHOT_VERSION;
+    bool ok = fwrite(SNAPSHOT_MAGIC, 8, 1, out) == 1 &&
+        fwrite(&version, sizeof(int), 1, out) == 1 &&
+        fwrite(&table->size, sizeof(int), 1, out) == 1;
+    for (int i = 0; ok && i < table->size; i++) {
+        ok = _write_dataset(table->entries[i], out);
+    }
+    ok = ok && fflush(out) == 0 && fsync(fileno(out)) == 0;
+    report->bytes = ftell(out);
+    report->datasets = table->size;
+    ok = (fclose(out) == 0) && ok;
+    return ok && rename(temporary, path) == 0;
+}
+
+/**
+ * @brief Body of the snapshot child. Only this thread exists in the
+ * child and every dataset lock is held (by the parent's copy of this
+ * thread, at fork time), so the datasets are read without locking.
+ * Nothing is printed, stdout's lock may have been held by a worker.
+ *
+ * @param[in] table, the child's copy of the datasets.
+ * @param[in] path, the snapshot file.
+ * @param[in] report_fd, the pipe to report the outcome on.
+ */
+void _snapshot_child(const DatasetTable* table, const char* path, int report_fd)
+{
+    SnapshotReport report;
+    memset(&report, 0, sizeof(SnapshotReport));
+    long dirty = _private_dirty_bytes();
+
+    Chrono* chrono = chrono_init();
+    chrono_start(chrono);
+    report.ok = _write_file(table, path, &report);
+    chrono_end(chrono);
+    report.save_us = chrono_elapsed(chrono);
+
+    // Pages copied on write by either process are now private to the child.
+    report.cow_bytes = _private_dirty_bytes() - dirty;
+    if (report.cow_bytes < 0) report.cow_bytes = 0;
+    write(report_fd, &report, sizeof(SnapshotReport));
+    _exit(report.ok ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+bool snapshot_start(Snapshot* snapshot, DatasetTable* table, const char* path)
+{
+    assert(snapshot != NULL && table != NULL && path != NULL);
+    if (snapshot->child != 0) return false;
+
+    int fds[2];
+    if (pipe(fds) == -1) return false;
+
+    // Requests wait only for the fork, page tables are copied but not the datasets.
+    Chrono* chrono = chrono_init();
+    chrono_start(chrono);
+    datasettable_lock_all(table);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        _snapshot_child(table, path, fds[1]);
+    }
+    datasettable_unlock_all(table);
+    chrono_end(chrono);
+    snapshot->fork_us = chrono_elapsed(chrono);
+    chrono_destroy(chrono);
+
+    close(fds[1]);
+    if (pid == -1) {
+        close(fds[0]);
+        return false;
+    }
+    snapshot->child = pid;
+    snapshot->report = fds[0];
+    return true;
+}
+
+bool snapshot_finish(Snapshot* snapshot, SnapshotReport* report, bool block)
+{
+    assert(snapshot != NULL && report != NULL);
+    if (snapshot->child == 0) return false;
+
+    int status;
+    if (waitpid(snapshot->child, &status, block ? 0 : WNOHANG) != snapshot->child) return false;
+
+    // A child that died before reporting reads as a failure.
+    memset(report, 0, sizeof(SnapshotReport));
+    if (read(snapshot->report, report, sizeof(SnapshotReport)) != sizeof(SnapshotReport)) report->ok = false;
+    report->ok = report->ok && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+    report->fork_us = snapshot->fork_us;
+
+    close(snapshot->report);
+    snapshot->child = 0;
+    return true;
+}
+
+/**
+ * @brief Replaces the dataset in the entry with the
+ * snapshotted one. Called with the entry's lock held.
+ *
+ * @param[inout] entry, the dataset entry.
+ * @param[in] engine, the dataset's engine.
+ * @param[in] header, the dataset's header.
+ * @param[in] in, the snapshot file, positioned at the dataset's pairs.
+ * @return true if loaded, false if the file is truncated or corrupt,
+ * or the dataset doesn't fit in memory.
+ */
+bool _load_dataset(DatasetEntry* entry, const DatasetDefaults* engine, const SnapshotHeader* header, FILE* in)
+{
+    Dataset* loaded = datasettable_new_dataset(engine);
+    if (loaded == NULL) return false;
+    dataset_destroy(entry->dataset);
+    entry->dataset = loaded;
+
+    SnapshotPair pair;
+    for (long i = 0; i < header->pairs; i++) {
+        if (fread(&pair, sizeof(pair), 1, in) != 1 || pair.count < 1) return false;
+        for (long copy = 0; copy < pair.count; copy++) {
+            if (!dataset_insert(entry->dataset, pair.value)) return false;
+        }
+    }
+    return true;
+}
+
+int snapshot_load(DatasetTable* table, const char* path)
+{
+    assert(table != NULL && path != NULL);
+    FILE* in = fopen(path, "rb");
+    if (in == NULL) return -1;
+
+    char magic[8];
+    int version, num_datasets;
+    if (fread(magic, 8, 1, in) != 1 || memcmp(magic, SNAPSHOT_MAGIC, 8) != 0 ||
+        fread(&version, sizeof(int), 1, in) != 1 || version != SNAPSHOT_VERSION ||
+        fread(&num_datasets, sizeof(int), 1, in) != 1 || num_datasets < 0) {
+        fclose(in);
+        return -1;
+    }
+
+    int loaded = 0;
+    for (; loaded < num_datasets; loaded++) {
+        SnapshotHeader header;
+        if (fread(&header, sizeof(header), 1, in) != 1) break;
+
+        // Same checks as a Create, the engine must be one the dataset can be built with.
+        DatasetDefaults engine = table->defaults;
+        engine.engine = header.engine;
+        engine.type = header.type;
+        engine.lo = header.lo;
+        engine.hi = header.hi;
+        bool heap = (header.engine == ENGINE_HEAP || header.engine == ENGINE_LAZY) &&
+            (header.type == VALUE_INT64 || header.type == VALUE_DOUBLE);
+        bool dense = header.engine == ENGINE_DENSE && header.type == VALUE_INT64 && header.lo <= header.hi &&
+            (long)header.hi - header.lo < MAX_DENSE_RANGE;
+        if (!heap && !dense) break;
+
+        DatasetEntry* entry = datasettable_get(table, header.id, true);
+        pthread_mutex_lock(&entry->lock);
+        bool ok = _load_dataset(entry, &engine, &header, in);
+        entry->version = header.version;
+        pthread_mutex_unlock(&entry->lock);
+        if (!ok) break;
+    }
+    fclose(in);
+    return (loaded == num_datasets) ? loaded : -1;
+}
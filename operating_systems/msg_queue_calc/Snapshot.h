@@ -0,0 +1,107 @@
+/**
+ * Snapshot Header - Background (Fork) Dataset Snapshots
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#pragma once
+#ifndef _SNAPSHOT_H_
+#define _SNAPSHOT_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <sys/types.h>
+
+#include "DatasetTable.h"
+
+#define SNAPSHOT_MAGIC "CALCSNAP"   // First 8 bytes of every snapshot file
+#define SNAPSHOT_VERSION 2
+
+/**
+ * A snapshot is taken by fork(), like Redis' BGSAVE. The parent holds
+ * every dataset's lock only for the fork itself, so the child starts
+ * from a state between two commands, and keeps serving requests while
+ * the child writes its copy-on-write view of the datasets to disk.
+ * Pages either process writes while the child runs are copied by the
+ * kernel, that extra memory is reported as the child's private dirty
+ * memory (/proc/self/smaps_rollup) gained while it wrote the snapshot.
+ *
+ * File layout, native byte order: SNAPSHOT_MAGIC, the version and the
+ * number of datasets (ints), then per dataset a SnapshotHeader followed
+ * by its distinct numbers as SnapshotPair, in ascending order for dense
+ * datasets and in no particular order otherwise. Heap datasets are
+ * written from their range index, which holds the same numbers as the
+ * heaps, deduplicated and without tombstones, lazy datasets from their
+ * live counts.
+ */
+
+// A dataset in the snapshot file
+typedef struct {
+    unsigned int id;        // Dataset id
+    engine_type engine;     // Dataset engine
+    value_type type;        // Type of the numbers
+    int lo;                 // ENGINE_DENSE: smallest storable value
+    int hi;                 // ENGINE_DENSE: largest storable value
+    long pairs;             // SnapshotPairs that follow
+    unsigned long long version; // The dataset's version, restored as is
+} SnapshotHeader;
+
+// A distinct number and its occurrences
+typedef struct {
+    Value value;
+    long count;
+} SnapshotPair;
+
+// Outcome of a snapshot, sent back by the child
+typedef struct {
+    bool ok;                // Whether the file was written
+    long fork_us;           // Parent: time requests were paused for the fork
+    long save_us;           // Child: time spent writing the file
+    long cow_bytes;         // Child: memory copied on write while it ran
+    long long bytes;        // Child: size of the file
+    int datasets;           // Child: datasets written
+} SnapshotReport;
+
+// A snapshot in progress
+typedef struct {
+    pid_t child;            // Writing child, 0 if none
+    int report;             // Read end of the pipe the child reports on
+    long fork_us;           // Time the fork paused requests
+} Snapshot;
+
+/**
+ * @brief Starts a background snapshot of every dataset,
+ * written to path.tmp then renamed to path. Pauses
+ * requests only while forking.
+ *
+ * @param[inout] snapshot, the snapshot state, must not be running.
+ * @param[in] table, the datasets.
+ * @param[in] path, the snapshot file.
+ * @return true if the child was started, false if a snapshot is
+ * already running or fork failed.
+ */
+bool snapshot_start(Snapshot* snapshot, DatasetTable* table, const char* path);
+
+/**
+ * @brief Collects the running snapshot's child if it has exited.
+ *
+ * @param[inout] snapshot, the snapshot state.
+ * @param[out] report, stores the outcome if collected.
+ * @param[in] block, whether to wait for the child to exit.
+ * @return true if a child was collected, else false.
+ */
+bool snapshot_finish(Snapshot* snapshot, SnapshotReport* report, bool block);
+
+/**
+ * @brief Loads every dataset of a snapshot file into the table,
+ * replacing any dataset with the same id.
+ *
+ * @param[inout] table, the datasets.
+ * @param[in] path, the snapshot file.
+ * @return int, the number of datasets loaded, -1 if the file is unreadable or corrupt.
+ */
+int snapshot_load(DatasetTable* table, const char* path);
+
+#endif
@@ -0,0 +1,195 @@
+/**
+ * Space Saving - Heavy Hitter Sketch
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#include <string.h>
+
+#include "SpaceSaving.h"
+
+/**
+ * @brief Swaps two entries of the counter heap,
+ * keeping the positions up to date.
+ *
+ * @param[inout] sketch, the sketch.
+ * @param[in] a, the first heap position.
+ * @param[in] b, the second heap position.
+ */
+void _heap_swap(SpaceSaving* sketch, int a, int b)
+{
+    int temp = sketch->heap[a];
+    sketch->heap[a] = sketch->heap[b];
+    sketch->heap[b] = temp;
+    sketch->position[sketch->heap[a]] = a;
+    sketch->position[sketch->heap[b]] = b;
+}
+
+/**
+ * @brief Percolates the counter at the specified heap
+ * position down until its count is the smallest of its subtree.
+ *
+ * @param[inout] sketch, the sketch.
+ * @param[in] node, the heap position.
+ */
+void _sift_down(SpaceSaving* sketch, int node)
+{
+    while (true) {
+        int smallest = node, left = 2 * node + 1, right = 2 * node + 2;
+        if (left < sketch->size && sketch->counters[sketch->heap[left]].count < sketch->counters[sketch->heap[smallest]].count) smallest = left;
+        if (right < sketch->size && sketch->counters[sketch->heap[right]].count < sketch->counters[sketch->heap[smallest]].count) smallest = right;
+        if (smallest == node) return;
+        _heap_swap(sketch, node, smallest);
+        node = smallest;
+    }
+}
+
+/**
+ * @brief Percolates the counter at the specified heap
+ * position up until its parent's count is not larger.
+ *
+ * @param[inout] sketch, the sketch.
+ * @param[in] node, the heap position.
+ */
+void _sift_up(SpaceSaving* sketch, int node)
+{
+    while (node > 0) {
+        int parent = (node - 1) / 2;
+        if (sketch->counters[sketch->heap[parent]].count <= sketch->counters[sketch->heap[node]].count) return;
+        _heap_swap(sketch, node, parent);
+        node = parent;
+    }
+}
+
+int counter_rank_compare(const void* a, const void* b)
+{
+    const Counter* x = (const Counter *)a;
+    const Counter* y = (const Counter *)b;
+    if (x->count != y->count) return (x->count > y->count) ? -1 : 1;
+    return (x->value > y->value) - (x->value < y->value);
+}
+
+SpaceSaving* spacesaving_create(int capacity)
+{
+    assert(capacity > 0);
+    SpaceSaving* sketch = (SpaceSaving *)calloc(1, sizeof(SpaceSaving));
+    assert(sketch != NULL);
+
+    sketch->capacity = capacity;
+    sketch->counters = (Counter *)malloc(capacity * sizeof(Counter));
+    sketch->ranked = (Counter *)malloc(capacity * sizeof(Counter));
+    sketch->heap = (int *)malloc(capacity * sizeof(int));
+    sketch->position = (int *)malloc(capacity * sizeof(int));
+    assert(sketch->counters != NULL && sketch->ranked != NULL && sketch->heap != NULL && sketch->position != NULL);
+    sketch->slots = hashmap_create(capacity);
+    return sketch;
+}
+
+void spacesaving_add(SpaceSaving* sketch, long long value, long weight)
+{
+    assert(sketch != NULL && weight > 0);
+    long slot;
+    sketch->total += weight;
+    sketch->ranked_valid = false;
+
+    if (hashmap_get(sketch->slots, value, &slot)) {
+        // Monitored, the count only grows so percolate down.
+        sketch->counters[slot].count += weight;
+        _sift_down(sketch, sketch->position[slot]);
+    } else if (sketch->size < sketch->capacity) {
+        // Free counter, the value may have been evicted since it was last removed.
+        slot = sketch->size++;
+        sketch->counters[slot] = (Counter){ value, sketch->floor + weight, sketch->floor };
+        sketch->heap[slot] = slot;
+        sketch->position[slot] = slot;
+        hashmap_put(sketch->slots, value, slot);
+        _sift_up(sketch, slot);
+    } else {
+        // Replace the smallest counter, its count becomes our error.
+        slot = sketch->heap[0];
+        Counter* counter = &sketch->counters[slot];
+        hashmap_remove(sketch->slots, counter->value);
+        if (counter->count > sketch->floor) sketch->floor = counter->count;
+        counter->error = counter->count;
+        counter->count += weight;
+        counter->value = value;
+        hashmap_put(sketch->slots, value, slot);
+        _sift_down(sketch, 0);
+    }
+}
+
+bool spacesaving_remove(SpaceSaving* sketch, long long value)
+{
+    assert(sketch != NULL);
+    long slot;
+    if (!hashmap_get(sketch->slots, value, &slot)) return false;
+    hashmap_remove(sketch->slots, value);
+    sketch->ranked_valid = false;
+
+    // Replace its heap entry with the last one and restore the heap.
+    int last = --sketch->size;
+    int node = sketch->position[slot];
+    _heap_swap(sketch, node, last);
+    if (node < last) {
+        _sift_down(sketch, node);
+        _sift_up(sketch, node);
+    }
+
+    // Move the last counter into the freed one, so counters [0, size) stay in use.
+    if (slot != last) {
+        sketch->counters[slot] = sketch->counters[last];
+        sketch->position[slot] = sketch->position[last];
+        sketch->heap[sketch->position[slot]] = slot;
+        hashmap_put(sketch->slots, sketch->counters[slot].value, slot);
+    }
+    return true;
+}
+
+bool spacesaving_get(SpaceSaving* sketch, int rank, Counter* counter)
+{
+    assert(sketch != NULL && counter != NULL);
+    if (rank < 1 || rank > sketch->size) return false;
+
+    if (!sketch->ranked_valid) {
+        memcpy(sketch->ranked, sketch->counters, sketch->size * sizeof(Counter));
+        qsort(sketch->ranked, sketch->size, sizeof(Counter), counter_rank_compare);
+        sketch->ranked_valid = true;
+    }
+    *counter = sketch->ranked[rank - 1];
+    return true;
+}
+
+long spacesaving_error_bound(const SpaceSaving* sketch)
+{
+    assert(sketch != NULL);
+    // Only once all counters are taken can values be evicted.
+    return (sketch->size < sketch->capacity) ? 0 : sketch->total / sketch->capacity;
+}
+
+void spacesaving_clear(SpaceSaving* sketch)
+{
+    assert(sketch != NULL);
+    hashmap_clear(sketch->slots);
+    sketch->size = 0;
+    sketch->total = 0;
+    sketch->floor = 0;
+    sketch->ranked_valid = false;
+}
+
+size_t spacesaving_allocated_bytes(const SpaceSaving* sketch)
+{
+    assert(sketch != NULL);
+    return sizeof(SpaceSaving) + sketch->capacity * (2 * sizeof(Counter) + 2 * sizeof(int)) +
+        hashmap_allocated_bytes(sketch->slots);
+}
+
+void spacesaving_destroy(SpaceSaving* sketch)
+{
+    assert(sketch != NULL);
+    hashmap_destroy(sketch->slots);
+    free(sketch->counters);
+    free(sketch->ranked);
+    free(sketch->heap);
+    free(sketch->position);
+    free(sketch);
+}
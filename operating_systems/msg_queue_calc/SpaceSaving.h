@@ -0,0 +1,131 @@
+/**
+ * Space Saving Header - Heavy Hitter Sketch
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#pragma once
+#ifndef _SPACE_SAVING_H_
+#define _SPACE_SAVING_H_
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "HashMap.h"
+
+/**
+ * Tracks the most frequent values with a fixed number of counters
+ * (Metwally et al.). A value without a counter takes over the smallest
+ * counter and inherits its count as its error. Each reported count
+ * overestimates the true count by at most its error, errors are at most
+ * total / capacity, and every value occurring more than total / capacity
+ * times holds a counter.
+ *
+ * Removing a value frees its counter. A value may have been evicted
+ * before, so a value taking a freed counter starts from the largest
+ * count ever evicted (the floor) rather than 0, and counts still never
+ * underestimate. The bounds above count the occurrences added.
+ */
+
+// A monitored value
+typedef struct {
+    long long value;    // The value
+    long count;         // Estimated occurrences (never an underestimate)
+    long error;         // Maximum overestimate of count
+} Counter;
+
+// Space Saving Struct
+typedef struct {
+    Counter* counters;  // Monitored values
+    int* heap;          // Min-heap of counter indices, by count
+    int* position;      // Position of each counter in the heap
+    HashMap* slots;     // Value -> counter index
+    Counter* ranked;    // Counters sorted by count, cached for queries
+    bool ranked_valid;  // Whether ranked is up to date
+    int capacity;       // Number of counters
+    int size;           // Counters in use
+    long total;         // Total occurrences added
+    long floor;         // Largest count evicted, an unmonitored value occurs at most this often
+} SpaceSaving;
+
+/**
+ * @brief Allocates and initializes a new, empty
+ * sketch with the specified number of counters.
+ *
+ * @param[in] capacity, the number of counters.
+ * @return SpaceSaving*, the sketch.
+ */
+SpaceSaving* spacesaving_create(int capacity);
+
+/**
+ * @brief Adds weight occurrences of value to the sketch.
+ *
+ * @param[inout] sketch, the sketch.
+ * @param[in] value, the value.
+ * @param[in] weight, the number of occurrences.
+ */
+void spacesaving_add(SpaceSaving* sketch, long long value, long weight);
+
+/**
+ * @brief Removes all occurrences of value from the sketch,
+ * freeing its counter if it is monitored.
+ *
+ * @param[inout] sketch, the sketch.
+ * @param[in] value, the value.
+ * @return true if the value was monitored, else false.
+ */
+bool spacesaving_remove(SpaceSaving* sketch, long long value);
+
+/**
+ * @brief Gets the rank-th (1-indexed) most frequent value,
+ * ties broken by the smaller value.
+ *
+ * @param[inout] sketch, the sketch (the ranking is cached).
+ * @param[in] rank, the rank.
+ * @param[out] counter, stores the value, count and error.
+ * @return true if there is such a value, else false.
+ */
+bool spacesaving_get(SpaceSaving* sketch, int rank, Counter* counter);
+
+/**
+ * @brief Returns the maximum error of any count in the sketch.
+ *
+ * @param[in] sketch, the sketch.
+ * @return long, the error bound, total / capacity.
+ */
+long spacesaving_error_bound(const SpaceSaving* sketch);
+
+/**
+ * @brief Resets the sketch to empty.
+ *
+ * @param[inout] sketch, the sketch.
+ */
+void spacesaving_clear(SpaceSaving* sketch);
+
+/**
+ * @brief Returns the number of bytes allocated by the sketch.
+ *
+ * @param[in] sketch, the sketch.
+ * @return size_t, the allocated bytes.
+ */
+size_t spacesaving_allocated_bytes(const SpaceSaving* sketch);
+
+/**
+ * @brief Destroys and cleans up the specified sketch.
+ *
+ * @param[in] sketch, the sketch to destroy.
+ */
+void spacesaving_destroy(SpaceSaving* sketch);
+
+/**
+ * @brief qsort comparator ranking counters by count, descending,
+ * then by value, ascending.
+ *
+ * @param[in] a, the first Counter.
+ * @param[in] b, the second Counter.
+ * @return int, <0 if a ranks first, >0 if b does.
+ */
+int counter_rank_compare(const void* a, const void* b);
+
+#endif
@@ -0,0 +1,43 @@
+/**
+ * Template Header - Compile-Time Generic Containers
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#pragma once
+#ifndef _TEMPLATE_H_
+#define _TEMPLATE_H_
+
+/**
+ * The containers (Vector, PriorityQueue, MedianHeap, RangeIndex) are written
+ * once in a *Template.h / *Template.c pair and instantiated for each value
+ * type by including the pair with these parameters defined:
+ *
+ *  TEMPLATE_TYPE     the element type, e.g. long long
+ *  TEMPLATE_SUFFIX   appended to every type and function name, e.g. i64
+ *  TEMPLATE_FORMAT   printf conversion for an element, e.g. "%lld"
+ *  TEMPLATE_SUM_TYPE accumulator for sums of elements, wide enough that
+ *                    a sum of in range elements can't overflow (RangeIndex,
+ *                    LazyMedian only), e.g. __int128
+ *
+ * Each instantiation #undefs the parameters after the include, so the
+ * next one can define them again. Every comparison is a plain operator
+ * on TEMPLATE_TYPE, compiled (and inlined) per type.
+ */
+
+// Pastes the instantiation suffix onto a name: TEMPLATE(vec_get) -> vec_get_i64
+#define _TEMPLATE_PASTE(name, suffix) name##_##suffix
+#define _TEMPLATE_EXPAND(name, suffix) _TEMPLATE_PASTE(name, suffix)
+#define TEMPLATE(name) _TEMPLATE_EXPAND(name, TEMPLATE_SUFFIX)
+
+// Instantiation parameters for 64-bit integers
+#define TEMPLATE_I64_TYPE long long
+#define TEMPLATE_I64_FORMAT "%lld"
+#define TEMPLATE_I64_SUM_TYPE __int128
+
+// Instantiation parameters for doubles
+#define TEMPLATE_F64_TYPE double
+#define TEMPLATE_F64_FORMAT "%.17g"
+#define TEMPLATE_F64_SUM_TYPE double
+
+#endif
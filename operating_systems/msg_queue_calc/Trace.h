@@ -0,0 +1,37 @@
+/**
+ * Trace Header : Static Tracepoints
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#pragma once
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+/**
+ * Statically defined (USDT) tracepoints for perf, bpftrace and systemtap.
+ * When <sys/sdt.h> is available each probe compiles to a single nop plus an
+ * ELF note describing its arguments, so probes can be enabled on a running
+ * binary without rebuilding, e.g.
+ *
+ *     $ bpftrace -e 'usdt:./calculator:calculator:dispatch { @[arg0] = count(); }'
+ *
+ * Build with -DCALC_NO_TRACE (make CFLAGS=-DCALC_NO_TRACE), or without
+ * <sys/sdt.h> installed (systemtap-sdt-dev), and the probes compile to nothing.
+ *
+ * Probe arguments are always (operation_type op, long size).
+ */
+#if !defined(CALC_NO_TRACE) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define CALC_TRACE_ENABLED
+#endif
+#endif
+
+#ifdef CALC_TRACE_ENABLED
+#define TRACE(provider, name, op, size) DTRACE_PROBE2(provider, name, (int)(op), (long)(size))
+#else
+#define TRACE(provider, name, op, size) do { (void)(op); (void)(size); } while (0)
+#endif
+
+#endif
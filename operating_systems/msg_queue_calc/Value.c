@@ -0,0 +1,72 @@
+/**
+ * Value - Typed Dataset Values
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+
+#include "Value.h"
+
+bool value_parse(const char* text, Value* value, value_type* type)
+{
+    char* end;
+    errno = 0;
+
+    // Integers are parsed exactly, anything else is a double.
+    long long i = strtoll(text, &end, 10);
+    if (end != text && *end == '\0' && errno == 0) {
+        value->i = i;
+        *type = VALUE_INT64;
+        return true;
+    }
+
+    double f = strtod(text, &end);
+    if (end == text || *end != '\0') return false;
+    value->f = f;
+    *type = VALUE_DOUBLE;
+    return true;
+}
+
+bool value_convert(Value* value, value_type from, value_type to)
+{
+    if (from == to) return true;
+    if (to == VALUE_DOUBLE) {
+        value->f = (double)value->i;
+        return true;
+    }
+
+    // 2^63 is exactly representable, so this bounds check is exact.
+    double f = value->f;
+    if (!(f >= -9223372036854775808.0 && f < 9223372036854775808.0) || f != (double)(long long)f) return false;
+    value->i = (long long)f;
+    return true;
+}
+
+bool value_convert_bound(Value* value, value_type from, value_type to, bool upper)
+{
+    if (from == to || to == VALUE_DOUBLE) return value_convert(value, from, to);
+
+    double f = value->f;
+    if (f != f) return false;
+    f = upper ? floor(f) : ceil(f);
+    if (f >= 9223372036854775808.0) value->i = LLONG_MAX;
+    else if (f < -9223372036854775808.0) value->i = LLONG_MIN;
+    else value->i = (long long)f;
+    return true;
+}
+
+void value_print(FILE* out, Value value, value_type type)
+{
+    if (type == VALUE_INT64) { fprintf(out, "%lld", value.i); return; }
+
+    // Shortest of 15 or 17 digits that reads back as the same double.
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.15g", value.f);
+    if (strtod(buffer, NULL) != value.f) snprintf(buffer, sizeof(buffer), "%.17g", value.f);
+    fputs(buffer, out);
+}
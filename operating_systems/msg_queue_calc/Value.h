@@ -0,0 +1,71 @@
+/**
+ * Value Header - Typed Dataset Values
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#pragma once
+#ifndef _VALUE_H_
+#define _VALUE_H_
+
+#include <stdio.h>
+#include <stdbool.h>
+
+// Type of the values held by a dataset (and carried by a message)
+typedef enum {
+    VALUE_INT64,    // long long
+    VALUE_DOUBLE    // double
+} value_type;
+
+// A value of either type, which member is set is given by a value_type
+typedef union {
+    long long i;    // VALUE_INT64
+    double f;       // VALUE_DOUBLE
+} Value;
+
+/**
+ * @brief Parses a number, as an int64 unless it has
+ * a fraction, an exponent or is inf/nan.
+ *
+ * @param[in] text, the number.
+ * @param[out] value, stores the parsed value.
+ * @param[out] type, stores the parsed value's type.
+ * @return true if parsed, false if text isn't a number.
+ */
+bool value_parse(const char* text, Value* value, value_type* type);
+
+/**
+ * @brief Converts a value to the specified type in place.
+ * Doubles only convert to int64 if they hold an integer in range.
+ *
+ * @param[inout] value, the value to convert.
+ * @param[in] from, the value's type.
+ * @param[in] to, the type to convert to.
+ * @return true if converted exactly, else false (value unchanged).
+ */
+bool value_convert(Value* value, value_type from, value_type to);
+
+/**
+ * @brief Converts a range bound to the specified type in place.
+ * A double bound for int64 is rounded inwards (a lower bound up, an
+ * upper bound down) and saturated, so the same numbers fall in range.
+ *
+ * @param[inout] value, the bound to convert.
+ * @param[in] from, the bound's type.
+ * @param[in] to, the type to convert to.
+ * @param[in] upper, whether this is an upper (else lower) bound.
+ * @return true if converted, false if the bound is NaN.
+ */
+bool value_convert_bound(Value* value, value_type from, value_type to, bool upper);
+
+/**
+ * @brief Prints the value, a double with enough
+ * digits to read it back exactly.
+ *
+ * @param[in] out, the stream to print to.
+ * @param[in] value, the value.
+ * @param[in] type, the value's type.
+ */
+void value_print(FILE* out, Value value, value_type type);
+
+#endif
@@ -13,94 +13,28 @@
 #include <stdbool.h>
 #include <assert.h> 
 
-// Vector struct
-typedef struct {           
-    char*  elems;  // The vector's backing array
-    int capacity;  // The vector's total space
-    size_t size;   // The vector's occupied space
-} Vector;
+#include "Template.h"
 
-/**
- * @brief Allocates and initializes 
- * a new vector with the specified capacity.
- * 
- * @param[in] capacity, the vector's capacity.
- * @return Vector*, the initialized vector.
- */
-Vector* vec_allocate(int capacity);
+// Vector_i64, vec_*_i64: vector of long long
+#define TEMPLATE_TYPE TEMPLATE_I64_TYPE
+#define TEMPLATE_SUFFIX i64
+#include "VectorTemplate.h"
+#undef TEMPLATE_TYPE
+#undef TEMPLATE_SUFFIX
 
-/**
- * @brief Destroys and cleans up the 
- * specified vector.
- * 
- * @param[in] vector, the vector to destroy.
- */
-void vec_destroy(Vector* vector);
+// Vector_f64, vec_*_f64: vector of double
+#define TEMPLATE_TYPE TEMPLATE_F64_TYPE
+#define TEMPLATE_SUFFIX f64
+#include "VectorTemplate.h"
+#undef TEMPLATE_TYPE
+#undef TEMPLATE_SUFFIX
 
 /**
- * @brief Prints the contents of the 
- * specified vector.
+ * @brief Returns the total number of bytes currently
+ * allocated by all live vectors (structs and backing arrays).
  * 
- * @param[in] vector, the vector to print. 
+ * @return size_t, the allocated bytes.
  */
-void vec_print(const Vector* vector);
-
-/**
- * @brief Adds the specified element to the 
- * specified vector.
- * 
- * @param[inout] vector, the vector to add the element to.
- * @param[in] elem, the element to add.
- * @return true if elem added successfully, false otherwise.
- */
-bool vec_pushback(Vector* vector, char elem);
-
-/**
- * @brief Returns the capacity of the specified vector.
- * 
- * @param[in] vector, the vector to get the capacity of.
- * @return int, the capacity.
- */
-int vec_capacity(const Vector* vector);
-
-/**
- * @brief Returns the ssize of the specified vector.
- * 
- * @param[in] vector, the vector to get the size of.
- * @return int, the size.
- */
-int vec_size(const Vector* vector);
-
-
-/**
- * @brief Returns the value stored at the
- * specified index in the specified vector.
- * 
- * @param[in] vector, the vector to index.
- * @param[in] index, the index.
- * @return int, the value stored at the index.
- */
-int vec_get(const Vector* vector, int index);
-
-/**
- * @brief Removes and returns the value of the
- * last element in the specified vector.
- * 
- * @param[inout] vector, the vector to pop.
- * @return int, the popped value.
- */
-int vec_pop(Vector* vector);
-
-/**
- * @brief Swaps the elements at index_a and index_b
- * in the specified vector.
- * 
- * @param[inout] vector, the vector to swap elems in. 
- * @param[in] index_a, the first index. 
- * @param[in] index_b, the second index. 
- */
-void vec_swap(Vector* vector, int index_a, int index_b);
-
-
+size_t vec_allocated_bytes();
 
 #endif
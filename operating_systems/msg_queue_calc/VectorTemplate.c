@@ -0,0 +1,103 @@
+/**
+ * Vector Template - Dynamically Resizing Collection
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ *
+ * Included by Vector.c once per value type, see Template.h.
+ * Counts its allocations in Vector.c's allocated_bytes.
+ */
+
+TEMPLATE(Vector)* TEMPLATE(vec_allocate)(int capacity)
+{
+    assert(capacity >= 0);
+
+    TEMPLATE(Vector)* vector = (TEMPLATE(Vector)* )malloc(sizeof(TEMPLATE(Vector)));
+    assert(vector != NULL);
+
+    // Initialize the vector.
+    vector->capacity = capacity;
+    vector->size = 0;
+    vector->elems = (TEMPLATE_TYPE* )malloc(capacity * sizeof(TEMPLATE_TYPE));
+
+    __atomic_add_fetch(&allocated_bytes, sizeof(TEMPLATE(Vector)) + capacity * sizeof(TEMPLATE_TYPE), __ATOMIC_RELAXED);
+    return vector;
+}
+
+void TEMPLATE(vec_destroy)(TEMPLATE(Vector)* vector)
+{
+    assert(vector != NULL);
+    //printf("Cleanup vector.\n");
+    __atomic_sub_fetch(&allocated_bytes, sizeof(TEMPLATE(Vector)) + vector->capacity * sizeof(TEMPLATE_TYPE), __ATOMIC_RELAXED);
+    free(vector->elems);
+    free(vector);
+}
+
+void TEMPLATE(vec_print)(const TEMPLATE(Vector)* vector)
+{
+    assert(vector != NULL);
+
+    printf("[");
+    for (int i = 0; i < (int)vector->size - 1; i++)
+    {
+        printf(TEMPLATE_FORMAT ", ", vector->elems[i]);
+    }
+
+    vector->size > 0 ? 
+        printf(TEMPLATE_FORMAT "]\n", vector->elems[vector->size - 1]) :
+        printf("]\n");
+}
+
+/**
+ * @brief *Private Method* Increases the capacity
+ * of the specified vector to new_capacity.
+ * 
+ * @param[inout] vector, the vector to increase the capacity of.
+ * @param[in] new_capacity, the new capacity. 
+ */
+void TEMPLATE(_increase_capacity)(TEMPLATE(Vector)* vector, int new_capacity)
+{
+    // Ensure new cap is larger than current cap
+    assert((vector != NULL) && (vector->capacity < new_capacity));
+
+    // Allocate a new backing array
+    TEMPLATE_TYPE* new_vector = (TEMPLATE_TYPE* )malloc(new_capacity * sizeof(TEMPLATE_TYPE));
+    assert(new_vector != NULL);
+
+    // Copy the elems from the current one to the new one.
+    for (int i = 0; i < vector->capacity; i++) {
+		new_vector[i] = vector->elems[i];
+	}
+
+    // Update the capacity
+    __atomic_add_fetch(&allocated_bytes, (new_capacity - vector->capacity) * sizeof(TEMPLATE_TYPE), __ATOMIC_RELAXED);
+    vector->capacity = new_capacity;
+
+    // Free the old backing array, assign the new one to the vector.
+	free(vector->elems);
+	vector->elems = new_vector;
+}
+
+bool TEMPLATE(vec_pushback)(TEMPLATE(Vector)* vector, TEMPLATE_TYPE elem)
+{
+    assert(vector != NULL);
+
+    // If we don't have space, double the current capacity.
+    if (vector->size == vector->capacity) {
+        TEMPLATE(_increase_capacity)(vector, vector->capacity > 0 ? 2 * vector->capacity : 1);
+    }
+
+    // Append the specified elem and increment the size.
+    vector->elems[vector->size++] = elem;
+    return true;
+}
+
+int TEMPLATE(vec_capacity)(const TEMPLATE(Vector)* vector) {
+    assert(vector != NULL);
+    return vector->capacity;
+}
+
+TEMPLATE_TYPE TEMPLATE(vec_pop)(TEMPLATE(Vector)* vector) {
+    TEMPLATE_TYPE pop = vector->elems[vector->size - 1];
+    vector->size--;
+    return pop;
+}
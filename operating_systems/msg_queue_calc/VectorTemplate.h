@@ -0,0 +1,113 @@
+/**
+ * Vector Template Header - Dynamically Resizing Collection
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ *
+ * Included by Vector.h once per value type, see Template.h.
+ * No include guard on purpose. The accessors used by the heap
+ * loops are static inline here, so each type's comparisons
+ * compile down to direct array accesses.
+ */
+
+// Vector struct
+typedef struct {           
+    TEMPLATE_TYPE* elems;  // The vector's backing array
+    int capacity;          // The vector's total space
+    size_t size;           // The vector's occupied space
+} TEMPLATE(Vector);
+
+/**
+ * @brief Allocates and initializes 
+ * a new vector with the specified capacity.
+ * 
+ * @param[in] capacity, the vector's capacity.
+ * @return Vector*, the initialized vector.
+ */
+TEMPLATE(Vector)* TEMPLATE(vec_allocate)(int capacity);
+
+/**
+ * @brief Destroys and cleans up the 
+ * specified vector.
+ * 
+ * @param[in] vector, the vector to destroy.
+ */
+void TEMPLATE(vec_destroy)(TEMPLATE(Vector)* vector);
+
+/**
+ * @brief Prints the contents of the 
+ * specified vector.
+ * 
+ * @param[in] vector, the vector to print. 
+ */
+void TEMPLATE(vec_print)(const TEMPLATE(Vector)* vector);
+
+/**
+ * @brief Adds the specified element to the 
+ * specified vector.
+ * 
+ * @param[inout] vector, the vector to add the element to.
+ * @param[in] elem, the element to add.
+ * @return true if elem added successfully, false otherwise.
+ */
+bool TEMPLATE(vec_pushback)(TEMPLATE(Vector)* vector, TEMPLATE_TYPE elem);
+
+/**
+ * @brief Returns the capacity of the specified vector.
+ * 
+ * @param[in] vector, the vector to get the capacity of.
+ * @return int, the capacity.
+ */
+int TEMPLATE(vec_capacity)(const TEMPLATE(Vector)* vector);
+
+/**
+ * @brief Returns the ssize of the specified vector.
+ * 
+ * @param[in] vector, the vector to get the size of.
+ * @return int, the size.
+ */
+static inline int TEMPLATE(vec_size)(const TEMPLATE(Vector)* vector)
+{
+    assert(vector != NULL);
+    return vector->size;
+}
+
+/**
+ * @brief Returns the value stored at the
+ * specified index in the specified vector.
+ * 
+ * @param[in] vector, the vector to index.
+ * @param[in] index, the index.
+ * @return TEMPLATE_TYPE, the value stored at the index.
+ */
+static inline TEMPLATE_TYPE TEMPLATE(vec_get)(const TEMPLATE(Vector)* vector, int index)
+{
+    assert(vector != NULL);
+    assert(index >= 0 && index < vector->size);
+    return vector->elems[index];
+}
+
+/**
+ * @brief Removes and returns the value of the
+ * last element in the specified vector.
+ * 
+ * @param[inout] vector, the vector to pop.
+ * @return TEMPLATE_TYPE, the popped value.
+ */
+TEMPLATE_TYPE TEMPLATE(vec_pop)(TEMPLATE(Vector)* vector);
+
+/**
+ * @brief Swaps the elements at index_a and index_b
+ * in the specified vector.
+ * 
+ * @param[inout] vector, the vector to swap elems in. 
+ * @param[in] index_a, the first index. 
+ * @param[in] index_b, the second index. 
+ */
+static inline void TEMPLATE(vec_swap)(TEMPLATE(Vector)* vector, int index_a, int index_b)
+{
+    assert(vector != NULL && index_a < vector->size && index_b < vector->size);
+    TEMPLATE_TYPE temp = vector->elems[index_a];
+    // Swap a and b
+    vector->elems[index_a] = vector->elems[index_b];
+    vector->elems[index_b] = temp;
+}
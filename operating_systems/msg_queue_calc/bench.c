@@ -0,0 +1,160 @@
+/**
+ * Bench Module - Read Throughput with Replicas
+ * @Author: Yousef Yassin
+ * @Date: November 23, 2021
+ */
+
+#include <sys/ipc.h>
+#include <sys/wait.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "Message.h"
+#include "MessageQueueWrapper.h"
+#include "Chrono.h"
+
+/**
+ * Loads a dataset through the primary, then forks clients that each
+ * send the same number of reads, spread round robin over the primary
+ * and the replicas, and reports the aggregate read throughput. Run it
+ * once per replica count (with that many replicas started) to see how
+ * reads scale.
+ */
+
+static int backlog = 0;     // Requests queued at the server, as of its last reply
+
+// Reads cycled through by every client
+static const operation_type reads[] = { SUM, AVERAGE, MEDIAN, MINIMUM };
+
+/**
+ * @brief Opens the request and reply queues
+ * of the specified calculator, 0 for the primary.
+ *
+ * @param[in] replica, the replica id.
+ * @param[out] requests, stores the request queue id.
+ * @param[out] replies, stores the reply queue id.
+ */
+void open_queues(int replica, int* requests, int* replies)
+{
+    assert((*requests = message_queue_create(ftok("user.c", 'C' + replica))) != -1);
+    assert((*replies = message_queue_create(ftok("calculator.c", 'C' + replica))) != -1);
+}
+
+/**
+ * @brief Sends the message at its operation's priority and waits
+ * for the reply, throttled by the backlog the server advertised.
+ *
+ * @param[in] requests, the request queue id.
+ * @param[in] replies, the reply queue id.
+ * @param[inout] msg, the request, then the reply.
+ * @return true if answered, false if shed (Busy) or the queue stayed full.
+ */
+bool request(int requests, int replies, Message* msg)
+{
+    message_queue_throttle(backlog);
+    msg->my_msg_type = operation_priority(msg->operation);
+    if (message_queue_try_send(requests, msg, SEND_TIMEOUT_MS) == -1) return false;
+    assert(message_queue_receive(replies, (void *)msg, msg->reply_type) != -1);
+    backlog = msg->backlog;
+    return msg->operation != BUSY;
+}
+
+/**
+ * @brief A client process, sends its reads to the specified calculator.
+ *
+ * @param[in] replica, the calculator read from, 0 for the primary.
+ * @param[in] num_reads, the number of reads to send.
+ * @return int, the number of reads answered with an error or rejected.
+ */
+int client(int replica, int num_reads)
+{
+    int requests, replies, errors = 0;
+    open_queues(replica, &requests, &replies);
+
+    Message msg;
+    memset(&msg, 0, sizeof(Message));
+    msg.reply_type = getpid();
+    msg.dataset = DEFAULT_DATASET;
+    for (int i = 0; i < num_reads; i++) {
+        msg.operation = reads[i % (sizeof(reads) / sizeof(reads[0]))];
+        msg.type = VALUE_INT64;
+        msg.version = 0;    // Always computed, never answered Unchanged
+        if (!request(requests, replies, &msg) || msg.operation == ERROR) errors++;
+    }
+    return errors;
+}
+
+/**
+ * @brief Prints the benchmark's usage.
+ *
+ * @param[in] program, the program name.
+ */
+void usage(const char* program)
+{
+    printf("Usage: %s -c clients -n reads [-r replicas] [-s size]\n"
+        "  -c clients   client processes\n"
+        "  -n reads     reads sent by each client\n"
+        "  -r replicas  replicas 1..replicas share the reads with the primary (default 0)\n"
+        "  -s size      numbers inserted before reading (default 1000)\n", program);
+}
+
+int main(int argc, char* argv[])
+{
+    int clients = 0, num_reads = 0, replicas = 0, size = 1000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            clients = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            num_reads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            replicas = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            size = atoi(argv[++i]);
+        } else {
+            usage(argv[0]); exit(EXIT_FAILURE);
+        }
+    }
+    if (clients < 1 || num_reads < 1 || replicas < 0 || size < 1) {
+        usage(argv[0]); exit(EXIT_FAILURE);
+    }
+
+    // Load the dataset through the primary
+    int requests, replies;
+    open_queues(0, &requests, &replies);
+    Message msg;
+    memset(&msg, 0, sizeof(Message));
+    msg.reply_type = getpid();
+    msg.dataset = DEFAULT_DATASET;
+    srand(getpid());
+    for (int i = 0; i < size; i++) {
+        msg.operation = INSERT;
+        msg.type = VALUE_INT64;
+        msg.operands[ARGUMENT].i = rand() % 1000000;
+        while (!request(requests, replies, &msg)) msg.operation = INSERT;  // Retry if shed
+    }
+    usleep(100000);     // Let the replicas catch up
+
+    Chrono* chrono = chrono_init();
+    chrono_start(chrono);
+    for (int i = 0; i < clients; i++) {
+        pid_t pid = fork();
+        assert(pid != -1);
+        if (pid == 0) exit(client(i % (replicas + 1), num_reads) > 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+    }
+
+    int status, failed = 0;
+    while (wait(&status) > 0) {
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) failed++;
+    }
+    chrono_end(chrono);
+
+    double seconds = chrono_elapsed(chrono) / 1e6;
+    long total = (long)clients * num_reads;
+    printf("%d clients, %d replicas: %ld reads in %0.3fs, %0.0f reads/s", clients, replicas, total, seconds, total / seconds);
+    failed > 0 ? printf(" (%d clients got errors, stale replicas or overloaded?)\n", failed) : printf("\n");
+
+    chrono_destroy(chrono);
+    exit(EXIT_SUCCESS);
+}
@@ -2,9 +2,18 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <signal.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <pthread.h>
 #include <sys/msg.h>
 #include "MessageQueueWrapper.h"
-#include "MedianHeap.h"
+#include "DatasetTable.h"
+#include "Metrics.h"
+#include "Replication.h"
+#include "Snapshot.h"
+#include "Trace.h"
 /**
  * Calculator Module
  * @Author: Yousef Yassin
@@ -14,160 +23,880 @@
 #include "Message.h"
 #include "Chrono.h"
 
-#define INITIAL_CAPACITY 10 // Initial buffer capacity
+#define METRICS_PATH "calculator.prom"  // Where SIGUSR1 metrics snapshots are written
+#define SNAPSHOT_PATH "calculator.snap" // Where SIGUSR2 (BgSave) dataset snapshots are written
+#define DEFAULT_WORKERS 4                // Worker threads receiving requests
+#define MAX_WORKERS 64
+#define SHED_PERCENT 75                 // Queries and writes are shed past this much of the request queue
+#define COALESCE_MAX 32                 // Pending reads drained (and coalesced) with a received read
 // All other msg packet indexing definitions can be found in Message.h
 
+static DatasetTable* datasets;  // Every dataset, by id
+static Metrics* metrics;        // Command counts and processing times
+
+// Queues served by a worker
+typedef struct {
+    int requests;       // Queue requests are received on
+    int replies;        // Queue replies are sent on
+    bool writable;      // Whether Insert, Delete and Create are accepted
+} Endpoint;
+
+static int num_workers = DEFAULT_WORKERS;   // Workers per endpoint
+static pthread_t workers[2 * MAX_WORKERS];  // A promoted replica serves two endpoints
+static int num_running = 0;                 // Workers started
+static Endpoint endpoints[2];               // Own queues, then the primary's once promoted
+
+// Replication, see Replication.h
+static int replica_id = 0;                  // This replica's id, 0 on the primary
+static int stream = -1;                     // Mutation stream queue id, -1 if not replicating
+static ReplicationLog* replication = NULL;  // Feeds the replicas, on the (promoted) primary
+static int staleness_ms = DEFAULT_STALENESS_MS; // Replica: reads refused past this silence
+static volatile long long heard_ms;         // Replica: when the primary was last heard from
+static volatile bool in_sync = true;        // Replica: cleared if a mutation batch was missed
+static volatile bool promoted = false;      // Replica: took over from the primary
+
+static Snapshot snapshot;                   // Background save in progress, main thread only
+
+/**
+ * @brief Writes a Prometheus metrics snapshot to METRICS_PATH.
+ * The snapshot is written to a temporary file first and renamed
+ * so scrapers never read a partial file.
+ * 
+ * @param[in] qids, the ids of the message queues to report.
+ * @param[in] qnames, the label for each queue.
+ * @param[in] num_queues, the number of queues.
+ */
+void dump_metrics(const int qids[], const char* qnames[], int num_queues)
+{
+    FILE* out = fopen(METRICS_PATH ".tmp", "w");
+    if (out == NULL) { perror("Metrics snapshot"); return; }
+
+    metrics_write_prometheus(metrics, out, qids, qnames, num_queues, datasets);
+    fclose(out);
+    if (rename(METRICS_PATH ".tmp", METRICS_PATH) == -1) perror("Metrics snapshot");
+}
+
+/**
+ * @brief Starts a background save of every dataset to
+ * SNAPSHOT_PATH, unless one is already running.
+ */
+void start_bgsave()
+{
+    if (!snapshot_start(&snapshot, datasets, SNAPSHOT_PATH)) {
+        printf("Background save not started, %s.\n\n", (snapshot.child != 0) ? "one is running" : "fork failed");
+        return;
+    }
+    printf("Background save started, requests paused %ldus for the fork.\n\n", snapshot.fork_us);
+}
+
+/**
+ * @brief Reports and records the running background
+ * save once its child has exited.
+ * 
+ * @param[in] block, whether to wait for the child.
+ */
+void finish_bgsave(bool block)
+{
+    SnapshotReport report;
+    if (!snapshot_finish(&snapshot, &report, block)) return;
+
+    metrics_record_bgsave(metrics, &report);
+    if (!report.ok) {
+        printf("Background save failed.\n\n");
+        return;
+    }
+    printf("Background save of %d datasets (%lld bytes) done in %0.3fs, "
+        "fork paused requests %ldus, copy-on-write used %ld KB.\n\n",
+        report.datasets, report.bytes, report.save_us / 1e6, report.fork_us, report.cow_bytes / 1024);
+}
+
+/**
+ * @brief Replaces the entry's (empty) dataset with one
+ * using the engine and value type requested by a Create.
+ * Called with the entry's lock held.
+ * 
+ * @param[inout] entry, the dataset entry.
+ * @param[in] operands, the Create operands (engine, lo, hi).
+ * @param[in] type, the requested value type.
+ * @return true if created, false if the engine, type or range is
+ * invalid, or the dense counts don't fit in memory.
+ */
+bool create_dataset(DatasetEntry* entry, const Value operands[], value_type type)
+{
+    DatasetDefaults engine = datasets->defaults;
+    long long lo = operands[ENGINE_LO].i, hi = operands[ENGINE_HI].i;
+    engine.engine = (engine_type)operands[ENGINE_ARGUMENT].i;
+    engine.type = type;
+    if (engine.engine != ENGINE_HEAP && engine.engine != ENGINE_DENSE && engine.engine != ENGINE_LAZY) return false;
+    if (engine.type != VALUE_INT64 && engine.type != VALUE_DOUBLE) return false;
+    if (engine.engine == ENGINE_DENSE && (engine.type != VALUE_INT64 || lo > hi || hi - lo >= MAX_DENSE_RANGE ||
+        lo < INT_MIN || hi > INT_MAX)) return false;
+    engine.lo = lo;
+    engine.hi = hi;
+
+    Dataset* created = datasettable_new_dataset(&engine);
+    if (created == NULL) return false;
+    dataset_destroy(entry->dataset);
+    entry->dataset = created;
+    return true;
+}
+
+/**
+ * @brief Answers an aggregate into the message's result,
+ * flagging the message as an error if it's undefined.
+ * 
+ * @param[in] dataset, the dataset to aggregate.
+ * @param[in] aggregate, the aggregate to answer.
+ * @param[inout] msg, the message to store the result in.
+ */
+void answer_aggregate(const Dataset* dataset, aggregate_type aggregate, Message* msg)
+{
+    if (!dataset_aggregate(dataset, aggregate, &msg->operands[RESULT])) {
+        printf("Aggregate is undefined or overflows, return error!\n\n");
+        msg->operation = ERROR;
+    }
+}
+
+/**
+ * @brief Returns whether reads may be answered: always on
+ * the primary, on a replica only while it is in sync and
+ * heard from the primary within the staleness bound.
+ * 
+ * @return true if readable, else false.
+ */
+bool is_readable()
+{
+    if (replica_id == 0 || promoted) return true;
+    return in_sync && replication_now_ms() - heard_ms <= staleness_ms;
+}
+
 /**
  * @brief Processes the command in the specified 
  * message and modifies the message to store
  * the result.
  * 
  * @param[inout] msg, the message recieved.
+ * @param[in] chrono, the calling worker's timer.
+ * @param[in] writable, whether mutations are accepted (else reads only).
+ * @param[in] size, the payload bytes received with the request.
  */
-void command_controller(Message* msg) 
+void command_controller(Message* msg, Chrono* chrono, bool writable, int size) 
 {
-    static bool initialized = false;    // Single init for static structures.
-    static MedianHeap* dataset;         // Stores all numbers
-    static Chrono* chrono;              // Used as timer
-    static int medians[2];              // median buffer
-    static long total_elapsed[6];       // Tracks total proc. time for each command.
-    static int total_commands[6];       // Tracks total commands received for each command.
+    Value medians[2];                   // median buffer
+    operation_type op = msg->operation; // Received operation, msg->operation may become ERROR
 
-    if (!initialized) { 
-        initialized = true; dataset = medianheap_create(10); chrono = chrono_init(chrono); 
-    }
+    TRACE(calculator, dispatch, op, size);
 
-    if (msg->operation < 6 && msg->operation >= 0) total_commands[msg->operation]++;
+    chrono_start(chrono);               // Start timer
 
+    if (op == QUIT) {
+        printf("Received command Quit. Exiting.\n");
+        return;
+    }
+    if (op == BGSAVE) {
+        printf("Received command BgSave. Snapshotting in the background.\n\n");
+        kill(getpid(), SIGUSR2);    // The main thread forks, workers keep serving
+        return;
+    }
 
-    chrono_start(chrono);               // Start timer
+    // Replicas only serve (fresh enough) reads, mutations go to the primary.
+    bool mutation = (op == INSERT || op == DELETE || op == CREATE);
+    if (mutation ? !writable : !is_readable()) {
+        printf("Replica %d: %s, return error!\n\n", replica_id, mutation ? "read only" : "too stale to read");
+        msg->operation = ERROR;
+        chrono_end(chrono);                     // Stop timer
+        msg->elapsed = metrics_record(metrics, op, chrono_elapsed(chrono));
+        return;
+    }
 
+    // Only insert and create may bring a dataset into existence. The
+    // dataset's lock is held for the rest of the command.
+    DatasetEntry* entry = datasettable_get(datasets, msg->dataset, op == INSERT || op == CREATE);
+    if (entry != NULL) pthread_mutex_lock(&entry->lock);
+    Dataset* dataset = (entry != NULL) ? entry->dataset : NULL;
+    printf("Dataset %u: ", msg->dataset);
 
-    // If our set is empty, the only viable command is insert.
+    // Replies carry the dataset's version. A conditional read (a version in
+    // the request) is answered Unchanged, uncomputed, unless the dataset changed since.
+    unsigned long long known = msg->version;
+    msg->version = (entry != NULL) ? entry->version : 0;
+    if (entry != NULL && !mutation && known != 0 && entry->version <= known) {
+        printf("Received a conditional read, unchanged since version %llu.\n\n", known);
+        msg->operation = UNCHANGED;
+        pthread_mutex_unlock(&entry->lock);
+        chrono_end(chrono);                     // Stop timer
+        msg->elapsed = metrics_record(metrics, op, chrono_elapsed(chrono));
+        return;
+    }
+
+    // If our set is empty, the only viable commands are insert and create.
     // *Could return 0 as result too
-    if (medianheap_is_empty(dataset) && !(msg->operation == INSERT || msg->operation == QUIT)) { 
+    if (dataset == NULL || (dataset_is_empty(dataset) && !(op == INSERT || op == CREATE))) { 
         printf("Received command on empty set, return error!\n\n");
         msg->operation = ERROR;
+        if (entry != NULL) pthread_mutex_unlock(&entry->lock);
         chrono_end(chrono);                     // Stop timer
-        msg->elapsed = chrono_elapsed(chrono); 
+        msg->elapsed = metrics_record(metrics, op, chrono_elapsed(chrono)); 
         return; 
     }
     
+    // Numeric arguments arrive in the client's type, bring them to the dataset's.
+    // Inserted and deleted numbers must convert exactly, bounds are rounded inwards.
+    value_type type = dataset_type(dataset);
+    bool converted = true;
+    if (op == INSERT || op == DELETE) {
+        converted = value_convert(&msg->operands[ARGUMENT], msg->type, type);
+    } else if (op == RANK) {
+        converted = value_convert_bound(&msg->operands[ARGUMENT], msg->type, type, true);
+    } else if (op == COUNT_RANGE || op == SUM_RANGE) {
+        converted = value_convert_bound(&msg->operands[ARGUMENT], msg->type, type, false) &&
+            value_convert_bound(&msg->operands[ARGUMENT_HI], msg->type, type, true);
+    }
+    if (!converted) {
+        printf("Received a fractional argument for an integer dataset, return error!\n\n");
+        msg->operation = ERROR;
+        pthread_mutex_unlock(&entry->lock);
+        chrono_end(chrono);                     // Stop timer
+        msg->elapsed = metrics_record(metrics, op, chrono_elapsed(chrono));
+        return;
+    }
+
+    TRACE(calculator, medianheap_enter, op, dataset_size(dataset));
     switch(msg->operation) {
         case INSERT: {
-            printf("Received command Insert with argument %d.\n\n", (int)msg->operands[ARGUMENT]);
-            medianheap_insert(dataset, msg->operands[ARGUMENT]);
+            printf("Received command Insert with argument ");
+            value_print(stdout, msg->operands[ARGUMENT], type);
+            printf(".\n\n");
+            if (!dataset_insert(dataset, msg->operands[ARGUMENT])) {
+                printf("Argument out of the dataset's range, return error!\n\n");
+                msg->operation = ERROR;
+            }
             break;
         }
 
         case DELETE: {
-            printf("Received command Delete with argument %d.\n\n", (int)msg->operands[ARGUMENT]);
-            medianheap_delete_all(dataset, msg->operands[ARGUMENT]);
+            printf("Received command Delete with argument ");
+            value_print(stdout, msg->operands[ARGUMENT], type);
+            printf(".\n\n");
+            dataset_delete_all(dataset, msg->operands[ARGUMENT]);
             break;
         }
 
         case AVERAGE: {
             printf("Received command Average.\n");
-            msg->operands[RESULT] = medianheap_get_average(dataset);
+            answer_aggregate(dataset, AGGREGATE_MEAN, msg);
             break;
         }
 
         case SUM: {
             printf("Received command Sum.\n");
-            msg->operands[RESULT] = medianheap_get_sum(dataset);
+            answer_aggregate(dataset, AGGREGATE_SUM, msg);
             break;
         }
 
         case MINIMUM: {
             printf("Received command Minimum.\n");
-            msg->operands[RESULT] = medianheap_get_min(dataset);
+            msg->operands[RESULT] = dataset_get_min(dataset);
             break;
         }
 
         case MEDIAN: {
             printf("Received command Median.\n");
             // Third index indicates if two or 1 median.
-            if (medianheap_get_median2(dataset, medians)) {
+            if (dataset_get_median2(dataset, medians)) {
                 msg->operands[MEDIAN1] = medians[0];
                 msg->operands[MEDIAN2] = medians[1];
-                msg->operands[FLAG_TWO_MEDIAN] = TWO_MEDIANS;
+                msg->operands[FLAG_TWO_MEDIAN].i = TWO_MEDIANS;
             } else {
                 msg->operands[MEDIAN1] = medians[0];
-                msg->operands[FLAG_TWO_MEDIAN] = ONE_MEDIAN;
+                msg->operands[FLAG_TWO_MEDIAN].i = ONE_MEDIAN;
             }
             break;
         }
 
-        case QUIT: {
-            // Cleanup
-            medianheap_destroy(dataset);
-            chrono_destroy(chrono);
-            printf("Received command Quit. Exiting.\n");
-            return;
+        case COUNT_RANGE: {
+            printf("Received command Count Range.\n");
+            msg->operands[RESULT].i = dataset_count_range(dataset, msg->operands[ARGUMENT], msg->operands[ARGUMENT_HI]);
+            break;
+        }
+
+        case SUM_RANGE: {
+            printf("Received command Sum Range.\n");
+            if (!dataset_sum_range(dataset, msg->operands[ARGUMENT], msg->operands[ARGUMENT_HI], &msg->operands[RESULT])) {
+                printf("Sum overflows, return error!\n");
+                msg->operation = ERROR;
+            }
+            break;
+        }
+
+        case RANK: {
+            printf("Received command Rank.\n");
+            msg->operands[RESULT].i = dataset_rank(dataset, msg->operands[ARGUMENT]);
+            break;
+        }
+
+        case DISTINCT: {
+            printf("Received command Distinct.\n");
+            double error;
+            msg->operands[RESULT].f = dataset_distinct(dataset, &error);
+            msg->operands[ESTIMATE_ERROR].f = error;
+            msg->operands[FLAG_EXACT].i = (error == 0);
+            break;
+        }
+
+        case TOPK: {
+            printf("Received command TopK with argument %lld.\n", msg->operands[ARGUMENT].i);
+            Counter counter;
+            Value value;
+            // The rank is 64-bit on the wire, check it before narrowing it to an int.
+            long long rank = msg->operands[ARGUMENT].i;
+            if (rank < 1 || rank > INT_MAX || !dataset_topk(dataset, (int)rank, &counter, &value)) {
+                printf("No value with that rank, return error!\n\n");
+                msg->operation = ERROR;
+                break;
+            }
+            msg->operands[TOPK_VALUE] = value;
+            msg->operands[TOPK_COUNT].i = counter.count;
+            msg->operands[TOPK_ERROR].i = counter.error;
+            break;
+        }
+
+        case MAXIMUM: {
+            printf("Received command Maximum.\n");
+            msg->operands[RESULT] = dataset_get_max(dataset);
+            break;
+        }
+
+        case COUNT: {
+            printf("Received command Count.\n");
+            answer_aggregate(dataset, AGGREGATE_COUNT, msg);
+            break;
+        }
+
+        case VARIANCE: {
+            printf("Received command Variance.\n");
+            answer_aggregate(dataset, AGGREGATE_VARIANCE, msg);
+            break;
+        }
+
+        case STDDEV: {
+            printf("Received command Standard Deviation.\n");
+            answer_aggregate(dataset, AGGREGATE_STDDEV, msg);
+            break;
+        }
+
+        case GEOMEAN: {
+            printf("Received command Geometric Mean.\n");
+            answer_aggregate(dataset, AGGREGATE_GEOMEAN, msg);
+            break;
+        }
+
+        case CREATE: {
+            printf("Received command Create with engine %lld.\n\n", msg->operands[ENGINE_ARGUMENT].i);
+            // Switching engines would lose the numbers, only an empty dataset may be recreated.
+            if (!dataset_is_empty(dataset) || !create_dataset(entry, msg->operands, msg->type)) {
+                printf("Dataset not empty, invalid engine or range too large, return error!\n\n");
+                msg->operation = ERROR;
+            }
+            dataset = entry->dataset;
+            break;
         }
 
         default: {
+            pthread_mutex_unlock(&entry->lock);
             return; 
         }
     }
+    TRACE(calculator, medianheap_exit, op, dataset_size(dataset));
+    msg->type = type = dataset_type(dataset);  // Replies carry the dataset's type
+
+    // Every applied mutation moves the dataset to a new version.
+    if (mutation && msg->operation != ERROR) msg->version = ++entry->version;
+
+    // Forward applied mutations to the replicas, still under the dataset's lock so they keep its order.
+    if (replication != NULL && mutation && msg->operation != ERROR) {
+        Mutation applied = { msg->dataset, op, type, { msg->operands[0], msg->operands[1], msg->operands[2] }, msg->version };
+        replicationlog_append(replication, &applied);
+    }
+    pthread_mutex_unlock(&entry->lock);
 
     // Print status info on server
-    if (!(msg->operation == INSERT || msg->operation == DELETE)) {
+    if (!(msg->operation == INSERT || msg->operation == DELETE || msg->operation == CREATE || msg->operation == ERROR)) {
+        printf("Returned result ");
         if (msg->operation == AVERAGE) {
-            printf("Returned result %0.3f\n\n", msg->operands[RESULT]);
+            printf("%0.3f", msg->operands[RESULT].f);
+        }
+        else if (msg->operation == MEDIAN && (msg->operands[FLAG_TWO_MEDIAN].i == TWO_MEDIANS)) {
+            printf("two medians ");
+            value_print(stdout, msg->operands[MEDIAN1], type);
+            printf(" ");
+            value_print(stdout, msg->operands[MEDIAN2], type);
+        }
+        else if (msg->operation == DISTINCT) {
+            printf("%0.1f +- %0.1f", msg->operands[RESULT].f, msg->operands[ESTIMATE_ERROR].f);
         }
-        else if (msg->operation == MEDIAN && (msg->operands[FLAG_TWO_MEDIAN] == TWO_MEDIANS)) {
-            printf("Returned result two medians %d %d\n\n", (int)msg->operands[MEDIAN1], (int)msg->operands[MEDIAN2]);
+        else if (msg->operation == TOPK) {
+            value_print(stdout, msg->operands[TOPK_VALUE], type);
+            printf(" x%lld (+%lld)", msg->operands[TOPK_COUNT].i, msg->operands[TOPK_ERROR].i);
+        }
+        else if (msg->operation == VARIANCE || msg->operation == STDDEV || msg->operation == GEOMEAN) {
+            value_print(stdout, msg->operands[RESULT], VALUE_DOUBLE);
+        }
+        else if (msg->operation == COUNT_RANGE || msg->operation == RANK || msg->operation == COUNT) {
+            printf("%lld", msg->operands[RESULT].i);
         }
         else {
-            printf("Returned result %d\n\n", (int)msg->operands[RESULT]);
+            value_print(stdout, msg->operands[RESULT], type);
         }
+        printf("\n\n");
     }
     
     // Update average processing time info.
     chrono_end(chrono); // Stop timer
-    if (msg->operation < 6 && msg->operation >= 0) {
-        total_elapsed[msg->operation] += chrono_elapsed(chrono);
-        msg->elapsed = (double)total_elapsed[msg->operation] /  (double)total_commands[msg->operation]; // Add elapsed
+    msg->elapsed = metrics_record(metrics, op, chrono_elapsed(chrono)); // Add elapsed
+}
+
+/**
+ * @brief Returns whether the operation only reads its dataset,
+ * whatever priority class the client sent the request with.
+ * 
+ * @param[in] op, the operation.
+ * @return true if a read, else false.
+ */
+bool is_read_operation(operation_type op)
+{
+    switch (op) {
+        case AVERAGE: case SUM: case MINIMUM: case MEDIAN: case MAXIMUM:
+        case COUNT: case VARIANCE: case STDDEV: case GEOMEAN:
+        case COUNT_RANGE: case SUM_RANGE: case RANK: case DISTINCT: case TOPK:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * @brief Returns whether two read requests are identical,
+ * so one's result answers both. Only the arguments the
+ * operation uses are compared.
+ * 
+ * @param[in] a, a read request.
+ * @param[in] b, another read request.
+ * @return true if identical, else false.
+ */
+bool is_same_read(const Message* a, const Message* b)
+{
+    if (a->dataset != b->dataset || a->operation != b->operation || a->version != b->version) return false;
+    switch (a->operation) {
+        case COUNT_RANGE: case SUM_RANGE:
+            return a->type == b->type && a->operands[ARGUMENT].i == b->operands[ARGUMENT].i &&
+                a->operands[ARGUMENT_HI].i == b->operands[ARGUMENT_HI].i;
+        case RANK: case TOPK:
+            return a->type == b->type && a->operands[ARGUMENT].i == b->operands[ARGUMENT].i;
+        default:
+            return is_read_operation(a->operation);    // Writes are never answered for another
+    }
+}
+
+/**
+ * @brief Answers a batch of read requests, computing each distinct
+ * read once and copying its result to the identical ones. Every read
+ * in the batch was pending before the first is computed, so no
+ * requester can tell its answer was computed for another.
+ * 
+ * @param[inout] batch, the requests, then the replies.
+ * @param[in] num_requests, the number of requests in the batch.
+ * @param[in] chrono, the calling worker's timer.
+ * @param[in] writable, whether mutations are accepted (else reads only).
+ * @param[in] sizes, the payload bytes received with each request.
+ */
+void coalesce_reads(Message batch[], int num_requests, Chrono* chrono, bool writable, const int sizes[])
+{
+    // Find each read's first identical read before any is overwritten with its reply.
+    // A write drained with the reads (its class is set by the client) is answered in
+    // order, and no read after it is answered with a result computed before it.
+    int leader[COALESCE_MAX];
+    int since = 0;
+    for (int i = 0; i < num_requests; i++) {
+        leader[i] = i;
+        if (!is_read_operation(batch[i].operation)) {
+            since = i + 1;
+            continue;
+        }
+        for (int j = since; j < i && leader[i] == i; j++) {
+            if (leader[j] == j && is_same_read(&batch[i], &batch[j])) leader[i] = j;
+        }
+    }
+
+    int saved = 0;
+    for (int i = 0; i < num_requests; i++) {
+        if (leader[i] == i) {
+            command_controller(&batch[i], chrono, writable, sizes[i]);
+            continue;
+        }
+        operation_type op = batch[i].operation;
+        long reply_type = batch[i].reply_type;
+        batch[i] = batch[leader[i]];
+        batch[i].reply_type = reply_type;
+        batch[i].elapsed = metrics_record(metrics, op, 0);  // Nothing was computed
+        saved++;
+    }
+    if (saved > 0) {
+        printf("Coalesced %d identical reads.\n\n", saved);
+        metrics_record_coalesced(metrics, saved);
     }
 }
 
-int main(void) 
+/**
+ * @brief Worker thread, receives requests, processes them
+ * and replies until the queues are removed. A received read
+ * is batched with the reads of its class already pending, see
+ * coalesce_reads. Workers block every signal, the main thread
+ * handles them.
+ * 
+ * @param[in] arg, the Endpoint to serve.
+ * @return void*, NULL.
+ */
+void* worker(void* arg)
+{
+    const Endpoint* endpoint = (const Endpoint *)arg;
+    Chrono* chrono = chrono_init();   // Used as timer
+    Message batch[COALESCE_MAX];        // Stores the messages to send/receive
+    int sizes[COALESCE_MAX];            // Payload bytes received with each message
+    long int msg_to_receive = -PRIORITY_WRITE;  // Lowest priority class first
+    struct msqid_ds stat;               // Request queue status, for backpressure
+    bool running = true;
+
+    while(running)
+    {
+        sizes[0] = message_queue_receive(endpoint->requests, (void *)&batch[0], msg_to_receive);
+        if (sizes[0] == -1) break;      // Queues removed, shutting down
+        TRACE(calculator, receive, batch[0].operation, sizes[0]);
+
+        // Advertise the backlog, and shed queries and writes while the
+        // queue is nearly full so urgent requests and cheap reads get through.
+        bool overloaded = false;
+        int backlog = 0;
+        if (message_queue_stat(endpoint->requests, &stat) != -1) {
+            backlog = stat.msg_qnum;
+            overloaded = stat.msg_cbytes * 100 > stat.msg_qbytes * SHED_PERCENT;
+        }
+
+        // Reads of the same class were queued before any write the worker
+        // will receive next, drain them so identical ones are computed once.
+        int num_requests = 1;
+        // Whether to drain is decided by the operation, the class is set by the client.
+        bool read = is_read_operation(batch[0].operation);
+        if (overloaded && batch[0].my_msg_type >= PRIORITY_QUERY) {
+            batch[0].operation = BUSY;
+            metrics_record_shed(metrics);
+        } else if (read) {
+            while (num_requests < COALESCE_MAX && (sizes[num_requests] = message_queue_try_receive(endpoint->requests,
+                (void *)&batch[num_requests], batch[0].my_msg_type)) != -1) {
+                TRACE(calculator, receive, batch[num_requests].operation, sizes[num_requests]);
+                num_requests++;
+            }
+            coalesce_reads(batch, num_requests, chrono, endpoint->writable, sizes);
+        } else {
+            command_controller(&batch[0], chrono, endpoint->writable, sizes[0]);
+        }
+        if (batch[0].operation == QUIT) {
+            kill(getpid(), SIGTERM);    // Have the main thread shut everything down
+            break;
+        }
+
+        // Address each reply to its requesting client only.
+        for (int i = 0; i < num_requests && running; i++) {
+            batch[i].backlog = backlog;
+            batch[i].my_msg_type = (batch[i].reply_type > 0) ? batch[i].reply_type : 1;
+            int sent = message_queue_send(endpoint->replies, (void *)&batch[i]);
+            running = sent != -1;
+            if (running) TRACE(calculator, reply, batch[i].operation, sent);
+        }
+    }
+
+    chrono_destroy(chrono);
+    return NULL;
+}
+
+/**
+ * @brief Opens (creating if needed) the request and reply
+ * queues keyed with the specified ftok id.
+ * 
+ * @param[out] endpoint, stores the queue ids.
+ * @param[in] id, the ftok id, REPLICA_QUEUE_ID of the replica (0 for the primary).
+ * @param[in] writable, whether mutations are accepted on these queues.
+ */
+void open_endpoint(Endpoint* endpoint, int id, bool writable)
 {
     // Message Queue Initializers
     char    *client_path = "user.c",
             *server_path = "calculator.c";
-    int id = 'C';
 
     // Keys for message queues
     key_t   client_to_server_key = ftok(client_path, id), 
             server_to_client_key = ftok(server_path, id);
 
-    int client_to_server, server_to_client;     // Message queue IDS
-    Message msg_packet;                         // Stores the message to send/receive
-    msg_packet.my_msg_type = 1;
-    long int msg_to_receive = 0;
-
     // Set up the message queue
-    assert((client_to_server = message_queue_create(client_to_server_key)) != -1);
-    assert((server_to_client = message_queue_create(server_to_client_key)) != -1);
+    assert((endpoint->requests = message_queue_create(client_to_server_key)) != -1);
+    assert((endpoint->replies = message_queue_create(server_to_client_key)) != -1);
+    endpoint->writable = writable;
+}
 
-    printf("Calculator started successfully.\n");
+/**
+ * @brief Starts num_workers workers serving the specified endpoint.
+ * 
+ * @param[in] endpoint, the endpoint, must outlive the workers.
+ */
+void start_workers(Endpoint* endpoint)
+{
+    for (int i = 0; i < num_workers; i++) {
+        assert(pthread_create(&workers[num_running++], NULL, worker, endpoint) == 0);
+    }
+}
 
-    while(true)
-    {
-        assert(message_queue_receive(client_to_server, (void *)&msg_packet, msg_to_receive) != -1);
+/**
+ * @brief Applies a mutation received from the primary,
+ * exactly as the primary applied it, and moves the dataset
+ * to the primary's version so replies agree with the primary's.
+ * 
+ * @param[in] mutation, the mutation.
+ */
+void apply_mutation(const Mutation* mutation)
+{
+    // As on the primary, a delete never brings a dataset into existence.
+    DatasetEntry* entry = datasettable_get(datasets, mutation->dataset, mutation->operation != DELETE);
+    if (entry == NULL) return;
+
+    pthread_mutex_lock(&entry->lock);
+    if (mutation->operation == INSERT) {
+        dataset_insert(entry->dataset, mutation->operands[ARGUMENT]);
+    } else if (mutation->operation == DELETE) {
+        dataset_delete_all(entry->dataset, mutation->operands[ARGUMENT]);
+    } else if (mutation->operation == CREATE && dataset_is_empty(entry->dataset)) {
+        create_dataset(entry, mutation->operands, mutation->type);
+    }
+    entry->version = mutation->version;
+    pthread_mutex_unlock(&entry->lock);
+}
+
+/**
+ * @brief Takes over from the exiting primary: serves its queues,
+ * mutations included, and feeds the replicas above this one.
+ * Called by the replication thread.
+ * 
+ * @param[in] batch, the primary's last batch.
+ */
+void promote(const ReplicationBatch* batch)
+{
+    open_endpoint(&endpoints[1], REPLICA_QUEUE_ID(0), true);
+    if (batch->replicas > replica_id) {
+        replication = replicationlog_create(stream, replica_id + 1, batch->replicas, &batch->defaults);
+    }
+    promoted = true;
+    start_workers(&endpoints[1]);
+    printf("Replica %d promoted to primary.\n\n", replica_id);
+}
+
+/**
+ * @brief Replication thread of a replica, applies the primary's
+ * batches in order until promoted, or cancelled at shutdown.
+ * A missed batch leaves the replica out of sync for good, it then
+ * refuses reads (restart it along with the primary).
+ * 
+ * @param[in] arg, unused.
+ * @return void*, NULL.
+ */
+void* replicate(void* arg)
+{
+    (void)arg;
+    ReplicationBatch batch;
+    pid_t primary = 0;              // Primary the batches come from
+    unsigned long expected = 1;     // Sequence number of the next batch
+    bool handed_over = true;        // Whether the last primary exited, letting a new one take over
+
+    while (replication_receive(stream, &batch, replica_id) != -1) {
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+        if (batch.primary != primary) {
+            if (!handed_over) in_sync = false;
+            primary = batch.primary;
+            expected = 1;
+            handed_over = false;
+            datasettable_set_defaults(datasets, &batch.defaults);
+        }
+        if (batch.sequence != expected && in_sync) {
+            printf("Replica %d missed mutations, refusing reads from now on.\n\n", replica_id);
+            in_sync = false;
+        }
+        expected = batch.sequence + 1;
+
+        if (in_sync) {
+            for (int i = 0; i < batch.size; i++) {
+                apply_mutation(&batch.mutations[i]);
+            }
+            heard_ms = replication_now_ms();
+        }
+        if (batch.last) {
+            handed_over = true;
+            if (batch.promoted == replica_id && in_sync) {
+                promote(&batch);
+                break;
+            }
+        }
+        pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+    }
+    return NULL;
+}
 
-        command_controller(&msg_packet);
-        if (msg_packet.operation == QUIT) break; // Need to quit after processing to cleanup first
+/**
+ * @brief Prints the calculator's usage.
+ * 
+ * @param[in] program, the program name.
+ */
+void usage(const char* program)
+{
+    printf("Usage: %s [-t workers] [-f] [-d lo hi | -L] [-p precision] [-k counters] [-x limit] [-R replicas | -r id [-s ms] | -l snapshot]\n"
+        "  -t workers     worker threads, 1-%d (default %d)\n"
+        "  -f             new datasets hold doubles (default 64-bit integers)\n"
+        "  -d lo hi       store new datasets densely, only integers in [lo, hi] are accepted (up to %ld values)\n"
+        "  -L             store new datasets lazily, O(1) writes, medians computed when read\n"
+        "  -p precision   HyperLogLog precision for Distinct, %d-%d (default %d)\n"
+        "  -k counters    Space Saving counters for TopK (default %d)\n"
+        "  -x limit       distinct values counted exactly before sketching (default %d)\n"
+        "  -R replicas    replicate every mutation to replicas 1..replicas, up to %d\n"
+        "  -r id          run as read-only replica id, fed by the primary\n"
+        "  -s ms          replica: refuse reads once the primary is silent this long (default %d)\n"
+        "  -l snapshot    load the datasets of a BgSave snapshot (not with -R or -r)\n",
+        program, MAX_WORKERS, DEFAULT_WORKERS, MAX_DENSE_RANGE, HLL_MIN_PRECISION, HLL_MAX_PRECISION, DEFAULT_HLL_PRECISION,
+        DEFAULT_TOPK_CAPACITY, DEFAULT_EXACT_LIMIT, MAX_REPLICAS, DEFAULT_STALENESS_MS);
+}
+
+int main(int argc, char* argv[]) 
+{
+    // Parse the options
+    int replicas = 0;
+    const char* load = NULL;
+    DatasetDefaults defaults = { ENGINE_HEAP, VALUE_INT64, 0, 0 };
+    sketchconfig_default(&defaults.sketches);
+    SketchConfig* config = &defaults.sketches;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+            num_workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-f") == 0) {
+            defaults.type = VALUE_DOUBLE;
+        } else if (strcmp(argv[i], "-d") == 0 && i + 2 < argc) {
+            defaults.engine = ENGINE_DENSE; defaults.lo = atoi(argv[++i]); defaults.hi = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-L") == 0) {
+            defaults.engine = ENGINE_LAZY;
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            config->hll_precision = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-k") == 0 && i + 1 < argc) {
+            config->topk_capacity = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-x") == 0 && i + 1 < argc) {
+            config->exact_limit = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-R") == 0 && i + 1 < argc) {
+            replicas = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            replica_id = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            staleness_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            load = argv[++i];
+        } else {
+            usage(argv[0]); exit(EXIT_FAILURE);
+        }
+    }
+    if (num_workers < 1 || num_workers > MAX_WORKERS ||
+        (defaults.engine == ENGINE_DENSE && (defaults.lo > defaults.hi || (long)defaults.hi - defaults.lo >= MAX_DENSE_RANGE ||
+            defaults.type != VALUE_INT64)) ||
+        config->hll_precision < HLL_MIN_PRECISION || config->hll_precision > HLL_MAX_PRECISION ||
+        config->topk_capacity < 1 || config->exact_limit < 0 ||
+        replicas < 0 || replicas > MAX_REPLICAS || replica_id < 0 || replica_id > MAX_REPLICAS ||
+        (replicas > 0 && replica_id > 0) || staleness_ms < 1 ||
+        (load != NULL && (replicas > 0 || replica_id > 0))) {
+        usage(argv[0]); exit(EXIT_FAILURE);
+    }
 
-        assert(message_queue_send(server_to_client, (void *)&msg_packet) != -1);
+    // Set up the datasets and metrics
+    datasets = datasettable_create(&defaults);
+    metrics = metrics_create();
+    if (load != NULL) {
+        int loaded = snapshot_load(datasets, load);
+        if (loaded == -1) {
+            printf("Could not load the snapshot %s.\n", load);
+            exit(EXIT_FAILURE);
+        }
+        printf("Loaded %d datasets from %s.\n", loaded, load);
+    }
+
+    // The primary's queues use ftok id 'C', replica r's 'C' + r. Only the primary accepts mutations.
+    open_endpoint(&endpoints[0], REPLICA_QUEUE_ID(replica_id), replica_id == 0);
+    if (replicas > 0 || replica_id > 0) {
+        assert((stream = message_queue_create(ftok("calculator.c", REPLICATION_QUEUE_ID))) != -1);
+    }
+
+    int qids[] = { endpoints[0].requests, endpoints[0].replies };
+    const char* qnames[] = { "client_to_server", "server_to_client" };
+
+    // Signals are only handled here, synchronously. Blocked before the
+    // workers start so they inherit the mask. SIGUSR1 requests a metrics
+    // snapshot, SIGUSR2 (also sent by the worker that receives BgSave) a
+    // dataset snapshot, whose child exiting raises SIGCHLD. SIGTERM (sent
+    // by the worker that receives Quit) and SIGINT shut down.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+    sigaddset(&signals, SIGUSR2);
+    sigaddset(&signals, SIGCHLD);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGINT);
+    assert(pthread_sigmask(SIG_BLOCK, &signals, NULL) == 0);
+
+    pthread_t replicator;
+    if (replicas > 0) replication = replicationlog_create(stream, 1, replicas, &defaults);
+    if (replica_id > 0) assert(pthread_create(&replicator, NULL, replicate, NULL) == 0);
+    start_workers(&endpoints[0]);
+
+    if (replica_id > 0) {
+        printf("Calculator replica %d started successfully with %d workers.\n", replica_id, num_workers);
+    } else {
+        printf("Calculator started successfully with %d workers and %d replicas.\n", num_workers, replicas);
+    }
+
+    int signum;
+    while (sigwait(&signals, &signum) == 0 && signum != SIGTERM && signum != SIGINT) {
+        if (signum == SIGUSR1) dump_metrics(qids, qnames, 2);
+        else if (signum == SIGUSR2) start_bgsave();
+        else if (signum == SIGCHLD) finish_bgsave(false);
     }
 
     printf("Calculator shutting down.\n");
 
-    // Cleanup message queues.
-    assert(message_queue_delete(server_to_client) != -1);  
-    assert(message_queue_delete(client_to_server) != -1);
+    // Stop replicating first, so a promotion can't race the shutdown.
+    if (replica_id > 0) {
+        pthread_cancel(replicator);
+        pthread_join(replicator, NULL);
+    }
+
+    // Cleanup message queues, this wakes and stops the workers.
+    for (int i = 0; i < (promoted ? 2 : 1); i++) {
+        assert(message_queue_delete(endpoints[i].replies) != -1);  
+        assert(message_queue_delete(endpoints[i].requests) != -1);
+    }
+    for (int i = 0; i < num_running; i++) {
+        pthread_join(workers[i], NULL);
+    }
+
+    // Hand over to a replica. Without one, the last primary removes the stream.
+    int successor = (replication != NULL) ? replicationlog_destroy(replication) : 0;
+    if (successor > 0) {
+        printf("Replica %d takes over.\n", successor);
+    } else if (stream != -1 && (replica_id == 0 || promoted)) {
+        message_queue_delete(stream);
+    }
+
+    finish_bgsave(true);   // Let a running save complete
+    datasettable_destroy(datasets);
+    metrics_destroy(metrics);
     exit(EXIT_SUCCESS);
 }
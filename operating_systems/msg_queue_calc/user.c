@@ -9,12 +9,27 @@
 #include <stdlib.h>
 #include <ctype.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "Message.h"
 #include "MessageQueueWrapper.h"
+#include "ResultCache.h"
+#include "Trace.h"
 
 // All msg packet indexing definitions can be found in Message.h
 
+// A server's request and reply queues, with the keys to find them again
+typedef struct {
+    key_t request_key;
+    key_t reply_key;
+    int requests;   // Request queue id
+    int replies;    // Reply queue id
+} ServerQueues;
+
+static int backlog = 0;     // Requests queued at the server, as of its last reply
+static ResultCache* cache;  // Replies to our reads
+static bool from_cache;     // Whether the last reply came from the cache
+
 /**
  * @brief Returns the operation type
  * associated with the specified command.
@@ -32,26 +47,118 @@ operation_type get_op_type(char command) {
         case 's': return SUM;
         case 'm': return MINIMUM;
         case 'u': return MEDIAN;
+        case 'c': return COUNT_RANGE;
+        case 'r': return SUM_RANGE;
+        case 'k': return RANK;
+        case 'n': return DISTINCT;
+        case 't': return TOPK;
+        case 'x': return MAXIMUM;
+        case 'z': return COUNT;
+        case 'v': return VARIANCE;
+        case 'g': return STDDEV;
+        case 'o': return GEOMEAN;
+        case 'e': return CREATE;
+        case 'b': return BGSAVE;
         case 'q': return QUIT;
         default:  return ERROR;
     }
 }
 
+/**
+ * @brief Reads a number, as an int64 unless it
+ * has a fraction or an exponent.
+ * 
+ * @param[out] value, stores the number.
+ * @param[out] type, stores the number's type.
+ */
+void read_value(Value* value, value_type* type) {
+    char text[64];
+    scanf(" %63s", text);
+    while (!value_parse(text, value, type)) {
+        printf("That's not a number, try again: ");
+        scanf(" %63s", text);
+    }
+}
+
 /**
  * @brief Gets the argument to go along with
  * the specified command.
  * 
  * @param[in] op, the specified operation command.
- * @return int, the argument.
+ * @param[out] msg, stores the argument and its type.
+ */
+void get_arg(const operation_type op, Message* msg) {
+    // Only insert, delete, rank and top-k need an argument, otherwise set it to 0.
+    msg->type = VALUE_INT64;
+    msg->operands[ARGUMENT].i = 0;
+    if (!(op == INSERT || op == DELETE || op == RANK || op == TOPK)) return;
+
+    if (op == TOPK) {
+        printf("Selected TopK(). Insert an *integer* argument: ");
+        scanf(" %lld", &msg->operands[ARGUMENT].i);
+        return;
+    }
+    printf("Selected %s(). Insert a number argument: ", (op == INSERT) ? "Insert" : (op == DELETE) ? "Delete" : "Rank");
+    read_value(&msg->operands[ARGUMENT], &msg->type);
+}
+
+/**
+ * @brief Gets the [lo, hi] bounds to go
+ * along with a range command.
+ * 
+ * @param[in] op, the specified range command.
+ * @param[out] msg, stores the lower and upper bound and their type.
+ */
+void get_range(const operation_type op, Message* msg) {
+    value_type lo_type, hi_type;
+    printf("Selected %s(). Insert number bounds lo hi: ", (op == COUNT_RANGE) ? "CountRange" : "SumRange");
+    read_value(&msg->operands[ARGUMENT], &lo_type);
+    read_value(&msg->operands[ARGUMENT_HI], &hi_type);
+
+    // Both bounds travel as one type, a double if either is.
+    msg->type = (lo_type == VALUE_DOUBLE || hi_type == VALUE_DOUBLE) ? VALUE_DOUBLE : VALUE_INT64;
+    value_convert(&msg->operands[ARGUMENT], lo_type, msg->type);
+    value_convert(&msg->operands[ARGUMENT_HI], hi_type, msg->type);
+}
+
+/**
+ * @brief Gets the engine (and dense range or value
+ * type) to go along with a create command.
+ * 
+ * @param[out] msg, stores the engine, lo, hi and value type.
+ */
+void get_engine(Message* msg) {
+    int engine, type = 0;
+    long long lo = 0, hi = 0;
+    printf("Selected Create(). Insert the engine, 0 (heap), 1 (dense) or 2 (lazy): ");
+    scanf(" %d", &engine);
+    if (engine == 1) {
+        printf("Insert the dense *integer* bounds lo hi: ");
+        scanf(" %lld %lld", &lo, &hi);
+    } else {
+        printf("Insert the value type, 0 (64-bit integers) or 1 (doubles): ");
+        scanf(" %d", &type);
+    }
+    msg->operands[ENGINE_ARGUMENT].i = engine;
+    msg->operands[ENGINE_LO].i = lo;
+    msg->operands[ENGINE_HI].i = hi;
+    msg->type = (type == 1) ? VALUE_DOUBLE : VALUE_INT64;
+}
+
+/**
+ * @brief Returns the dataset id for the specified
+ * dataset name (32-bit FNV-1a). Every client using the
+ * same name operates on the same dataset.
+ * 
+ * @param[in] name, the dataset name.
+ * @return unsigned int, the dataset id.
  */
-int get_arg(const operation_type op) {
-    // Only insert and delete need an argument, otherwise set it to 0.
-    if (!(op == INSERT || op == DELETE)) return 0;
-    printf("Selected %s(). Insert an *integer* argument: ", (op == INSERT) ? "Insert" : "Delete");
-
-    int command;
-    scanf(" %d", &command);
-    return command;
+unsigned int get_dataset_id(const char* name) {
+    unsigned int hash = 2166136261u;
+    for (; *name != '\0'; name++) {
+        hash = (hash ^ (unsigned char)*name) * 16777619u;
+    }
+    return hash;
 }
 
 /**
@@ -64,8 +171,15 @@ int get_arg(const operation_type op) {
 bool format_msg(Message* msg, const char command) {
     msg->operation = get_op_type(command);                // Encode command to operation type.
     if (msg->operation == ERROR) return false;
+    memset(msg->operands, 0, sizeof(msg->operands));     // Unused operands are 0, reads are cached by them.
 
-    msg->operands[ARGUMENT] = get_arg(msg->operation);    // Get the argument for insert/delete.
+    if (msg->operation == CREATE) {
+        get_engine(msg);                                    // Get the engine for create.
+    } else if (msg->operation == COUNT_RANGE || msg->operation == SUM_RANGE) {
+        get_range(msg->operation, msg);                     // Get the bounds for range queries.
+    } else {
+        get_arg(msg->operation, msg);                       // Get the argument for insert/delete/rank.
+    }
     msg->elapsed = 0;   // Some default elapsed time
     return true;
 }
@@ -77,36 +191,192 @@ bool format_msg(Message* msg, const char command) {
  * @param[in] msg, the reply message.
  */
 void process_msg(const Message* msg) {
+    // Server shed the request under load
+    if (msg->operation == BUSY) {
+        printf("[av.elapsed=%0.3fus] Server busy (%d requests queued), the request was not processed! Retry.\n", msg->elapsed, msg->backlog);
+        return;
+    }
     // Server signalled error
     if (msg->operation == ERROR) {
         printf("[av.elapsed=%0.3fus] Server encountered an error processing the request! Retry.\n", msg->elapsed);
         return;
     }
+    if (from_cache) printf("[cached, version=%llu] ", msg->version);
+    else printf("[av.elapsed=%0.3fus] ", msg->elapsed);
     if (msg->operation == MEDIAN) {
         // medians[2] = 1 for 2 medians, 0 for 1 median.
-        if (msg->operands[FLAG_TWO_MEDIAN]) {
-            printf("[av.elapsed=%0.3fus] Server> medians= %d %d.\n", msg->elapsed, (int)msg->operands[MEDIAN1], (int)msg->operands[MEDIAN2]);
+        if (msg->operands[FLAG_TWO_MEDIAN].i) {
+            printf("Server> medians= ");
+            value_print(stdout, msg->operands[MEDIAN1], msg->type);
+            printf(" ");
+            value_print(stdout, msg->operands[MEDIAN2], msg->type);
+            printf(".\n");
+        } else {
+            printf("Server> median= ");
+            value_print(stdout, msg->operands[MEDIAN1], msg->type);
+            printf(".\n");
+        }
+    }
+    else if (msg->operation == DISTINCT) {
+        if (msg->operands[FLAG_EXACT].i) {
+            printf("Server> distinct= %0.0f.\n", msg->operands[RESULT].f);
         } else {
-            printf("[av.elapsed=%0.3fus] Server> median= %d.\n", msg->elapsed, (int)msg->operands[MEDIAN1]);
+            printf("Server> distinct~ %0.0f +- %0.0f.\n", msg->operands[RESULT].f, msg->operands[ESTIMATE_ERROR].f);
         }
     }
+    else if (msg->operation == TOPK) {
+        printf("Server> top= ");
+        value_print(stdout, msg->operands[TOPK_VALUE], msg->type);
+        printf(", count= %lld", msg->operands[TOPK_COUNT].i);
+        msg->operands[TOPK_ERROR].i > 0 ? printf(" (may overcount by %lld).\n", msg->operands[TOPK_ERROR].i) : printf(".\n");
+    }
     else if (msg->operation == AVERAGE) {
-         printf("[av.elapsed=%0.3fus] Server> average= %0.3f.\n", msg->elapsed, msg->operands[RESULT]);
+         printf("Server> average= %0.3f.\n", msg->operands[RESULT].f);
     }
-    else if (msg->operation == SUM || msg->operation == MINIMUM) {
-        char* command = (msg->operation == SUM) ? "sum" : "minimum";
+    else if (msg->operation == VARIANCE || msg->operation == STDDEV || msg->operation == GEOMEAN) {
+        char* command = (msg->operation == VARIANCE) ? "variance" : (msg->operation == STDDEV) ? "stddev" : "geometric mean";
 
-        printf("[av.elapsed=%0.3fus] Server> %s= %d.\n", msg->elapsed, command, (int)msg->operands[RESULT]);
+        printf("Server> %s= ", command);
+        value_print(stdout, msg->operands[RESULT], VALUE_DOUBLE);
+        printf(".\n");
+    }
+    else if (msg->operation == COUNT_RANGE || msg->operation == RANK || msg->operation == COUNT) {
+        char* command = (msg->operation == COUNT_RANGE) ? "count" : (msg->operation == RANK) ? "rank" : "size";
+        printf("Server> %s= %lld.\n", command, msg->operands[RESULT].i);
+    }
+    else if (msg->operation == SUM || msg->operation == MINIMUM || msg->operation == MAXIMUM || msg->operation == SUM_RANGE) {
+        char* command = (msg->operation == SUM) ? "sum" : (msg->operation == MINIMUM) ? "minimum" :
+            (msg->operation == MAXIMUM) ? "maximum" : "range sum";
+
+        printf("Server> %s= ", command);
+        value_print(stdout, msg->operands[RESULT], msg->type);
+        printf(".\n");
+    }
+    else if (msg->operation == BGSAVE) {
+        printf("Server started a background save.\n");
+    }
+    else if (msg->operation == CREATE) {
+        printf("Server created the %s dataset successfully.\n", (msg->type == VALUE_DOUBLE) ? "double" : "integer");
     }
     else {
-        printf("[av.elapsed=%0.3fus] Server %s %d successfully. \n", msg->elapsed, msg->operation == INSERT ? "inserted" : "removed all instances of", (int)msg->operands[ARGUMENT]);
+        printf("Server %s ", msg->operation == INSERT ? "inserted" : "removed all instances of");
+        value_print(stdout, msg->operands[ARGUMENT], msg->type);
+        printf(" successfully. \n");
+    }
+}
+
+/**
+ * @brief Opens the server's queues by their keys, creating
+ * them if the server hasn't yet.
+ * 
+ * @param[inout] server, the queues, their ids are set.
+ */
+void open_queues(ServerQueues* server) {
+    assert((server->requests = message_queue_create(server->request_key)) != -1);
+    assert((server->replies = message_queue_create(server->reply_key)) != -1);
+}
+
+/**
+ * @brief Returns whether the last queue operation failed because
+ * the queue was removed: EIDRM while waiting on it, EINVAL once its
+ * id is stale. A replica taking over from an exiting primary recreates
+ * the primary's queues under the same keys, with new ids.
+ * 
+ * @return true if removed, else false.
+ */
+bool queue_removed() {
+    return errno == EIDRM || errno == EINVAL;
+}
+
+/**
+ * @brief Sends a request at its operation's priority and waits for
+ * the reply (none for Quit). Slows down first while the server's
+ * backlog is high, and gives up rather than block on a full queue.
+ * Reads are answered from the cache while fresh, else sent as
+ * conditional reads of the cached version.
+ *
+ * If the queues are removed (failover), they are opened again by key
+ * and the request is sent again, unless it is a mutation whose reply
+ * was lost: it may have been applied, it is answered with an error.
+ * 
+ * @param[inout] server, the server's queues, reopened after a failover.
+ * @param[inout] msg, the request, then the reply.
+ * @return true if answered, false if the request queue stayed full.
+ */
+bool request(ServerQueues* server, Message* msg) {
+    operation_type op = msg->operation;
+    bool cacheable = resultcache_is_cacheable(op);
+    from_cache = cacheable && resultcache_lookup(cache, msg);
+    if (from_cache) return true;
+    Message sent = *msg;
+    bool mutation = (op == INSERT || op == DELETE || op == CREATE);
+
+    message_queue_throttle(backlog);
+    int received;
+    while (true) {
+        msg->my_msg_type = operation_priority(op);
+        int sent_bytes = message_queue_try_send(server->requests, msg, SEND_TIMEOUT_MS);
+        if (sent_bytes == -1 && queue_removed()) {
+            open_queues(server);
+            continue;
+        }
+        if (sent_bytes == -1) {
+            assert(errno == EAGAIN);
+            return false;
+        }
+        TRACE(calculator_client, send, op, sent_bytes);
+        if (op == QUIT) return true;
+
+        if ((received = message_queue_receive(server->replies, (void *)msg, msg->reply_type)) != -1) break;
+        assert(queue_removed());
+        open_queues(server);
+        *msg = sent;
+        if (mutation) {
+            msg->operation = ERROR;
+            resultcache_clear(cache);
+            return true;
+        }
+    }
+    TRACE(calculator_client, receive, msg->operation, received);
+    backlog = msg->backlog;
+
+    // Our own mutations invalidate every cached result.
+    if (cacheable) resultcache_store(cache, &sent, msg);
+    else if (mutation) resultcache_clear(cache);
+    return true;
+}
+
+/**
+ * @brief Requests the K most frequent values, one rank at a
+ * time, and prints each. Stops early if the server has
+ * fewer than K values.
+ * 
+ * @param[inout] server, the server's queues.
+ * @param[inout] msg, the formatted TopK message, K as the argument.
+ */
+void request_topk(ServerQueues* server, Message* msg) {
+    long long k = msg->operands[ARGUMENT].i;
+    for (long long rank = 1; rank <= k; rank++) {
+        msg->operation = TOPK;
+        msg->operands[ARGUMENT].i = rank;
+        if (!request(server, msg)) {
+            printf("Server busy, its request queue is full! Retry.\n");
+            break;
+        }
+        if (msg->operation == ERROR && rank > 1) break;     // Fewer than K values
+        printf("#%lld ", rank);
+        process_msg(msg);
+        if (msg->operation == ERROR || msg->operation == BUSY) break;
     }
 }
 
 void opening_prompt() {
     printf("Welcome to the user interface.\n" 
         "Please begin by entering a command:\n"
-        "(I)nsert (N)\n(D)elete (N)\n(U)Median\n(M)inimum\n(S)um\n(A)verage\n"
+        "(I)nsert (N)\n(D)elete (N)\n(U)Median\n(M)inimum\nMa(X)imum\n(S)um\n(A)verage\nSi(Z)e\n"
+        "(V)ariance\nSi(G)ma (Std Dev)\nGe(O)metric Mean\n"
+        "(C)ount Range (lo hi)\nSum (R)ange (lo hi)\nRan(K) (N)\nDisti(N)ct\n(T)op K (K)\nCr(E)ate (engine)\n(B)gSave\n"
+        "(Q)uit\n"
     );
 }
 
@@ -129,42 +399,71 @@ void prompt_user(Message* msg) {
     }
 }
 
-int main(void) 
+int main(int argc, char* argv[]) 
 {
-    // Message Queue Initializers
+    // Select the dataset, by name or id, and optionally a replica to read from
+    unsigned int dataset = DEFAULT_DATASET;
+    int replica = 0;
+    long fresh_ms = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            dataset = get_dataset_id(argv[++i]);
+        } else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            dataset = strtoul(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            replica = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc && atol(argv[i + 1]) >= 0) {
+            fresh_ms = atol(argv[++i]);
+        } else {
+            printf("Usage: %s [-n name | -i id] [-r replica] [-c fresh_ms]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Message Queue Initializers, replica r serves reads on the queues keyed with id 'C' + r
     char    *client_path = "user.c",
             *server_path = "calculator.c";
     int id = 'C';
 
-    // Keys for message queues
-    key_t   client_to_server_key = ftok(client_path, id), 
-            server_to_client_key = ftok(server_path, id);
-
+    // Keys for message queues: mutations (and everything without a replica), and reads, the replica's if any
+    ServerQueues primary = { ftok(client_path, id), ftok(server_path, id) },
+                 reads = { ftok(client_path, id + replica), ftok(server_path, id + replica) };
 
-    int client_to_server, server_to_client; // Message queue IDS
     Message msg_packet;                     // Stores the message to send/receive
-    msg_packet.my_msg_type = 1;             
-    long int msg_to_receive = 0;
+    msg_packet.reply_type = getpid();       // Replies to us are typed with our pid
+    msg_packet.dataset = dataset;
+    cache = resultcache_create(fresh_ms);   // Reads may reuse replies up to fresh_ms old
 
     printf("Message Size: %ld\n", sizeof(msg_packet));
+    printf("Dataset: %u\n", dataset);
+    if (replica > 0) printf("Reading from replica %d\n", replica);
 
     // Set up the message queue
-    assert((client_to_server = message_queue_create(client_to_server_key)) != -1);
-    assert((server_to_client = message_queue_create(server_to_client_key)) != -1);
+    open_queues(&primary);
+    open_queues(&reads);
 
     opening_prompt();
     while (true) {
         prompt_user(&msg_packet);
-        
-        assert(message_queue_send(client_to_server, (void *)&msg_packet) != -1);
+        if (msg_packet.operation == TOPK) {
+            request_topk(&reads, &msg_packet);
+            continue;
+        }
 
+        // Replicas are read only, mutations (and Quit) always go to the primary.
+        operation_type op = msg_packet.operation;
+        bool mutation = (op == INSERT || op == DELETE || op == CREATE || op == QUIT);
+        if (!request(mutation ? &primary : &reads, &msg_packet)) {
+            printf("Server busy, its request queue is full! Retry.\n");
+            continue;
+        }
         if (msg_packet.operation == QUIT) break;
-
-        assert(message_queue_receive(server_to_client, (void *)&msg_packet, msg_to_receive) != -1);
         process_msg(&msg_packet);
     }
 
-    printf("Client shutting down.\n");
+    printf("Client shutting down. Cached reads: %ld hits, %ld unchanged, %ld misses.\n",
+        cache->hits, cache->revalidated, cache->misses);
+    resultcache_destroy(cache);
     // Server cleans up the message queues
     exit(EXIT_SUCCESS);
 }